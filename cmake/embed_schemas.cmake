@@ -0,0 +1,44 @@
+# writes the report JSON schemas under SCHEMA_DIR (produced by ./fetch_schemas) into a
+# header of constexpr strings, so full mode validation needs no schema files at run time
+#
+# usage: cmake -DSCHEMA_DIR=<schemas dir> -DOUTPUT=<header> -P embed_schemas.cmake
+
+cmake_minimum_required(VERSION 3.25)
+
+file(GLOB_RECURSE schema_files RELATIVE "${SCHEMA_DIR}" "${SCHEMA_DIR}/*.json")
+list(SORT schema_files)
+
+if(NOT "root.json" IN_LIST schema_files)
+    message(FATAL_ERROR "${SCHEMA_DIR}/root.json not found, run ./fetch_schemas first")
+endif()
+
+set(entries "")
+foreach(name IN LISTS schema_files)
+    file(READ "${SCHEMA_DIR}/${name}" content)
+    string(APPEND entries "\t\t{\"${name}\", R\"qase_schema(${content})qase_schema\"},\n")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp"
+"#pragma once
+
+// generated by cmake/embed_schemas.cmake from schemas/, do not edit
+
+#include <string_view>
+
+namespace qase {
+
+\tstruct QaseEmbeddedSchema {
+\t\t// relative to the schemas directory, e.g. \"models/step.json\"
+\t\tstd::string_view path;
+\t\tstd::string_view json;
+\t};
+
+\tinline constexpr QaseEmbeddedSchema qase_embedded_schemas[] = {
+${entries}\t};
+
+}
+")
+
+# an unchanged header keeps its timestamp, so nothing is rebuilt
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
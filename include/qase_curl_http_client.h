@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "qase_reporter.h"
+
+namespace qase {
+
+	struct QaseCurlOptions {
+		// 0 leaves a timeout off
+		long connect_timeout_ms = 10000;
+		long request_timeout_ms = 60000;
+
+		// connections kept open per host, requests beyond that wait for a free one
+		long max_host_connections = 8;
+
+		// HTTP/2 is negotiated over TLS where the server offers it, and concurrent requests
+		// are multiplexed over one connection; plain http:// stays on HTTP/1.1
+		bool http2 = true;
+	};
+
+	// libcurl event loop shared by any number of clients: one thread drives a multi handle,
+	// so connections (and TLS sessions) are pooled across requests and threads, and requests
+	// of several upload workers share HTTP/2 connections
+	class QaseCurlTransport {
+	public:
+		explicit QaseCurlTransport(QaseCurlOptions options = {});
+		~QaseCurlTransport();
+
+		QaseCurlTransport(const QaseCurlTransport&) = delete;
+		QaseCurlTransport& operator=(const QaseCurlTransport&) = delete;
+
+		// thread-safe, block until the response is in; transport errors and timeouts throw
+		HttpResponse post(const std::string& url, const std::string& body, const std::vector<std::string>& headers);
+		HttpResponse post_stream(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers);
+
+		// connections opened so far, every other request went over a pooled one
+		std::size_t connections_opened() const;
+
+	private:
+		struct Impl;
+		std::unique_ptr<Impl> impl_;
+	};
+
+	// HttpClient over a QaseCurlTransport; for the upload worker pool give every worker
+	// its own client on one transport:
+	//
+	//   auto transport = std::make_shared<qase::QaseCurlTransport>();
+	//   qase::qase_submit_report(api, [transport] {
+	//       return std::make_unique<qase::QaseCurlHttpClient>(transport);
+	//   }, cfg);
+	class QaseCurlHttpClient : public HttpClient {
+	public:
+		explicit QaseCurlHttpClient(QaseCurlOptions options = {});
+		explicit QaseCurlHttpClient(std::shared_ptr<QaseCurlTransport> transport);
+
+		std::string post(const std::string& url, const std::string& body, const std::vector<std::string>& headers) override;
+		std::string post_stream(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers) override;
+		HttpResponse post_with_response(const std::string& url, const std::string& body, const std::vector<std::string>& headers) override;
+		HttpResponse post_stream_with_response(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers) override;
+
+		QaseCurlTransport& transport() { return *transport_; }
+
+	private:
+		std::shared_ptr<QaseCurlTransport> transport_;
+	};
+
+}
@@ -1,21 +1,200 @@
 #pragma once
 
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 #include <vector>
-#include <map>
 
 namespace qase {
 
+	// flat storage for custom result fields
+	// entries are kept sorted by key (same iteration order as std::map) in an inline
+	// buffer, so the usual 2-6 fields cost no node allocations and copy as one block;
+	// keys and values rely on std::string's small-string storage
+	// only results with more than inline_capacity fields spill to the heap
+	class QaseFields {
+	public:
+		using value_type = std::pair<std::string, std::string>;
+		using iterator = value_type*;
+		using const_iterator = const value_type*;
+
+		static constexpr std::size_t inline_capacity = 6;
+
+		QaseFields() = default;
+		QaseFields(std::initializer_list<value_type> init);
+
+		QaseFields(const QaseFields&) = default;
+		QaseFields& operator=(const QaseFields&) = default;
+
+		// the moved-from set is left empty and can be filled again
+		QaseFields(QaseFields&& other) noexcept;
+		QaseFields& operator=(QaseFields&& other) noexcept;
+
+		// inserts an empty value if the key is missing, like std::map::operator[]
+		std::string& operator[](std::string_view key);
+
+		// throws std::out_of_range if the key is missing, like std::map::at
+		std::string& at(std::string_view key);
+		const std::string& at(std::string_view key) const;
+
+		iterator find(std::string_view key);
+		const_iterator find(std::string_view key) const;
+		std::size_t count(std::string_view key) const { return find(key) != end() ? 1 : 0; }
+
+		std::size_t erase(std::string_view key);
+		void clear();
+
+		bool empty() const { return size_ == 0; }
+		std::size_t size() const { return size_; }
+
+		iterator begin() { return data(); }
+		iterator end() { return data() + size_; }
+		const_iterator begin() const { return data(); }
+		const_iterator end() const { return data() + size_; }
+
+		bool operator==(const QaseFields& other) const;
+		bool operator!=(const QaseFields& other) const { return !(*this == other); }
+
+	private:
+		bool spilled() const { return !heap_.empty(); }
+		value_type* data() { return spilled() ? heap_.data() : inline_.data(); }
+		const value_type* data() const { return spilled() ? heap_.data() : inline_.data(); }
+		std::size_t lower_bound(std::string_view key) const;
+
+		std::array<value_type, inline_capacity> inline_;
+		std::vector<value_type> heap_;
+		std::size_t size_ = 0;
+	};
+
 	struct QaseResultMeta {
 		int case_id = 0;
 		std::string title;
-		std::map<std::string, std::string> fields;
+		QaseFields fields;
+
+		// paths of files attached to the result
+		// they are streamed from disk when the report is submitted (not supported on ESP)
+		std::vector<std::string> attachments;
+	};
+
+	// a phase of a test recorded with QASE_STEP
+	// steps are kept flat in the order they started, nesting is given by parent
+	struct QaseStep {
+		std::string name;
+		bool passed = true;
+
+		// index of the enclosing step in TestResult::steps, -1 for top-level steps
+		int parent = -1;
+
+		// wall clock start in milliseconds since the unix epoch, and how long the step took
+		int64_t start_time_ms = 0;
+		int64_t duration_us = 0;
+	};
+
+	// heap use of a test, recorded with QaseConfig::profile_memory (desktop only)
+	struct QaseMemoryProfile {
+		bool recorded = false;
+
+		// operator new calls of the test thread while the test ran and the bytes they asked
+		// for; -1 when the allocation hooks (src/qase_alloc_hooks.cpp) aren't linked
+		int64_t allocations = -1;
+		int64_t bytes = -1;
+
+		// how much the peak resident set of the process grew while the test ran
+		int64_t peak_rss_delta_kb = 0;
 	};
 
 	struct TestResult {
 		std::string name;
 		bool passed;
 		QaseResultMeta meta;
+
+		// stdout/stderr captured while the test ran, see QaseConfig::capture_logs
+		std::string logs;
+
+		// steps recorded while the test ran, empty for tests without steps
+		std::vector<QaseStep> steps;
+
+		// sent as the memory_allocations, memory_bytes and memory_peak_rss_delta_kb
+		// number fields of the result
+		QaseMemoryProfile memory;
+	};
+
+	// results of parameterized tests: a test (name and meta) is stored once, and every
+	// iteration keeps its status and a reference to its parameter set only
+	// parameter sets and their strings are interned, so memory and payload grow with the
+	// distinct parameters rather than with the iterations
+	class QaseParamResults {
+	public:
+		struct Test {
+			std::string name;
+			QaseResultMeta meta;
+		};
+
+		struct Iteration {
+			uint32_t test;
+			uint32_t params;
+			bool passed;
+		};
+
+		// returns the id iterations of the test are recorded with
+		uint32_t define_test(std::string_view name, QaseResultMeta meta = {});
+
+		void add(uint32_t test, bool passed, const QaseFields& params);
+
+		const std::vector<Test>& tests() const { return tests_; }
+		const std::vector<Iteration>& iterations() const { return iterations_; }
+
+		// calls f(key, value) for every parameter of a set, in key order
+		template <typename F>
+		void for_each_param(uint32_t params, F f) const {
+			for (uint32_t i = set_offsets_[params]; i < set_offsets_[params + 1]; i += 2) {
+				f(std::string_view(strings_[set_data_[i]]), std::string_view(strings_[set_data_[i + 1]]));
+			}
+		}
+
+		// distinct parameter sets recorded so far
+		std::size_t param_sets() const { return set_offsets_.size() - 1; }
+
+		// captured logs of an iteration, empty if there are none
+		const std::string& logs(std::size_t iteration) const;
+		void set_logs(std::size_t iteration, std::string logs);
+
+		std::size_t size() const { return iterations_.size(); }
+		bool empty() const { return iterations_.empty(); }
+		void reserve(std::size_t iterations) { iterations_.reserve(iterations); }
+		void clear();
+
+	private:
+		uint32_t intern(std::string_view value);
+		uint32_t intern_params(const QaseFields& params);
+
+		std::vector<Test> tests_;
+		std::vector<Iteration> iterations_;
+
+		// deque keeps the strings in place, the lookup map views them
+		std::deque<std::string> strings_;
+		std::unordered_map<std::string_view, uint32_t> string_ids_;
+
+		// parameter sets as (key id, value id) runs of set_data_, set i is
+		// [set_offsets_[i], set_offsets_[i + 1]); looked up by the hash of the run
+		std::vector<uint32_t> set_data_;
+		std::vector<uint32_t> set_offsets_ = {0};
+		std::unordered_multimap<uint64_t, uint32_t> set_ids_;
+
+		// logs are rare (failed iterations), so they're kept aside
+		std::unordered_map<std::size_t, std::string> logs_;
 	};
 
 	struct QaseConfig {
@@ -30,13 +209,66 @@ namespace qase {
 		std::string root_suite;
 		bool debug = false;
 		bool capture_logs = false;
+
+		// per-test cap for captured logs, only the tail of the output is kept
+		static constexpr std::size_t default_capture_logs_max_bytes = 4096;
+		std::size_t capture_logs_max_bytes = default_capture_logs_max_bytes;
+
+		// keep captured logs of failed tests only, passing tests add nothing to memory or payload
+		bool capture_logs_failed_only = true;
+
+		// record the heap allocations and the peak RSS growth of every test started with
+		// qase_reporter_begin_test (QASE_RUN_TEST) into its result (desktop only)
+		bool profile_memory = false;
+
+		// memory budget of the recorder in bytes, 0 is unlimited (desktop only); past it the
+		// recorded results are spilled to a segment file ("disk") or submitted right away
+		// ("upload", see qase_reporter_set_uploader), and finish sends spilled ones back in order
+		std::size_t recorder_memory_budget = 0;
+		std::string recorder_spill = "disk";
+
+		// segment file of the "disk" mode, a file in the temp directory by default
+		std::string recorder_spill_path;
+
 		std::string report_driver = "local";
 		std::string report_connection_path;
 		std::string connection_format = "json";
+
+		// with the "ndjson" format the report is appended to while the tests run;
+		// buffered lines are written out at least this often
+		static constexpr long default_report_flush_interval_ms = 1000;
+		long report_flush_interval_ms = default_report_flush_interval_ms;
+
 		bool enterprise = false;
 
 		int run_id = 0;
 
+		// delta submission into a long-lived run (run_id set): the file keeps hashes of what
+		// was submitted last time, and only new or changed results are sent
+		std::string delta_state_path;
+
+		// after this many delta submissions the next one sends every result again, 0 never does
+		int delta_resync_every = 0;
+
+		// shard processes with the same key (and host and project) share one run, when
+		// run_id isn't set (desktop only): the first shard to submit starts the run, the others
+		// submit into it, and the last one to finish completes it; shards join in
+		// qase_reporter_configure, so configure every shard before the first one finishes
+		std::string shared_run_key;
+
+		// client-side pacing of Qase API calls, 0 is unlimited
+		double rate_limit_requests_per_sec = 0;
+		double rate_limit_bytes_per_sec = 0;
+
+		// how many times a throttled (429) request is resent before giving up
+		static constexpr int default_rate_limit_max_retries = 5;
+		int rate_limit_max_retries = default_rate_limit_max_retries;
+
+		// test name -> case id cache kept between runs (desktop only): results without
+		// meta.case_id get their id from it, and unknown tests are created as cases
+		// in one call, see qase_reporter_resolve_case_ids
+		std::string case_cache_path;
+
 		std::string run_title;
 		QaseConfig() {
 			std::time_t now = std::time(nullptr);
@@ -50,9 +282,16 @@ namespace qase {
 		}
 
 		std::string run_description = "Unity automated run";
-		int plan_id;
+		int plan_id = 0;
+
+		// create runs with every case of the project instead of only the cases of
+		// the collected results; slow on large projects
+		bool include_all_cases = false;
 		int batch_size = 200;
 
+		// threads sending batches when a client factory is given to qase_submit_report
+		int upload_workers = 1;
+
 		// todo: support this
 		bool defect = false;
 
@@ -64,31 +303,259 @@ namespace qase {
 		std::optional<std::string> file;
 	};
 
-struct HttpClient {
+	// request body that is pulled by the http client chunk by chunk,
+	// so large uploads never have to be held in memory
+	struct HttpBodySource {
+		// total size of the body in bytes, for Content-Length
+		virtual std::size_t size() const = 0;
+
+		// copies up to max bytes of the body into buf, returns 0 when the body is exhausted
+		virtual std::size_t read(char* buf, std::size_t max) = 0;
+
+		// starts the body over so the request can be resent, returns false if it can't
+		virtual bool rewind() { return false; }
+
+		virtual ~HttpBodySource() = default;
+	};
+
+	struct HttpResponse {
+		long status = 200;
+		std::string body;
+
+		// raw response headers, "Name: value"
+		std::vector<std::string> headers;
+	};
+
+	struct HttpClient {
 		virtual std::string post(const std::string& url, const std::string& body, const std::vector<std::string>& headers) = 0;
 
+		// streaming post, used for attachment uploads
+		// the default implementation reads the whole body into memory and calls post(),
+		// override it to send chunks as they are read and keep memory use flat
+		virtual std::string post_stream(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers);
+
+		// posts returning the status and headers as well, QaseApi uses them to notice throttling
+		// the defaults call post() / post_stream() and report 200, override them
+		// so 429 and Retry-After reach the rate limiter
+		virtual HttpResponse post_with_response(const std::string& url, const std::string& body, const std::vector<std::string>& headers);
+		virtual HttpResponse post_stream_with_response(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers);
+
 		virtual ~HttpClient() = default;
 	};
 
-	void qase_reporter_add_result(const std::string& name, bool passed);
-	void qase_reporter_add_result(const std::string& name, bool passed, const QaseResultMeta& meta);
+	// token bucket pacing of Qase API calls, shared by the whole process, see qase_rate_limiter()
+	// limits are in requests and body bytes per second, 0 leaves a limit off;
+	// a bucket holds one second worth of budget, so short bursts go out at once
+	class QaseRateLimiter {
+	public:
+		using clock = std::chrono::steady_clock;
+
+		// changing the limits starts the buckets over
+		void set_limits(double requests_per_sec, double bytes_per_sec);
+
+		// books a request with `bytes` of body and returns when it may be sent
+		clock::time_point reserve(std::size_t bytes, clock::time_point now);
+
+		// books a request and sleeps until it may be sent
+		void acquire(std::size_t bytes);
+
+		// the server throttled a request: nothing is sent before `until`,
+		// and the request rate is halved (down to 1/16 of the limit)
+		void throttled(clock::time_point until);
+
+		// a request went through, a backed off request rate recovers step by step
+		void succeeded();
+
+	private:
+		static constexpr double min_backoff = 1.0 / 16;
+
+		std::mutex mutex_;
+		double requests_per_sec_ = 0;
+		double bytes_per_sec_ = 0;
+		double backoff_ = 1.0;
+
+		// theoretical arrival times of the next request in each bucket (GCRA)
+		clock::time_point requests_tat_{};
+		clock::time_point bytes_tat_{};
+		clock::time_point paused_until_{};
+	};
+
+	QaseRateLimiter& qase_rate_limiter();
+
+	// results are constructed in place in the recorder: the name is copied exactly once
+	// and an rvalue meta is moved in, so recording a test costs no redundant copies
+	void qase_reporter_add_result(std::string_view name, bool passed);
+	void qase_reporter_add_result(std::string_view name, bool passed, const QaseResultMeta& meta);
+	void qase_reporter_add_result(std::string_view name, bool passed, QaseResultMeta&& meta);
+	// with recorder.memoryBudget set, only the results still in memory; the ones over the
+	// budget are visited with qase_reporter_for_each_result
 	const std::vector<TestResult>& qase_reporter_get_results();
 
+	// visits every recorded result in order, those spilled to disk read back a budget's worth at a time
+	void qase_reporter_for_each_result(const std::function<void(const TestResult&)>& visit);
+
+	// parameterized tests: define the test once, then record each iteration with its params
+	// (QASE_RUN_PARAM_TEST does it for Unity); iterations are submitted with the other results
+	uint32_t qase_reporter_define_test(std::string_view name, QaseResultMeta meta = {});
+	void qase_reporter_add_param_result(uint32_t test, bool passed, const QaseFields& params);
+	const QaseParamResults& qase_reporter_get_param_results();
+
+	// preallocates storage for the expected number of results
+	void qase_reporter_reserve(std::size_t count);
+
+	// ========= TEST REGISTRY =======
+	// tests registered with QASE_TEST are kept in a table, so a runner can pick their order;
+	// qase_run_registered_tests runs the likely failures first: the tests that failed last
+	// time, then new ones, then the rest, quickest first, recording results as QASE_RUN_TEST does
+	// with workers > 1 (desktop only) the tests run in forked worker processes: a test that
+	// crashes its worker fails on its own, and the results are recorded in registration order
+
+	struct QaseRegisteredTest {
+		std::string name;
+		void (*func)();
+		QaseResultMeta meta;
+	};
+
+	// returns true, so QASE_TEST can register at namespace scope, during static initialization
+	bool qase_register_test(std::string_view name, void (*func)(), QaseResultMeta meta = {});
+	const std::vector<QaseRegisteredTest>& qase_registered_tests();
+
+	// runs one test and returns whether it passed, see QASE_RUN_REGISTERED_TESTS for Unity
+	using QaseTestInvoker = std::function<bool(const QaseRegisteredTest&)>;
+
+	struct QaseTestRunOptions {
+		// outcome and duration of every test of the last run (desktop only); without it
+		// tests run in registration order
+		std::string history_path;
+
+		// stop once this many tests failed, 0 runs them all
+		int max_failures = 0;
+
+		// processes the tests are spread over; 1 runs them in this process, one after another
+		int workers = 1;
+
+		// shared memory the workers hand their results back through; a result that doesn't
+		// fit keeps only its name, outcome and meta
+		std::size_t result_region_size = 64 * 1024 * 1024;
+	};
+
+	struct QaseTestRunSummary {
+		int run = 0;
+		int failed = 0;
+	};
+
+	QaseTestRunSummary qase_run_registered_tests(const QaseTestInvoker& invoke, const QaseTestRunOptions& options = {});
+
+	// applies runtime options of the recorder (log capture, etc.)
+	// call it once with the resolved config before running the tests
+	// with connection_format "ndjson" (full mode) the local report is opened here and every
+	// recorded result is appended to it right away; in "report" mode the results are not
+	// kept in memory then, so a run of any length needs the same memory
+	void qase_reporter_configure(const QaseConfig& cfg);
+
+	// marks the start of a test, QASE_RUN_TEST calls it right before RUN_TEST
+	// the next qase_reporter_add_result call closes the test
+	// the name is only used by the crash journal, for the result of a test that never closed
+	void qase_reporter_begin_test(std::string_view name = {});
+
+#ifndef ESP_PLATFORM
+	// heap allocation counters of the calling thread, for QaseConfig::profile_memory
+	// only the replacement operator new of src/qase_alloc_hooks.cpp adds to them: link it
+	// into the test binary (the qase_reporter_alloc_hooks CMake target) to count allocations
+	struct QaseAllocCounters {
+		uint64_t allocations = 0;
+		uint64_t bytes = 0;
+	};
+	QaseAllocCounters& qase_alloc_counters() noexcept;
+
+	// called by src/qase_alloc_hooks.cpp when it's linked in
+	void qase_alloc_hooks_register() noexcept;
+	bool qase_alloc_hooks_registered() noexcept;
+#endif
+
+	// log capture sink: appends bytes to the log buffer of the running test
+	// on desktop stdout/stderr are redirected here automatically;
+	// on ESP there's no redirection, hook this into your log output instead
+	// (e.g. from a vprintf handler installed with esp_log_set_vprintf)
+	void qase_log_capture_write(const char* data, std::size_t size);
+
 	void qase_reporter_reset();
 
-	std::string qase_serialize_results(const std::vector<TestResult>& results);
+	// step recording, use QASE_STEP instead of calling these directly
+	// steps go to a buffer that is allocated on first use and reused by every test,
+	// and are attached to the next recorded result; steps still open at that point
+	// (a Unity assertion jumped out of them) are recorded as failed
+	// steps are recorded from the thread running the test
+	int qase_step_begin(std::string_view name);
+	void qase_step_end(int step, bool passed);
+
+	// times a step for the lifetime of the scope
+	// the step fails if the scope is left by an exception or fail() was called
+	class QaseStepScope {
+	public:
+		explicit QaseStepScope(std::string_view name)
+			: step_(qase_step_begin(name)), exceptions_(std::uncaught_exceptions()) {}
+
+		~QaseStepScope() {
+			qase_step_end(step_, !failed_ && std::uncaught_exceptions() == exceptions_);
+		}
+
+		QaseStepScope(const QaseStepScope&) = delete;
+		QaseStepScope& operator=(const QaseStepScope&) = delete;
+
+		void fail() { failed_ = true; }
+
+	private:
+		int step_;
+		int exceptions_;
+		bool failed_ = false;
+	};
+
+	// 64-bit content hash (XXH64), used to recognise identical content
+	uint64_t qase_hash64(const void* data, std::size_t size, uint64_t seed = 0);
+
+#ifndef ESP_PLATFORM
+	// hashes a file through a memory mapping, without reading it into memory
+	uint64_t qase_hash_file(const std::string& path);
+#endif
+
+	// attachment path -> hash returned by Qase when the file was uploaded
+	using QaseAttachmentHashes = std::unordered_map<std::string, std::string>;
+
+	// attachments are referenced by their uploaded hashes, attachments missing from the map are skipped
+	std::string qase_serialize_results(const std::vector<TestResult>& results, const QaseAttachmentHashes* attachment_hashes = nullptr);
+
+	// iterations become results with a "param" object; the case title and fields of a test
+	// are sent with its first iteration in the payload only
+	std::string qase_serialize_param_results(const QaseParamResults& results);
 
 	struct IQaseApi {
-		virtual uint64_t qase_start_run(HttpClient&, const QaseConfig&) = 0;
+		// case_ids are the Qase cases the run is created with (see QaseConfig::include_all_cases),
+		// results for other cases are added to the run as they are submitted
+		virtual uint64_t qase_start_run(HttpClient&, const QaseConfig&, const std::vector<int>& case_ids = {}) = 0;
 		virtual bool qase_submit_results(HttpClient&, const QaseConfig&, uint64_t, const std::string&) = 0;
 		virtual bool qase_complete_run(HttpClient&, const QaseConfig&, uint64_t) = 0;
+#ifndef ESP_PLATFORM
+		// uploads a file and returns its Qase hash
+		// the default throws std::runtime_error, an api without it can't submit attachments
+		virtual std::string qase_upload_attachment(HttpClient&, const QaseConfig&, const std::string& path);
+
+		// creates cases with the given titles in one call, returns their ids in the same order
+		// the default throws std::runtime_error, an api without it can't create cases for
+		// QaseConfig::case_cache_path
+		virtual std::vector<int> qase_create_cases(HttpClient&, const QaseConfig&, const std::vector<std::string>& titles);
+#endif
 		virtual ~IQaseApi() = default;
 	};
 
 	struct QaseApi : public IQaseApi {
-		uint64_t qase_start_run(HttpClient&, const QaseConfig& cfg) override;
+		uint64_t qase_start_run(HttpClient&, const QaseConfig& cfg, const std::vector<int>& case_ids = {}) override;
 		bool qase_submit_results(HttpClient&, const QaseConfig&, uint64_t, const std::string&) override;
 		bool qase_complete_run(HttpClient&, const QaseConfig&, uint64_t) override;
+#ifndef ESP_PLATFORM
+		std::string qase_upload_attachment(HttpClient&, const QaseConfig&, const std::string& path) override;
+		std::vector<int> qase_create_cases(HttpClient&, const QaseConfig&, const std::vector<std::string>& titles) override;
+#endif
 	};
 
 	void qase_submit_report(
@@ -97,6 +564,30 @@ struct HttpClient {
 			const QaseConfig& cfg
 		);
 
+	// creates one client per upload worker, see QaseConfig::upload_workers
+	using HttpClientFactory = std::function<std::unique_ptr<HttpClient>()>;
+
+	// same flow, with the batches sent by up to cfg.upload_workers threads, each with
+	// its own client; the run is completed only once every batch was acknowledged,
+	// and failed batches are reported together in one std::runtime_error
+	void qase_submit_report(
+			IQaseApi& api,
+			const HttpClientFactory& make_client,
+			const QaseConfig& cfg
+		);
+
+#ifndef ESP_PLATFORM
+	// client of the "upload" spill mode (QaseConfig::recorder_spill): results over the memory
+	// budget are submitted through it while the tests run, into a run started on the first flush
+	// if a flush fails, its results are spilled to disk instead and sent again at finish
+	void qase_reporter_set_uploader(IQaseApi& api, HttpClient& http);
+
+	// gives every recorded result without meta.case_id the id cached for its name in
+	// cfg.case_cache_path, creating cases for unknown tests; qase_reporter_finish calls it
+	// before submitting, call it before qase_submit_report when submitting directly
+	void qase_reporter_resolve_case_ids(IQaseApi& api, HttpClient& http, const QaseConfig& cfg);
+#endif
+
 	QaseConfig resolve_config(const ConfigResolutionInput& input);
 
 	struct IQaseApiAdapter {
@@ -112,6 +603,182 @@ struct HttpClient {
 	};
 	#endif
 
+	// ========= SERIAL RESULT PROTOCOL =======
+	// for devices without network during tests: results are streamed as compact binary
+	// frames over a serial link, and a host-side collector submits them to Qase
+	//
+	// every frame is COBS-encoded and terminated by 0x00, so the host can resync
+	// on any delimiter; the payload is [type][body][crc8]
+	// integers are LEB128 varints, strings are interned: sent once as a STRING frame,
+	// then referenced by a small id
+
+	enum class QaseSerialFrame : uint8_t {
+		run_begin = 0x01, // [version]
+		string = 0x02,    // [id][length][bytes]
+		result = 0x03,    // [flags][name id][case id?][title id?][field count?][key id, value id]...
+		run_end = 0x04,   // [result count]
+		log_chunk = 0x05  // [length][bytes], logs of the result that follows
+	};
+
+	// destination of the encoded stream: UART, USB CDC, a pipe...
+	struct QaseByteSink {
+		virtual void write(const uint8_t* data, std::size_t size) = 0;
+		virtual ~QaseByteSink() = default;
+	};
+
+	// device-side encoder, never allocates: frames are built in fixed member buffers
+	// strings longer than a frame are truncated, and at most max_fields fields are sent per result
+	class QaseSerialEncoder {
+	public:
+		static constexpr uint8_t version = 1;
+		static constexpr std::size_t max_payload = 250;
+		static constexpr std::size_t max_string = max_payload - 12;
+		static constexpr std::size_t intern_capacity = 64;
+		static constexpr std::size_t max_fields = 30;
+
+		explicit QaseSerialEncoder(QaseByteSink& sink) : sink_(sink) {}
+
+		void begin_run();
+		void write_result(const TestResult& result);
+		// a result without meta, for callers that have no TestResult at hand (a signal handler)
+		void write_result(std::string_view name, bool passed, std::string_view logs = {});
+		void end_run();
+
+	private:
+		uint32_t intern(std::string_view str);
+		void write_logs(std::string_view logs);
+		void emit(std::size_t payload_size);
+
+		QaseByteSink& sink_;
+
+		// interned strings, the slot index is the string id; the hash finds a candidate,
+		// the bytes confirm it
+		uint64_t interned_[intern_capacity] = {};
+		uint8_t interned_size_[intern_capacity] = {};
+		char interned_data_[intern_capacity][max_string];
+		std::size_t interned_count_ = 0;
+		std::size_t next_slot_ = 0;
+		uint32_t result_count_ = 0;
+
+		// slots the result being written refers to, never reused before its frame is out
+		uint64_t pinned_ = 0;
+		static_assert(intern_capacity <= 64 && 2 + 2 * max_fields < intern_capacity,
+			"every string of one result has to stay interned until its frame is written");
+
+		uint8_t payload_[max_payload];
+		uint8_t encoded_[max_payload + max_payload / 254 + 2];
+	};
+
+	// streams results over the sink as one run
+	void qase_serial_emit_results(QaseByteSink& sink, const std::vector<TestResult>& results);
+
+	// streams every recorded result over the sink as one run, spilled ones included
+	void qase_serial_emit_recorded(QaseByteSink& sink);
+
+	// device-side adapter for QASE_UNITY_END-style wiring: api and http are not used,
+	// the results go to the sink instead
+	struct QaseSerialAdapter : public IQaseApiAdapter {
+		explicit QaseSerialAdapter(QaseByteSink& sink) : sink(sink) {}
+		void submit_report(IQaseApi& api, HttpClient& http, const QaseConfig& cfg) override;
+
+		QaseByteSink& sink;
+	};
+
+#ifndef ESP_PLATFORM
+	// host-side decoder, feed it raw bytes as they arrive
+	// damaged frames are counted and skipped up to the next delimiter
+	class QaseSerialDecoder {
+	public:
+		void feed(const uint8_t* data, std::size_t size);
+
+		// moves decoded results to the end of out
+		void take_results(std::vector<TestResult>& out);
+
+		bool run_ended() const { return run_ended_; }
+		std::size_t corrupt_frames() const { return corrupt_frames_; }
+
+		// results the device reported in run_end but that never arrived
+		std::size_t lost_results() const { return lost_results_; }
+
+	private:
+		void decode_frame();
+		bool dispatch(const uint8_t* payload, std::size_t size);
+
+		std::vector<uint8_t> frame_;
+		bool frame_overflow_ = false;
+		std::vector<std::string> strings_;
+		std::string pending_logs_;
+		std::vector<TestResult> results_;
+		std::size_t decoded_count_ = 0;
+		bool run_ended_ = false;
+		std::size_t corrupt_frames_ = 0;
+		std::size_t lost_results_ = 0;
+	};
+
+	// reads the serial stream from fd until run_end or EOF, and submits the results
+	// through the api in batches of cfg.batch_size while they arrive
+	// the run is started on the first batch (unless cfg.run_id is set) and completed
+	// at the end if cfg.run_complete says so
+	void qase_serial_collect(int fd, IQaseApi& api, HttpClient& http, const QaseConfig& cfg);
+
+	// ========= CRASH JOURNAL =======
+	// once installed, every recorded result is also encoded as serial protocol frames into
+	// a buffer allocated up front; on SIGSEGV, SIGBUS, SIGILL, SIGFPE or SIGABRT the handler
+	// adds a failed result for the running test and writes the buffer to `path` using
+	// async-signal-safe calls only, then lets the signal take the process down as before
+	// results that no longer fit into `capacity` bytes and parameterized iterations are not journaled
+	void qase_crash_handler_install(const std::string& path, std::size_t capacity = 1024 * 1024);
+	void qase_crash_handler_uninstall();
+
+	// submits the results of a journal left behind by a crashed process and removes it,
+	// returns false if there was none; call it before installing the handler for the new run
+	// (the journal is a serial stream, so tools/qase_serial_collector can submit it as well)
+	bool qase_crash_recover(const std::string& path, IQaseApi& api, HttpClient& http, const QaseConfig& cfg);
+
+	// ========= RESULT OBSERVERS =======
+	// live feed of recorded results for dashboards and custom sinks: every plain result is
+	// copied into a bounded lock-free queue and delivered to the observers by a consumer thread
+	// the test thread never waits for an observer; when the queue is full the result is
+	// dropped for the observers (the recorder still keeps it) and counted
+	// parameterized iterations are not published
+
+	// called on the consumer thread, one result at a time; exceptions are counted and ignored
+	using QaseResultObserver = std::function<void(const TestResult&)>;
+
+	struct QaseObserverStats {
+		uint64_t published = 0; // queued for the observers
+		uint64_t delivered = 0; // handed to the observers
+		uint64_t dropped = 0;   // lost to a full queue
+		uint64_t failed = 0;    // observer calls that threw
+	};
+
+	// starts the consumer thread with room for `capacity` results in flight (rounded up to
+	// a power of two); call it, and stop, from the thread that records the results
+	void qase_observers_start(std::size_t capacity = 4096);
+
+	// delivers what's queued, then stops the consumer thread; subscriptions stay
+	void qase_observers_stop();
+
+	// blocks until everything published so far was delivered, qase_reporter_finish calls it
+	void qase_observers_flush();
+
+	// starts the consumer thread with the default capacity if it isn't running (safely against
+	// a concurrent qase_observers_start); returns the id to unsubscribe with
+	int qase_observer_subscribe(QaseResultObserver observer);
+
+	// once it returns the observer is never called again, so whatever it captured can go;
+	// it waits for a delivery in progress, so don't call it holding a lock an observer takes
+	// called from an observer it can't wait: it returns at once, and the result being
+	// delivered still reaches the other observers subscribed when its delivery began
+	void qase_observer_unsubscribe(int id);
+
+	QaseObserverStats qase_observer_stats();
+
+	// observer writing each result to fd (a file, pipe or socket) as one line of JSON,
+	// the result entry as sent to the API
+	QaseResultObserver qase_fd_observer(int fd);
+#endif
+
 
 #ifndef ESP_PLATFORM
 	QaseConfig load_qase_config_from_file(const std::string& path);
@@ -121,7 +788,14 @@ struct HttpClient {
 
 	QaseConfig load_qase_config_from_env(const std::string& prefix);
 
-	void qase_save_report(const std::vector<TestResult>& results, const std::string& path);
+	// writes the local report; format is "json" (pretty-printed), "ndjson" (one entry per line),
+	// or "cbor" / "msgpack" for compact archives, where entries are encoded into the file one by one
+	void qase_save_report(const std::vector<TestResult>& results, const std::string& path,
+		const std::string& format = "json");
+
+	// reads a report saved in any of the formats above and writes it back as the JSON report
+	// a cut off last line of an ndjson report (interrupted run) is skipped
+	void qase_convert_report(const std::string& source, const std::string& destination);
 
 	void qase_reporter_finish(HttpClient& http, const QaseConfig& cfg);
 
@@ -129,6 +803,12 @@ struct HttpClient {
 
 
 
+// records the rest of the enclosing scope as a step of the running test:
+// { QASE_STEP("Connect to the access point"); ... }
+#define QASE_STEP_CONCAT_(a, b) a##b
+#define QASE_STEP_SCOPE_(line) QASE_STEP_CONCAT_(qase_step_scope_, line)
+#define QASE_STEP(name) qase::QaseStepScope QASE_STEP_SCOPE_(__LINE__)(name)
+
 // this macro wrapper needs to be used to run each test instead of unity's UNITY_BEGIN
 // so that the tests start from clean state
 #define QASE_UNITY_BEGIN() \
@@ -137,24 +817,72 @@ struct HttpClient {
 
 // this macros will be chosen for QASE_RUN_TEST(func)
 #define QASE_RUN_TEST_SIMPLE(test_func) \
+	qase::qase_reporter_begin_test(#test_func); \
 	RUN_TEST(test_func); \
 	qase::qase_reporter_add_result(#test_func, Unity.TestFailures == Unity.CurrentTestFailed);
 
 // this macros will be chosen for QASE_RUN_TEST(func, meta)
+// NOTE: meta is moved into the recorder, don't reuse it after the macro
 #define QASE_RUN_TEST_META(test_func, meta) \
+	qase::qase_reporter_begin_test(#test_func); \
 	RUN_TEST(test_func); \
-	qase::qase_reporter_add_result(#test_func, Unity.TestFailures == Unity.CurrentTestFailed, meta);
+	qase::qase_reporter_add_result(#test_func, Unity.TestFailures == Unity.CurrentTestFailed, std::move(meta));
+
+// runs one iteration of a parameterized test, `test` comes from qase_reporter_define_test
+// and the params are a QaseFields, e.g. {{"baud", "115200"}, {"parity", "even"}}; they're
+// taken as variadic arguments, as the preprocessor splits braced lists at their commas
+#define QASE_RUN_PARAM_TEST(test, test_func, ...) \
+	qase::qase_reporter_begin_test(#test_func); \
+	RUN_TEST(test_func); \
+	qase::qase_reporter_add_param_result(test, Unity.TestFailures == Unity.CurrentTestFailed, __VA_ARGS__);
 
 #define GET_QASE_RUN_TEST_MACRO(_1, _2, NAME, ...) NAME
 #define QASE_RUN_TEST(...) \
     GET_QASE_RUN_TEST_MACRO(__VA_ARGS__, QASE_RUN_TEST_META, QASE_RUN_TEST_SIMPLE)(__VA_ARGS__)
 
+// registers a test at namespace scope, after the test function is declared:
+// QASE_TEST(test_wifi_connects) or QASE_TEST(test_wifi_connects, meta)
+#define QASE_TEST_SIMPLE(test_func) \
+	static const bool QASE_STEP_CONCAT_(qase_registered_, test_func) = \
+		qase::qase_register_test(#test_func, test_func)
+
+#define QASE_TEST_META(test_func, meta) \
+	static const bool QASE_STEP_CONCAT_(qase_registered_, test_func) = \
+		qase::qase_register_test(#test_func, test_func, meta)
+
+#define QASE_TEST(...) \
+    GET_QASE_RUN_TEST_MACRO(__VA_ARGS__, QASE_TEST_META, QASE_TEST_SIMPLE)(__VA_ARGS__)
+
+// runs the registered tests through Unity in failure-first order, between
+// QASE_UNITY_BEGIN and QASE_UNITY_END; options is a qase::QaseTestRunOptions
+// tests run by worker processes are added to the Unity counters of this one
+#define QASE_RUN_REGISTERED_TESTS(options) \
+	{ \
+		const auto qase_tests_before_ = Unity.NumberOfTests; \
+		const qase::QaseTestRunSummary qase_summary_ = \
+			qase::qase_run_registered_tests([](const qase::QaseRegisteredTest& test) { \
+				const auto failures = Unity.TestFailures; \
+				UnityDefaultTestRun(test.func, test.name.c_str(), __LINE__); \
+				return Unity.TestFailures == failures; \
+			}, options); \
+		if (Unity.NumberOfTests == qase_tests_before_) { \
+			Unity.NumberOfTests += qase_summary_.run; \
+			Unity.TestFailures += qase_summary_.failed; \
+		} \
+	}
+
 // this macro wrapper needs to be used after all the tests completion instead of unity's UNITY_END
 // so that collected test results are sent to Qase API
 #define QASE_UNITY_END(http_client, cfg) \
 	UNITY_END(); \
 	qase::qase_reporter_finish(http_client, cfg);
 
+// same as QASE_UNITY_END, for devices without network: the results are streamed
+// over the serial sink and submitted by the host-side collector
+#define QASE_UNITY_END_SERIAL(sink) \
+	UNITY_END(); \
+	qase::qase_serial_emit_recorded(sink);
+
 /*
  *  usage examples:
  *
@@ -1,38 +1,51 @@
 #include "json_schema_validator.h"
+#include "qase_embedded_schemas.h"
 #include <nlohmann/json-schema.hpp>
-#include <fstream>
-#include <iostream>
+#include <stdexcept>
+#include <string>
 
 using nlohmann::json;
 using nlohmann::json_schema::json_validator;
 
 namespace qase {
 
-	void validate_json_payload(const json& payload) {
-		static json schema;
-
-		if (schema.empty()) {
+	// schemas are compiled into the library (cmake/embed_schemas.cmake), so validation
+	// doesn't depend on the working directory or on any file at run time
 
-			std::ifstream schema_file("schemas/root.json");
-			if (!schema_file) {
-				throw std::runtime_error("Could not open schema file");
+	// embedded schema a reference points to: "step.json", "models/step.json" and
+	// "/some/base/models/step.json" all match models/step.json
+	static std::string_view find_embedded_schema(std::string_view path) {
+		for (const auto& schema : qase_embedded_schemas) {
+			if (path.size() < schema.path.size() ||
+					path.substr(path.size() - schema.path.size()) != schema.path) {
+				continue;
 			}
-
-			try {
-				schema_file >> schema;
-			} catch (const std::exception& e) {
-				throw;
+			if (path.size() == schema.path.size() || path[path.size() - schema.path.size() - 1] == '/') {
+				return schema.json;
 			}
 		}
+		return {};
+	}
 
-		static json_validator validator;
-		validator.set_root_schema(schema); // safe to call multiple times, but expensive — we cache
+	// the root schema is parsed and compiled once, referenced schemas as they're resolved
+	static json_validator make_validator() {
+		json_validator validator([](const nlohmann::json_uri& uri, json& schema) {
+			const std::string_view text = find_embedded_schema(uri.path());
+			if (text.empty()) {
+				throw std::runtime_error("Schema is not embedded: " + uri.path());
+			}
+			schema = json::parse(text);
+		});
+		validator.set_root_schema(json::parse(find_embedded_schema("root.json")));
+		return validator;
+	}
 
-		try {
-			validator.validate(payload);
-		} catch (const std::exception& e) {
-			throw;  // rethrow so test fails
-		}
+	void validate_json_payload(const json& payload) {
+		// validation is const, so one compiled validator serves every call and thread
+		static const json_validator validator = make_validator();
+
+		// throws on the first violation, so the test fails
+		validator.validate(payload);
 	}
 
 }
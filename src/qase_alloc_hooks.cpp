@@ -0,0 +1,110 @@
+// replaceable global allocation functions that count every heap allocation of a thread
+// into qase_alloc_counters(), for QaseConfig::profile_memory
+// link this into the test binary (the qase_reporter_alloc_hooks CMake target), never into
+// a library: replacing operator new is up to the program
+
+#include "qase_reporter.h"
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+	void* counted_alloc(std::size_t size) {
+		qase::QaseAllocCounters& counters = qase::qase_alloc_counters();
+		++counters.allocations;
+		counters.bytes += size;
+		if (void* p = std::malloc(size ? size : 1)) {
+			return p;
+		}
+		throw std::bad_alloc();
+	}
+
+	void* counted_aligned_alloc(std::size_t size, std::align_val_t align) {
+		qase::QaseAllocCounters& counters = qase::qase_alloc_counters();
+		++counters.allocations;
+		counters.bytes += size;
+
+		// aligned_alloc wants the size to be a multiple of the alignment
+		const std::size_t alignment = static_cast<std::size_t>(align);
+		const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+		if (void* p = std::aligned_alloc(alignment, rounded ? rounded : alignment)) {
+			return p;
+		}
+		throw std::bad_alloc();
+	}
+
+	const bool registered = (qase::qase_alloc_hooks_register(), true);
+
+}
+
+void* operator new(std::size_t size) {
+	return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size) {
+	return counted_alloc(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return counted_alloc(size);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return counted_alloc(size);
+	} catch (const std::bad_alloc&) {
+		return nullptr;
+	}
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+	return counted_aligned_alloc(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+	return counted_aligned_alloc(size, align);
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+[[gnu::noinline]] void operator delete[](void* p) noexcept {
+	std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+[[gnu::noinline]] void operator delete[](void* p, std::size_t) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+	std::free(p);
+}
@@ -0,0 +1,296 @@
+#include "qase_curl_http_client.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <curl/curl.h>
+
+namespace qase {
+
+	// one request on its way through the event loop, lives on the caller's stack
+	struct CurlTransfer {
+		CURL* easy = nullptr;
+		struct curl_slist* headers = nullptr;
+		HttpBodySource* source = nullptr;
+		HttpResponse response;
+		CURLcode result = CURLE_OK;
+		bool done = false;
+		char error[CURL_ERROR_SIZE] = {};
+	};
+
+	struct QaseCurlTransport::Impl {
+		QaseCurlOptions options;
+		CURLM* multi = nullptr;
+		std::thread loop;
+
+		std::mutex mutex;
+		std::condition_variable done;
+		std::vector<CurlTransfer*> pending;
+		std::vector<CURL*> idle;
+		bool stopping = false;
+
+		std::atomic<std::size_t> connections{0};
+
+		void run();
+		CURL* acquire_handle();
+		void release_handle(CURL* easy);
+		HttpResponse perform(CurlTransfer& transfer, const std::string& url, const std::vector<std::string>& headers);
+	};
+
+	static std::size_t append_body(char* data, std::size_t size, std::size_t n, void* out) {
+		static_cast<std::string*>(out)->append(data, size * n);
+		return size * n;
+	}
+
+	// keeps "Name: value" lines of the final response, Retry-After is read from them
+	static std::size_t append_header(char* data, std::size_t size, std::size_t n, void* out) {
+		auto& headers = *static_cast<std::vector<std::string>*>(out);
+		std::string line(data, size * n);
+		while (!line.empty() && (line.back() == '\r' || line.back() == '\n')) {
+			line.pop_back();
+		}
+		// a status line starts the headers over: 100 Continue, redirects
+		if (line.compare(0, 5, "HTTP/") == 0) {
+			headers.clear();
+		} else if (line.find(':') != std::string::npos) {
+			headers.push_back(std::move(line));
+		}
+		return size * n;
+	}
+
+	static std::size_t read_source(char* buf, std::size_t size, std::size_t n, void* source) {
+		try {
+			return static_cast<HttpBodySource*>(source)->read(buf, size * n);
+		} catch (...) {
+			return CURL_READFUNC_ABORT;
+		}
+	}
+
+	// libcurl seeks back when it has to resend the body, e.g. on a reused connection that was closed
+	static int seek_source(void* source, curl_off_t offset, int origin) {
+		if (offset != 0 || origin != SEEK_SET) {
+			return CURL_SEEKFUNC_CANTSEEK;
+		}
+		return static_cast<HttpBodySource*>(source)->rewind() ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_CANTSEEK;
+	}
+
+	void QaseCurlTransport::Impl::run() {
+		std::vector<CurlTransfer*> adding;
+		int running = 0;
+
+		for (;;) {
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				if (stopping && pending.empty() && running == 0) {
+					break;
+				}
+				adding.swap(pending);
+			}
+			for (CurlTransfer* transfer : adding) {
+				// a transfer that can't be added is done right away, its caller would wait forever
+				const CURLMcode added = curl_multi_add_handle(multi, transfer->easy);
+				if (added != CURLM_OK) {
+					std::snprintf(transfer->error, sizeof(transfer->error), "%s", curl_multi_strerror(added));
+					std::lock_guard<std::mutex> lock(mutex);
+					transfer->result = CURLE_FAILED_INIT;
+					transfer->done = true;
+					done.notify_all();
+				}
+			}
+			adding.clear();
+
+			curl_multi_perform(multi, &running);
+
+			int queued = 0;
+			while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+				if (msg->msg != CURLMSG_DONE) {
+					continue;
+				}
+				CURL* easy = msg->easy_handle;
+				const CURLcode result = msg->data.result;
+
+				CurlTransfer* transfer = nullptr;
+				curl_easy_getinfo(easy, CURLINFO_PRIVATE, &transfer);
+				curl_multi_remove_handle(multi, easy);
+
+				std::lock_guard<std::mutex> lock(mutex);
+				transfer->result = result;
+				transfer->done = true;
+				done.notify_all();
+			}
+
+			// new requests wake the loop up with curl_multi_wakeup
+			curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+		}
+	}
+
+	// easy handles are reused, so are their DNS cache entries and buffers
+	CURL* QaseCurlTransport::Impl::acquire_handle() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!idle.empty()) {
+				CURL* easy = idle.back();
+				idle.pop_back();
+				curl_easy_reset(easy);
+				return easy;
+			}
+		}
+		CURL* easy = curl_easy_init();
+		if (!easy) {
+			throw std::runtime_error("HTTP request failed: could not create a curl handle");
+		}
+		return easy;
+	}
+
+	void QaseCurlTransport::Impl::release_handle(CURL* easy) {
+		std::lock_guard<std::mutex> lock(mutex);
+		idle.push_back(easy);
+	}
+
+	HttpResponse QaseCurlTransport::Impl::perform(CurlTransfer& transfer, const std::string& url,
+			const std::vector<std::string>& headers) {
+		CURL* easy = transfer.easy;
+
+		for (const auto& header : headers) {
+			transfer.headers = curl_slist_append(transfer.headers, header.c_str());
+		}
+		// no 100-continue round trip before large bodies
+		transfer.headers = curl_slist_append(transfer.headers, "Expect:");
+
+		curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+		curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer.headers);
+		curl_easy_setopt(easy, CURLOPT_PRIVATE, &transfer);
+		curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer.error);
+		curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+		curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+		curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT_MS, options.connect_timeout_ms);
+		curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, options.request_timeout_ms);
+		curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, append_body);
+		curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer.response.body);
+		curl_easy_setopt(easy, CURLOPT_HEADERFUNCTION, append_header);
+		curl_easy_setopt(easy, CURLOPT_HEADERDATA, &transfer.response.headers);
+		if (options.http2) {
+			curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));
+			// wait for a connection that can multiplex instead of opening another one
+			curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+		} else {
+			curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_1_1));
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (stopping) {
+				curl_slist_free_all(transfer.headers);
+				idle.push_back(easy);
+				throw std::runtime_error("HTTP request failed: transport is shut down");
+			}
+			pending.push_back(&transfer);
+		}
+		curl_multi_wakeup(multi);
+
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			done.wait(lock, [&] { return transfer.done; });
+		}
+
+		curl_slist_free_all(transfer.headers);
+		long new_connections = 0;
+		curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &new_connections);
+		connections += static_cast<std::size_t>(new_connections);
+		curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &transfer.response.status);
+		release_handle(easy);
+
+		if (transfer.result != CURLE_OK) {
+			throw std::runtime_error(std::string("HTTP request failed: ") +
+				(transfer.error[0] ? transfer.error : curl_easy_strerror(transfer.result)));
+		}
+		return std::move(transfer.response);
+	}
+
+	QaseCurlTransport::QaseCurlTransport(QaseCurlOptions options) : impl_(new Impl) {
+		static std::once_flag curl_initialized;
+		std::call_once(curl_initialized, [] { curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+		impl_->options = options;
+		impl_->multi = curl_multi_init();
+		if (!impl_->multi) {
+			throw std::runtime_error("Could not create a curl multi handle");
+		}
+		curl_multi_setopt(impl_->multi, CURLMOPT_PIPELINING,
+			options.http2 ? static_cast<long>(CURLPIPE_MULTIPLEX) : static_cast<long>(CURLPIPE_NOTHING));
+		curl_multi_setopt(impl_->multi, CURLMOPT_MAX_HOST_CONNECTIONS, options.max_host_connections);
+
+		impl_->loop = std::thread([impl = impl_.get()] { impl->run(); });
+	}
+
+	QaseCurlTransport::~QaseCurlTransport() {
+		{
+			std::lock_guard<std::mutex> lock(impl_->mutex);
+			impl_->stopping = true;
+		}
+		curl_multi_wakeup(impl_->multi);
+		impl_->loop.join();
+
+		for (CURL* easy : impl_->idle) {
+			curl_easy_cleanup(easy);
+		}
+		curl_multi_cleanup(impl_->multi);
+	}
+
+	HttpResponse QaseCurlTransport::post(const std::string& url, const std::string& body,
+			const std::vector<std::string>& headers) {
+		CurlTransfer transfer;
+		transfer.easy = impl_->acquire_handle();
+		curl_easy_setopt(transfer.easy, CURLOPT_POSTFIELDS, body.data());
+		curl_easy_setopt(transfer.easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+		return impl_->perform(transfer, url, headers);
+	}
+
+	HttpResponse QaseCurlTransport::post_stream(const std::string& url, HttpBodySource& body,
+			const std::vector<std::string>& headers) {
+		CurlTransfer transfer;
+		transfer.easy = impl_->acquire_handle();
+		transfer.source = &body;
+		curl_easy_setopt(transfer.easy, CURLOPT_POST, 1L);
+		curl_easy_setopt(transfer.easy, CURLOPT_READFUNCTION, read_source);
+		curl_easy_setopt(transfer.easy, CURLOPT_READDATA, &body);
+		curl_easy_setopt(transfer.easy, CURLOPT_SEEKFUNCTION, seek_source);
+		curl_easy_setopt(transfer.easy, CURLOPT_SEEKDATA, &body);
+		curl_easy_setopt(transfer.easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+		return impl_->perform(transfer, url, headers);
+	}
+
+	std::size_t QaseCurlTransport::connections_opened() const {
+		return impl_->connections.load();
+	}
+
+	QaseCurlHttpClient::QaseCurlHttpClient(QaseCurlOptions options)
+		: transport_(std::make_shared<QaseCurlTransport>(options)) {}
+
+	QaseCurlHttpClient::QaseCurlHttpClient(std::shared_ptr<QaseCurlTransport> transport)
+		: transport_(std::move(transport)) {}
+
+	std::string QaseCurlHttpClient::post(const std::string& url, const std::string& body,
+			const std::vector<std::string>& headers) {
+		return transport_->post(url, body, headers).body;
+	}
+
+	std::string QaseCurlHttpClient::post_stream(const std::string& url, HttpBodySource& body,
+			const std::vector<std::string>& headers) {
+		return transport_->post_stream(url, body, headers).body;
+	}
+
+	HttpResponse QaseCurlHttpClient::post_with_response(const std::string& url, const std::string& body,
+			const std::vector<std::string>& headers) {
+		return transport_->post(url, body, headers);
+	}
+
+	HttpResponse QaseCurlHttpClient::post_stream_with_response(const std::string& url, HttpBodySource& body,
+			const std::vector<std::string>& headers) {
+		return transport_->post_stream(url, body, headers);
+	}
+
+}
@@ -1,11 +1,47 @@
 #include <nlohmann/json.hpp>
 #include "qase_reporter.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <map>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_set>
 #ifndef ESP_PLATFORM
 // fstream is used only in config file reader
 // and config file reader is not supported on ESP32
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+
+// stdout/stderr redirection for log capture
+#include <cerrno>
+#include <unistd.h>
+
+// memory-mapped attachment uploads
+#include <fcntl.h>
+#include <random>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+// crash journal
+#include <csignal>
+#include <optional>
+
+// log capture drain, parallel test workers
+#include <climits>
+#include <poll.h>
+#include <sys/wait.h>
 #endif
 
 using json = nlohmann::json;
@@ -13,6 +49,7 @@ using json = nlohmann::json;
 namespace qase {
 
 	static std::vector<TestResult> collected;
+	static QaseParamResults collected_params;
 
 	void check_qase_api_error(const nlohmann::json& json)
 	{
@@ -27,171 +64,4382 @@ namespace qase {
 		}
 	}
 
-	void qase_reporter_add_result(const std::string& name, bool passed) {
-		QaseResultMeta meta;
-		qase_reporter_add_result(name, passed, meta);
+	// ========= CONTENT HASHING =======
+
+	// streaming XXH64; inputs are read in host byte order (all supported targets are little-endian)
+	class Xxh64 {
+	public:
+		explicit Xxh64(uint64_t seed) : seed_(seed) {
+			acc_[0] = seed + prime1 + prime2;
+			acc_[1] = seed + prime2;
+			acc_[2] = seed;
+			acc_[3] = seed - prime1;
+		}
+
+		void update(const unsigned char* data, std::size_t size) {
+			total_ += size;
+
+			if (buffered_ + size < sizeof(buf_)) {
+				std::memcpy(buf_ + buffered_, data, size);
+				buffered_ += size;
+				return;
+			}
+
+			if (buffered_ > 0) {
+				const std::size_t fill = sizeof(buf_) - buffered_;
+				std::memcpy(buf_ + buffered_, data, fill);
+				consume_stripe(buf_);
+				data += fill;
+				size -= fill;
+				buffered_ = 0;
+			}
+
+			while (size >= sizeof(buf_)) {
+				consume_stripe(data);
+				data += sizeof(buf_);
+				size -= sizeof(buf_);
+			}
+
+			std::memcpy(buf_, data, size);
+			buffered_ = size;
+		}
+
+		uint64_t digest() const {
+			uint64_t h;
+			if (total_ >= sizeof(buf_)) {
+				h = rotl(acc_[0], 1) + rotl(acc_[1], 7) + rotl(acc_[2], 12) + rotl(acc_[3], 18);
+				for (uint64_t acc : acc_) {
+					h ^= round(0, acc);
+					h = h * prime1 + prime4;
+				}
+			} else {
+				h = seed_ + prime5;
+			}
+			h += total_;
+
+			const unsigned char* p = buf_;
+			std::size_t left = buffered_;
+			for (; left >= 8; p += 8, left -= 8) {
+				h ^= round(0, read64(p));
+				h = rotl(h, 27) * prime1 + prime4;
+			}
+			if (left >= 4) {
+				h ^= static_cast<uint64_t>(read32(p)) * prime1;
+				h = rotl(h, 23) * prime2 + prime3;
+				p += 4;
+				left -= 4;
+			}
+			for (; left > 0; ++p, --left) {
+				h ^= *p * prime5;
+				h = rotl(h, 11) * prime1;
+			}
+
+			h ^= h >> 33;
+			h *= prime2;
+			h ^= h >> 29;
+			h *= prime3;
+			h ^= h >> 32;
+			return h;
+		}
+
+	private:
+		static constexpr uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+		static constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+		static constexpr uint64_t prime3 = 0x165667B19E3779F9ULL;
+		static constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63ULL;
+		static constexpr uint64_t prime5 = 0x27D4EB2F165667C5ULL;
+
+		static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+		static uint64_t round(uint64_t acc, uint64_t input) { return rotl(acc + input * prime2, 31) * prime1; }
+		static uint64_t read64(const unsigned char* p) { uint64_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+		static uint32_t read32(const unsigned char* p) { uint32_t v; std::memcpy(&v, p, sizeof(v)); return v; }
+
+		void consume_stripe(const unsigned char* p) {
+			for (int i = 0; i < 4; ++i) {
+				acc_[i] = round(acc_[i], read64(p + i * 8));
+			}
+		}
+
+		uint64_t seed_;
+		uint64_t acc_[4];
+		unsigned char buf_[32];
+		std::size_t buffered_ = 0;
+		uint64_t total_ = 0;
+	};
+
+	uint64_t qase_hash64(const void* data, std::size_t size, uint64_t seed) {
+		Xxh64 hasher(seed);
+		hasher.update(static_cast<const unsigned char*>(data), size);
+		return hasher.digest();
 	}
 
-	void qase_reporter_add_result(const std::string& name, bool passed, const QaseResultMeta& meta) {
-		if (name.empty()) {
-			throw std::invalid_argument("Test name must not be empty");
+	// ========= QaseFields: sorted flat storage for custom fields =======
+	QaseFields::QaseFields(std::initializer_list<value_type> init) {
+		for (const auto& kv : init) {
+			(*this)[kv.first] = kv.second;
 		}
-		collected.push_back(TestResult{name, passed, meta});
 	}
 
-	const std::vector<TestResult>& qase_reporter_get_results() {
-		return collected;
+	QaseFields::QaseFields(QaseFields&& other) noexcept
+		: inline_(std::move(other.inline_)), heap_(std::move(other.heap_)), size_(other.size_) {
+		other.heap_.clear();
+		other.size_ = 0;
 	}
 
-	void qase_reporter_reset() {
-		collected.clear();
+	QaseFields& QaseFields::operator=(QaseFields&& other) noexcept {
+		if (this != &other) {
+			inline_ = std::move(other.inline_);
+			heap_ = std::move(other.heap_);
+			size_ = other.size_;
+			other.heap_.clear();
+			other.size_ = 0;
+		}
+		return *this;
 	}
 
-	std::string qase_serialize_results(const std::vector<TestResult>& collected) {
-		json root;
-		root["results"] = json::array();
+	// index of the first entry whose key is not less than the given key
+	std::size_t QaseFields::lower_bound(std::string_view key) const {
+		const value_type* first = data();
+		std::size_t lo = 0;
+		std::size_t hi = size_;
+		while (lo < hi) {
+			std::size_t mid = lo + (hi - lo) / 2;
+			if (std::string_view(first[mid].first) < key) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo;
+	}
 
-		for (const auto& result : collected) {
-			json entry;
-			json case_json;
+	std::string& QaseFields::operator[](std::string_view key) {
+		std::size_t pos = lower_bound(key);
+		if (pos < size_ && data()[pos].first == key) {
+			return data()[pos].second;
+		}
 
-			// use title from meta if provided, else - result.name
-			if (!result.meta.title.empty()) {
-				case_json["title"] = result.meta.title;
-			} else {
-				case_json["title"] = result.name;
+		if (spilled()) {
+			heap_.emplace(heap_.begin() + pos, std::string(key), std::string());
+			++size_;
+			return heap_[pos].second;
+		}
+
+		if (size_ == inline_capacity) {
+			// inline buffer is full, move everything to the heap once
+			heap_.reserve(inline_capacity * 2);
+			for (std::size_t i = 0; i < size_; ++i) {
+				heap_.push_back(std::move(inline_[i]));
+				inline_[i].first.clear();
+				inline_[i].second.clear();
 			}
+			heap_.emplace(heap_.begin() + pos, std::string(key), std::string());
+			++size_;
+			return heap_[pos].second;
+		}
 
-			// add case_id if set
-			if (result.meta.case_id > 0) {
-				case_json["case_id"] = result.meta.case_id;
+		std::move_backward(inline_.begin() + pos, inline_.begin() + size_, inline_.begin() + size_ + 1);
+		inline_[pos].first.assign(key.data(), key.size());
+		inline_[pos].second.clear();
+		++size_;
+		return inline_[pos].second;
+	}
+
+	QaseFields::iterator QaseFields::find(std::string_view key) {
+		std::size_t pos = lower_bound(key);
+		if (pos < size_ && data()[pos].first == key) {
+			return data() + pos;
+		}
+		return end();
+	}
+
+	QaseFields::const_iterator QaseFields::find(std::string_view key) const {
+		std::size_t pos = lower_bound(key);
+		if (pos < size_ && data()[pos].first == key) {
+			return data() + pos;
+		}
+		return end();
+	}
+
+	std::string& QaseFields::at(std::string_view key) {
+		auto it = find(key);
+		if (it == end()) {
+			throw std::out_of_range("QaseFields: no field named " + std::string(key));
+		}
+		return it->second;
+	}
+
+	const std::string& QaseFields::at(std::string_view key) const {
+		auto it = find(key);
+		if (it == end()) {
+			throw std::out_of_range("QaseFields: no field named " + std::string(key));
+		}
+		return it->second;
+	}
+
+	std::size_t QaseFields::erase(std::string_view key) {
+		auto it = find(key);
+		if (it == end()) {
+			return 0;
+		}
+
+		std::size_t pos = it - begin();
+		if (spilled()) {
+			heap_.erase(heap_.begin() + pos);
+		} else {
+			std::move(inline_.begin() + pos + 1, inline_.begin() + size_, inline_.begin() + pos);
+			inline_[size_ - 1].first.clear();
+			inline_[size_ - 1].second.clear();
+		}
+		--size_;
+		return 1;
+	}
+
+	void QaseFields::clear() {
+		for (std::size_t i = 0; i < inline_.size(); ++i) {
+			inline_[i].first.clear();
+			inline_[i].second.clear();
+		}
+		heap_.clear();
+		size_ = 0;
+	}
+
+	bool QaseFields::operator==(const QaseFields& other) const {
+		return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+	}
+
+	// ========= PER-TEST LOG CAPTURE =======
+
+	// fixed-size ring buffer: keeps the tail of the output, the oldest bytes are dropped
+	class LogRing {
+	public:
+		void reset(std::size_t capacity) {
+			buf_.assign(capacity, '\0');
+			clear();
+		}
+
+		void clear() {
+			head_ = 0;
+			total_ = 0;
+		}
+
+		void write(const char* data, std::size_t size) {
+			total_ += size;
+
+			const std::size_t cap = buf_.size();
+			if (cap == 0 || size == 0) {
+				return;
+			}
+			if (size > cap) {
+				data += size - cap;
+				size = cap;
+			}
+
+			const std::size_t first = std::min(size, cap - head_);
+			std::memcpy(buf_.data() + head_, data, first);
+			std::memcpy(buf_.data(), data + first, size - first);
+			head_ = (head_ + size) % cap;
+		}
+
+		std::string str() const {
+			const std::size_t cap = buf_.size();
+			if (total_ <= cap) {
+				// not wrapped yet, data starts at 0
+				return std::string(buf_.data(), total_);
 			}
 
-			// add custom fields if present
-			for (const auto& kv : result.meta.fields) {
-				case_json[kv.first] = kv.second;
+			std::string out = "[" + std::to_string(total_ - cap) + " bytes truncated]\n";
+			out.append(buf_.data() + head_, cap - head_);
+			out.append(buf_.data(), head_);
+			return out;
+		}
+
+	private:
+		std::vector<char> buf_;
+		std::size_t head_ = 0;
+		std::size_t total_ = 0;
+	};
+
+#ifndef ESP_PLATFORM
+	static void shutdown_stream_capture();
+#endif
+
+	struct LogCaptureState {
+		bool enabled = false;
+		bool failed_only = true;
+		bool active = false;
+
+		// guards the ring: on desktop it's written from the drain thread
+		std::mutex mutex;
+		LogRing ring;
+
+#ifndef ESP_PLATFORM
+		// one pipe and one drain thread serve the whole run; stdout and stderr only point
+		// to the pipe while a test runs
+		int read_fd = -1;
+		int write_fd = -1;
+		int saved_stdout = -1;
+		int saved_stderr = -1;
+		bool redirected = false;
+		std::thread drain;
+
+		// a test ends with a sync request through the control pipe: the drain thread
+		// empties the log pipe into the ring, then bumps `synced`
+		int control_read = -1;
+		int control_write = -1;
+		uint64_t sync_requested = 0;
+		uint64_t synced = 0;
+		std::condition_variable synced_cv;
+
+		~LogCaptureState() { shutdown_stream_capture(); }
+#endif
+	};
+
+	static LogCaptureState log_capture;
+
+	void qase_log_capture_write(const char* data, std::size_t size) {
+		std::lock_guard<std::mutex> lock(log_capture.mutex);
+		if (log_capture.active) {
+			log_capture.ring.write(data, size);
+		}
+	}
+
+#ifndef ESP_PLATFORM
+	// drain thread: moves the log pipe into the ring and passes the output through to the
+	// original stdout; the passthrough waits for the fd to be writable and goes in pieces of
+	// at most PIPE_BUF bytes, so a slow stdout delays the passthrough, never the test
+	static void drain_log_pipe(int read_fd, int control_fd, int passthrough_fd) {
+		std::string pending;
+		bool open = true;
+
+		// reads whatever the pipe holds right now
+		auto read_available = [&]() {
+			char chunk[4096];
+			for (;;) {
+				ssize_t n = read(read_fd, chunk, sizeof(chunk));
+				if (n > 0) {
+					qase_log_capture_write(chunk, static_cast<std::size_t>(n));
+					pending.append(chunk, static_cast<std::size_t>(n));
+				} else if (n < 0 && errno == EINTR) {
+					continue;
+				} else {
+					// EOF once every write end is closed, EAGAIN once the pipe is empty
+					open = open && n < 0;
+					return;
+				}
 			}
+		};
 
-			entry["case"] = case_json;
-			entry["status"] = result.passed ? "passed" : "failed";
+		while (open) {
+			pollfd fds[3] = {
+				{read_fd, POLLIN, 0},
+				{control_fd, POLLIN, 0},
+				{passthrough_fd, static_cast<short>(pending.empty() ? 0 : POLLOUT), 0},
+			};
+			if (poll(fds, 3, -1) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				break;
+			}
 
-			root["results"].push_back(entry);
+			if (fds[0].revents) {
+				read_available();
+			}
+			if (fds[1].revents) {
+				char requests[64];
+				ssize_t n = read(control_fd, requests, sizeof(requests));
+				if (n > 0) {
+					// everything written before the request is in the pipe by now
+					read_available();
+					std::lock_guard<std::mutex> lock(log_capture.mutex);
+					log_capture.synced += static_cast<uint64_t>(n);
+					log_capture.synced_cv.notify_all();
+				}
+			}
+			if (fds[2].revents & POLLOUT) {
+				ssize_t n = write(passthrough_fd, pending.data(), std::min<std::size_t>(pending.size(), PIPE_BUF));
+				if (n > 0) {
+					pending.erase(0, static_cast<std::size_t>(n));
+				} else if (n < 0 && errno != EINTR && errno != EAGAIN) {
+					pending.clear();
+				}
+			} else if (fds[2].revents) {
+				// stdout is gone, keep capturing
+				pending.clear();
+			}
 		}
 
-		return root.dump();
+		// the run is over: the rest of the output may take as long as it takes
+		std::size_t written = 0;
+		while (written < pending.size()) {
+			ssize_t n = write(passthrough_fd, pending.data() + written, pending.size() - written);
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				break;
+			}
+			written += static_cast<std::size_t>(n);
+		}
 	}
 
-	// helper: builds vector of headers for the specified token
-	std::vector<std::string> make_headers(const std::string& token) {
-		return {
-			"accept: application/json",
-			"content-type: application/json",
-			"Token: " + token
+	// opens the pipes and starts the drain thread, false if the pipes can't be set up
+	static bool start_log_drain() {
+		int fds[2];
+		int control[2];
+		if (pipe(fds) != 0) {
+			return false;
+		}
+		if (pipe(control) != 0) {
+			close(fds[0]);
+			close(fds[1]);
+			return false;
+		}
+
+		// the drain empties the pipe up to EAGAIN on a sync request
+		fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+		log_capture.read_fd = fds[0];
+		log_capture.write_fd = fds[1];
+		log_capture.control_read = control[0];
+		log_capture.control_write = control[1];
+		log_capture.saved_stdout = dup(STDOUT_FILENO);
+		log_capture.saved_stderr = dup(STDERR_FILENO);
+		log_capture.drain = std::thread(drain_log_pipe, fds[0], control[0], log_capture.saved_stdout);
+		return true;
+	}
+
+	// points stdout and stderr to the log pipe, starting the drain thread on the first test
+	// capture is best effort: if the pipe can't be set up, the test just runs uncaptured
+	static void start_stream_capture() {
+		std::cout.flush();
+		std::fflush(stdout);
+		std::fflush(stderr);
+
+		if (log_capture.read_fd < 0 && !start_log_drain()) {
+			return;
+		}
+		dup2(log_capture.write_fd, STDOUT_FILENO);
+		dup2(log_capture.write_fd, STDERR_FILENO);
+		log_capture.redirected = true;
+	}
+
+	// restores stdout/stderr and waits until the drain thread has put everything the test
+	// printed into the ring
+	static void stop_stream_capture() {
+		if (!log_capture.redirected) {
+			return;
+		}
+
+		std::cout.flush();
+		std::fflush(stdout);
+		std::fflush(stderr);
+
+		dup2(log_capture.saved_stdout, STDOUT_FILENO);
+		dup2(log_capture.saved_stderr, STDERR_FILENO);
+		log_capture.redirected = false;
+
+		std::unique_lock<std::mutex> lock(log_capture.mutex);
+		const uint64_t request = ++log_capture.sync_requested;
+		const char byte = 's';
+		while (write(log_capture.control_write, &byte, 1) < 0 && errno == EINTR) {
+		}
+		log_capture.synced_cv.wait(lock, [request]() { return log_capture.synced >= request; });
+	}
+
+	// ends the run's capture: closing the last write end lets the drain thread read up to EOF
+	static void shutdown_stream_capture() {
+		stop_stream_capture();
+		if (log_capture.read_fd < 0) {
+			return;
+		}
+
+		close(log_capture.write_fd);
+		log_capture.drain.join();
+
+		for (int fd : {log_capture.read_fd, log_capture.control_read, log_capture.control_write,
+				log_capture.saved_stdout, log_capture.saved_stderr}) {
+			close(fd);
+		}
+		log_capture.read_fd = -1;
+		log_capture.write_fd = -1;
+		log_capture.control_read = -1;
+		log_capture.control_write = -1;
+		log_capture.saved_stdout = -1;
+		log_capture.saved_stderr = -1;
+	}
+#endif
+
+	// stops an ongoing capture and returns what it collected
+	static std::string stop_log_capture() {
+		if (!log_capture.active) {
+			return std::string();
+		}
+
+#ifndef ESP_PLATFORM
+		stop_stream_capture();
+#endif
+
+		std::lock_guard<std::mutex> lock(log_capture.mutex);
+		log_capture.active = false;
+		return log_capture.ring.str();
+	}
+
+	#ifndef ESP_PLATFORM
+	// ========= DELTA SUBMISSION =======
+
+	static void hash_string(Xxh64& hash, std::string_view value) {
+		const uint64_t size = value.size();
+		hash.update(reinterpret_cast<const unsigned char*>(&size), sizeof(size));
+		hash.update(reinterpret_cast<const unsigned char*>(value.data()), value.size());
+	}
+
+	// which test a result belongs to
+	static uint64_t result_identity(const TestResult& result) {
+		Xxh64 hash(0);
+		hash.update(reinterpret_cast<const unsigned char*>(&result.meta.case_id), sizeof(result.meta.case_id));
+		hash_string(hash, result.name);
+		return hash.digest();
+	}
+
+	// what the result says: status, title, fields, attachments and step outcomes
+	// logs and timings are left out, they differ on every run
+	static uint64_t result_content(const TestResult& result) {
+		Xxh64 hash(0);
+		const unsigned char passed = result.passed ? 1 : 0;
+		hash.update(&passed, 1);
+		hash_string(hash, result.meta.title);
+		for (const auto& [key, value] : result.meta.fields) {
+			hash_string(hash, key);
+			hash_string(hash, value);
+		}
+		for (const auto& path : result.meta.attachments) {
+			hash_string(hash, path);
+		}
+		for (const auto& step : result.steps) {
+			const unsigned char step_passed = step.passed ? 1 : 0;
+			hash_string(hash, step.name);
+			hash.update(&step_passed, 1);
+			hash.update(reinterpret_cast<const unsigned char*>(&step.parent), sizeof(step.parent));
+		}
+		return hash.digest();
+	}
+
+	// decides which results go into a long-lived run (cfg.run_id) by comparing them
+	// with what was submitted last time, see QaseConfig::delta_state_path
+	// the state file is: magic, version, run id, delta submissions since the last
+	// full one, entry count, then (identity, content) hash pairs sorted by identity
+	class DeltaSubmission {
+	public:
+		explicit DeltaSubmission(const QaseConfig& cfg)
+			: path_(cfg.delta_state_path), run_id_(static_cast<uint64_t>(cfg.run_id)) {
+			enabled_ = !path_.empty() && run_id_ != 0;
+			if (!enabled_) {
+				return;
+			}
+
+			// a missing, damaged or foreign state file means everything is sent
+			full_ = !load() || (cfg.delta_resync_every > 0 && deltas_since_full_ >= static_cast<uint32_t>(cfg.delta_resync_every));
+		}
+
+		// whether the result has to be submitted
+		bool should_send(const TestResult& result) const {
+			if (!enabled_ || full_) {
+				return true;
+			}
+
+			const Entry entry{result_identity(result), result_content(result)};
+			auto known = std::lower_bound(previous_.begin(), previous_.end(), entry, by_identity);
+			return known == previous_.end() || known->identity != entry.identity || known->content != entry.content;
+		}
+
+		// counts the result in, in the order the results are submitted; every result of the
+		// report goes through here, wherever it was kept (in memory, spilled or flushed upstream)
+		void record(const TestResult& result) {
+			if (enabled_) {
+				current_.push_back({result_identity(result), result_content(result)});
+			}
+		}
+
+		// records the results as submitted, call it once the submission succeeded
+		// tests that didn't run this time keep their previous entries
+		void commit() {
+			if (!enabled_) {
+				return;
+			}
+
+			// later results of the same test win
+			std::vector<Entry> merged = current_;
+			std::stable_sort(merged.begin(), merged.end(), by_identity);
+			merged.erase(merged.begin(), std::unique(merged.rbegin(), merged.rend(), same_identity).base());
+
+			std::vector<Entry> state;
+			state.reserve(previous_.size() + merged.size());
+			std::set_union(merged.begin(), merged.end(), previous_.begin(), previous_.end(),
+				std::back_inserter(state), by_identity);
+
+			const uint32_t deltas_since_full = full_ ? 0 : deltas_since_full_ + 1;
+			const uint64_t count = state.size();
+
+			// written aside and renamed over, so a crash never leaves a torn state behind
+			const std::string tmp_path = path_ + ".tmp";
+			{
+				std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+				out.write(magic, sizeof(magic));
+				out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+				out.write(reinterpret_cast<const char*>(&run_id_), sizeof(run_id_));
+				out.write(reinterpret_cast<const char*>(&deltas_since_full), sizeof(deltas_since_full));
+				out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+				out.write(reinterpret_cast<const char*>(state.data()), static_cast<std::streamsize>(state.size() * sizeof(Entry)));
+				if (!out) {
+					throw std::runtime_error("Failed to write delta state file: " + tmp_path);
+				}
+			}
+
+			if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+				throw std::runtime_error("Failed to replace delta state file: " + path_);
+			}
+		}
+
+	private:
+		struct Entry {
+			uint64_t identity;
+			uint64_t content;
 		};
+
+		static constexpr char magic[4] = {'Q', 'D', 'L', 'T'};
+		static constexpr uint32_t version = 1;
+
+		static bool by_identity(const Entry& a, const Entry& b) { return a.identity < b.identity; }
+		static bool same_identity(const Entry& a, const Entry& b) { return a.identity == b.identity; }
+
+		bool load() {
+			std::ifstream in(path_, std::ios::binary);
+			if (!in) {
+				return false;
+			}
+
+			char file_magic[sizeof(magic)];
+			uint32_t file_version = 0;
+			uint64_t file_run_id = 0;
+			uint64_t count = 0;
+			in.read(file_magic, sizeof(file_magic));
+			in.read(reinterpret_cast<char*>(&file_version), sizeof(file_version));
+			in.read(reinterpret_cast<char*>(&file_run_id), sizeof(file_run_id));
+			in.read(reinterpret_cast<char*>(&deltas_since_full_), sizeof(deltas_since_full_));
+			in.read(reinterpret_cast<char*>(&count), sizeof(count));
+			if (!in || std::memcmp(file_magic, magic, sizeof(magic)) != 0 || file_version != version || file_run_id != run_id_) {
+				return false;
+			}
+
+			// the size has to match the count exactly
+			const auto header_end = in.tellg();
+			in.seekg(0, std::ios::end);
+			if (static_cast<uint64_t>(in.tellg() - header_end) != count * sizeof(Entry)) {
+				return false;
+			}
+			in.seekg(header_end);
+
+			previous_.resize(count);
+			in.read(reinterpret_cast<char*>(previous_.data()), static_cast<std::streamsize>(count * sizeof(Entry)));
+			return static_cast<bool>(in);
+		}
+
+		std::string path_;
+		uint64_t run_id_;
+		bool enabled_ = false;
+		bool full_ = true;
+		uint32_t deltas_since_full_ = 0;
+		std::vector<Entry> previous_;
+		std::vector<Entry> current_;
+	};
+	#endif
+
+	// ========= MEMORY BUDGET =======
+#ifndef ESP_PLATFORM
+	// once the recorded results take more than cfg.recorder_memory_budget bytes they leave
+	// memory: appended to an on-disk segment ("disk") or submitted right away ("upload");
+	// the segment is read back in order, a budget's worth at a time, when the report is submitted
+
+	static struct RecorderSpill {
+		std::size_t budget = 0;
+		bool upload = false;
+		std::string path;
+		QaseConfig cfg;
+		IQaseApi* api = nullptr;
+		HttpClient* http = nullptr;
+
+		// estimated footprint of `collected`
+		std::size_t memory = 0;
+
+		// segment file, created on the first spill
+		std::ofstream segment;
+		std::size_t spilled = 0;
+
+		// sorted case ids of the spilled results, the run is started with them
+		std::vector<int> case_ids;
+
+		// run started by an upload flush, and the attachments uploaded into it by content
+		uint64_t run_id = 0;
+		std::unordered_map<uint64_t, std::string> uploaded_attachments;
+
+		// the delta state of the report, opened by the first upload flush or by the submission
+		// so flushed, spilled and in-memory results are all checked against it
+		std::optional<DeltaSubmission> delta;
+	} recorder_spill;
+
+	static DeltaSubmission& spill_delta(const QaseConfig& cfg) {
+		if (!recorder_spill.delta) {
+			recorder_spill.delta.emplace(cfg);
+		}
+		return *recorder_spill.delta;
 	}
 
-	inline std::string qase_api_base(const QaseConfig& cfg) {
-		return "https://" + cfg.host + "/v1/";
+	static bool spill_upload();
+
+	// heap bytes behind a string, small strings live inside the object
+	static std::size_t string_heap_size(const std::string& s) {
+		return s.capacity() > 15 ? s.capacity() + 1 : 0;
 	}
 
-	// qase_start_run should call Qase API and return new test run
-	uint64_t QaseApi::qase_start_run(HttpClient& http, const QaseConfig& cfg) {
-		const std::string url = qase_api_base(cfg) + "run/" + cfg.project;
-		nlohmann::json payload;
-		payload["title"] = cfg.run_title;
+	// rough footprint of a result, close enough to keep the recorder within its budget
+	static std::size_t result_memory(const TestResult& r) {
+		std::size_t size = sizeof(TestResult) + string_heap_size(r.name) + string_heap_size(r.logs) +
+			string_heap_size(r.meta.title);
+		for (const auto& kv : r.meta.fields) {
+			size += string_heap_size(kv.first) + string_heap_size(kv.second);
+		}
+		size += r.meta.attachments.capacity() * sizeof(std::string);
+		for (const auto& path : r.meta.attachments) {
+			size += string_heap_size(path);
+		}
+		size += r.steps.capacity() * sizeof(QaseStep);
+		for (const auto& step : r.steps) {
+			size += string_heap_size(step.name);
+		}
+		return size;
+	}
+
+	// segment records are [length][record], all integers LEB128 varints:
+	// name, flags (1 passed), case id, title, field count, key, value..., attachment count, path...,
+	// logs, step count, then per step name, passed, parent + 1, start time ms, duration us
+	static void put_spill_varint(std::string& out, uint64_t value) {
+		while (value >= 0x80) {
+			out += static_cast<char>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		out += static_cast<char>(value);
+	}
 
-		// todo: support passing from the config
-		payload["include_all_cases"] = true;
+	static void put_spill_string(std::string& out, const std::string& value) {
+		put_spill_varint(out, value.size());
+		out += value;
+	}
 
-		if (!cfg.run_description.empty()) {
-			payload["description"] = cfg.run_description;
+	static void encode_spilled_result(std::string& out, const TestResult& r) {
+		put_spill_string(out, r.name);
+		put_spill_varint(out, r.passed ? 1 : 0);
+		put_spill_varint(out, static_cast<uint64_t>(std::max(r.meta.case_id, 0)));
+		put_spill_string(out, r.meta.title);
+		put_spill_varint(out, r.meta.fields.size());
+		for (const auto& kv : r.meta.fields) {
+			put_spill_string(out, kv.first);
+			put_spill_string(out, kv.second);
+		}
+		put_spill_varint(out, r.meta.attachments.size());
+		for (const auto& path : r.meta.attachments) {
+			put_spill_string(out, path);
+		}
+		put_spill_string(out, r.logs);
+		put_spill_varint(out, r.steps.size());
+		for (const auto& step : r.steps) {
+			put_spill_string(out, step.name);
+			put_spill_varint(out, step.passed ? 1 : 0);
+			put_spill_varint(out, static_cast<uint64_t>(step.parent + 1));
+			put_spill_varint(out, static_cast<uint64_t>(step.start_time_ms));
+			put_spill_varint(out, static_cast<uint64_t>(step.duration_us));
+		}
+		put_spill_varint(out, r.memory.recorded ? 1 : 0);
+		if (r.memory.recorded) {
+			put_spill_varint(out, static_cast<uint64_t>(r.memory.allocations + 1));
+			put_spill_varint(out, static_cast<uint64_t>(r.memory.bytes + 1));
+			put_spill_varint(out, static_cast<uint64_t>(r.memory.peak_rss_delta_kb));
 		}
+	}
 
-		const auto headers = make_headers(cfg.token);
+	// bounds-checked reader over one record
+	struct SpillRecordReader {
+		const std::string& data;
+		std::size_t pos = 0;
+		bool failed = false;
 
-		std::string response = http.post(url, payload.dump(), headers);
-		auto json = nlohmann::json::parse(response);
+		uint64_t varint() {
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				if (pos >= data.size()) {
+					break;
+				}
+				const uint8_t byte = static_cast<uint8_t>(data[pos++]);
+				value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) {
+					return value;
+				}
+			}
+			failed = true;
+			return 0;
+		}
 
-		check_qase_api_error(json);
+		std::string string() {
+			const uint64_t size = varint();
+			if (failed || size > data.size() - pos) {
+				failed = true;
+				return {};
+			}
+			std::string value = data.substr(pos, size);
+			pos += size;
+			return value;
+		}
+	};
 
-		// extract result.id if present
-		if (json.contains("result") && json["result"].contains("id")) {
-			return json["result"]["id"].get<uint64_t>();
+	static bool decode_spilled_result(const std::string& record, TestResult& r) {
+		SpillRecordReader in{record};
+		r.name = in.string();
+		r.passed = in.varint() == 1;
+		r.meta.case_id = static_cast<int>(in.varint());
+		r.meta.title = in.string();
+		for (uint64_t i = 0, n = in.varint(); i < n && !in.failed; ++i) {
+			std::string key = in.string();
+			r.meta.fields[key] = in.string();
+		}
+		for (uint64_t i = 0, n = in.varint(); i < n && !in.failed; ++i) {
+			r.meta.attachments.push_back(in.string());
+		}
+		r.logs = in.string();
+		for (uint64_t i = 0, n = in.varint(); i < n && !in.failed; ++i) {
+			QaseStep& step = r.steps.emplace_back();
+			step.name = in.string();
+			step.passed = in.varint() == 1;
+			step.parent = static_cast<int>(in.varint()) - 1;
+			step.start_time_ms = static_cast<int64_t>(in.varint());
+			step.duration_us = static_cast<int64_t>(in.varint());
+		}
+		r.memory.recorded = in.varint() == 1;
+		if (r.memory.recorded) {
+			r.memory.allocations = static_cast<int64_t>(in.varint()) - 1;
+			r.memory.bytes = static_cast<int64_t>(in.varint()) - 1;
+			r.memory.peak_rss_delta_kb = static_cast<int64_t>(in.varint());
+		}
+		return !in.failed;
+	}
+
+	// appends the recorded results to the segment, in the order they were recorded
+	static void spill_to_disk() {
+		RecorderSpill& spill = recorder_spill;
+		if (!spill.segment.is_open()) {
+			spill.segment.open(spill.path, std::ios::binary | std::ios::trunc);
+			if (!spill.segment) {
+				throw std::runtime_error("Could not open spill segment: " + spill.path);
+			}
+		}
+
+		std::string record;
+		std::string length;
+		for (const auto& result : collected) {
+			record.clear();
+			length.clear();
+			encode_spilled_result(record, result);
+			put_spill_varint(length, record.size());
+			spill.segment.write(length.data(), static_cast<std::streamsize>(length.size()));
+			spill.segment.write(record.data(), static_cast<std::streamsize>(record.size()));
+
+			const int case_id = result.meta.case_id;
+			if (case_id > 0 && !std::binary_search(spill.case_ids.begin(), spill.case_ids.end(), case_id)) {
+				spill.case_ids.insert(std::upper_bound(spill.case_ids.begin(), spill.case_ids.end(), case_id), case_id);
+			}
+		}
+
+		spill.segment.flush();
+		if (!spill.segment) {
+			throw std::runtime_error("Failed to write spill segment: " + spill.path);
+		}
+		spill.spilled += collected.size();
+	}
+
+	// counts the result in, and moves everything recorded out of memory once over the budget
+	static void spill_account(const TestResult& result) {
+		RecorderSpill& spill = recorder_spill;
+		if (spill.budget == 0) {
+			return;
+		}
+
+		spill.memory += result_memory(result);
+		if (spill.memory <= spill.budget) {
+			return;
+		}
+
+		if (!spill.upload || !spill.api || !spill_upload()) {
+			spill_to_disk();
+		}
+		// the vector keeps its capacity, it never holds more than a budget's worth
+		collected.clear();
+		spill.memory = 0;
+	}
+
+	// reads the spilled results back in order and hands them over a budget's worth at a time
+	template <typename OnChunk>
+	static void spill_replay(OnChunk on_chunk) {
+		RecorderSpill& spill = recorder_spill;
+		if (spill.spilled == 0) {
+			return;
+		}
+		spill.segment.flush();
+
+		std::ifstream in(spill.path, std::ios::binary);
+		if (!in) {
+			throw std::runtime_error("Could not open spill segment: " + spill.path);
+		}
+
+		std::vector<TestResult> chunk;
+		std::size_t chunk_memory = 0;
+		std::string record;
+		for (std::size_t i = 0; i < spill.spilled; ++i) {
+			uint64_t length = 0;
+			for (int shift = 0; shift < 64; shift += 7) {
+				const int byte = in.get();
+				if (byte == EOF) {
+					break;
+				}
+				length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80)) {
+					break;
+				}
+			}
+			record.resize(length);
+			in.read(&record[0], static_cast<std::streamsize>(length));
+
+			TestResult& result = chunk.emplace_back();
+			if (!in || !decode_spilled_result(record, result)) {
+				throw std::runtime_error("Spill segment is damaged: " + spill.path);
+			}
+
+			chunk_memory += result_memory(result);
+			if (chunk_memory > spill.budget) {
+				on_chunk(chunk);
+				chunk.clear();
+				chunk_memory = 0;
+			}
+		}
+		if (!chunk.empty()) {
+			on_chunk(chunk);
+		}
+	}
+
+	// drops what was spilled, the budget settings stay
+	static void spill_clear() {
+		RecorderSpill& spill = recorder_spill;
+		if (spill.segment.is_open()) {
+			spill.segment.close();
+			std::remove(spill.path.c_str());
+		}
+		spill.memory = 0;
+		spill.spilled = 0;
+		spill.case_ids.clear();
+		spill.run_id = 0;
+		spill.uploaded_attachments.clear();
+		spill.delta.reset();
+	}
+
+	static void spill_configure(const QaseConfig& cfg) {
+		spill_clear();
+
+		RecorderSpill& spill = recorder_spill;
+		spill.budget = cfg.recorder_memory_budget;
+		spill.upload = cfg.recorder_spill == "upload";
+		spill.path = cfg.recorder_spill_path;
+		if (spill.path.empty()) {
+			spill.path = (std::filesystem::temp_directory_path() /
+				("qase-spill-" + std::to_string(getpid()) + ".bin")).string();
+		}
+		spill.cfg = cfg;
+
+		for (const auto& result : collected) {
+			spill.memory += result_memory(result);
+		}
+	}
+
+	void qase_reporter_set_uploader(IQaseApi& api, HttpClient& http) {
+		recorder_spill.api = &api;
+		recorder_spill.http = &http;
+	}
+#else
+	static void spill_account(const TestResult&) {}
+	static void spill_clear() {}
+#endif
+
+#ifndef ESP_PLATFORM
+	// shard rendezvous, defined with the submission flow
+	static void shared_run_join(const QaseConfig& cfg);
+#endif
+
+	// defined with the memory profile, next to the test lifecycle
+	static void memory_profile_configure(const QaseConfig& cfg);
+
+#ifdef QASE_REPORTER_FULL_MODE_ENABLED
+	// streamed ndjson report, defined with the local report writers
+	static void report_stream_open(const QaseConfig& cfg);
+	static bool report_stream_write(const TestResult& result);
+	static bool report_stream_close();
+	static std::string local_report_path(const QaseConfig& cfg);
+	static void save_local_report(const QaseConfig& cfg);
+#endif
+
+	void qase_reporter_configure(const QaseConfig& cfg) {
+		stop_log_capture();
+#ifndef ESP_PLATFORM
+		shutdown_stream_capture();
+#endif
+
+		{
+			std::lock_guard<std::mutex> lock(log_capture.mutex);
+			log_capture.enabled = cfg.capture_logs;
+			log_capture.failed_only = cfg.capture_logs_failed_only;
+
+			// the buffer is allocated once here and reused by every test
+			log_capture.ring.reset(cfg.capture_logs ? cfg.capture_logs_max_bytes : 0);
+		}
+
+#ifndef ESP_PLATFORM
+		spill_configure(cfg);
+		shared_run_join(cfg);
+#endif
+		memory_profile_configure(cfg);
+#ifdef QASE_REPORTER_FULL_MODE_ENABLED
+		report_stream_open(cfg);
+#endif
+	}
+
+	// steps of the running test, the storage is kept between tests
+	struct StepRecorder {
+		static constexpr std::size_t initial_steps = 32;
+		static constexpr std::size_t initial_name_bytes = 1024;
+
+		struct Slot {
+			// the name lives in `names`, so recording a step doesn't allocate
+			uint32_t name_offset;
+			uint32_t name_size;
+			int parent;
+			bool open;
+			bool passed;
+			int64_t start_time_ms;
+			std::chrono::steady_clock::time_point start;
+			int64_t duration_us;
+		};
+
+		std::vector<Slot> slots;
+		std::string names;
+		int current = -1;
+
+		void clear() {
+			slots.clear();
+			names.clear();
+			current = -1;
+		}
+	};
+
+	static StepRecorder step_recorder;
+
+	int qase_step_begin(std::string_view name) {
+		if (step_recorder.slots.capacity() == 0) {
+			step_recorder.slots.reserve(StepRecorder::initial_steps);
+			step_recorder.names.reserve(StepRecorder::initial_name_bytes);
+		}
+
+		StepRecorder::Slot& slot = step_recorder.slots.emplace_back();
+		slot.name_offset = static_cast<uint32_t>(step_recorder.names.size());
+		slot.name_size = static_cast<uint32_t>(name.size());
+		step_recorder.names.append(name.data(), name.size());
+
+		slot.parent = step_recorder.current;
+		slot.open = true;
+		slot.passed = true;
+		slot.start_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		slot.duration_us = 0;
+		slot.start = std::chrono::steady_clock::now();
+
+		step_recorder.current = static_cast<int>(step_recorder.slots.size() - 1);
+		return step_recorder.current;
+	}
+
+	static int64_t step_elapsed_us(const StepRecorder::Slot& slot) {
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now() - slot.start).count();
+	}
+
+	void qase_step_end(int step, bool passed) {
+		// the step may belong to a test that is already recorded
+		if (step < 0 || static_cast<std::size_t>(step) >= step_recorder.slots.size() ||
+				!step_recorder.slots[step].open) {
+			return;
+		}
+
+		StepRecorder::Slot& slot = step_recorder.slots[step];
+		slot.duration_us = step_elapsed_us(slot);
+		slot.passed = passed;
+		slot.open = false;
+		step_recorder.current = slot.parent;
+	}
+
+	// moves the recorded steps into the result, steps left open are failed
+	static void take_steps(TestResult& result) {
+		if (step_recorder.slots.empty()) {
+			return;
+		}
+
+		result.steps.reserve(step_recorder.slots.size());
+		for (const auto& slot : step_recorder.slots) {
+			QaseStep& step = result.steps.emplace_back();
+			step.name.assign(step_recorder.names, slot.name_offset, slot.name_size);
+			step.passed = !slot.open && slot.passed;
+			step.parent = slot.parent;
+			step.start_time_ms = slot.start_time_ms;
+			step.duration_us = slot.open ? step_elapsed_us(slot) : slot.duration_us;
+		}
+
+		step_recorder.clear();
+	}
+
+	// ========= CRASH JOURNAL =======
+#ifndef ESP_PLATFORM
+	// recorded results are kept as serial protocol frames in a buffer allocated on install,
+	// so the signal handler only has to append one more frame and write() the buffer out
+
+	// appends into the journal buffer; a frame that doesn't fit marks it full
+	struct JournalSink : public QaseByteSink {
+		uint8_t* data = nullptr;
+		std::size_t capacity = 0;
+		std::size_t size = 0;
+		bool full = false;
+
+		void write(const uint8_t* bytes, std::size_t n) override {
+			if (full || n > capacity - size) {
+				full = true;
+				return;
+			}
+			std::memcpy(data + size, bytes, n);
+			size += n;
+		}
+	};
+
+	static_assert(std::atomic<std::size_t>::is_always_lock_free,
+		"the crash handler reads the journal sizes from a signal context");
+
+	static constexpr int crash_signals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+	static constexpr std::size_t crash_signal_count = sizeof(crash_signals) / sizeof(crash_signals[0]);
+
+	// room kept free for the crashed result: its log, name string and result frames
+	static constexpr std::size_t crash_reserve = 3 * (QaseSerialEncoder::max_payload + 8);
+
+	static struct CrashJournal {
+		std::string path;
+		int fd = -1;
+		std::unique_ptr<uint8_t[]> buffer;
+		std::size_t capacity = 0;
+		JournalSink sink;
+		std::optional<QaseSerialEncoder> encoder;
+
+		// bytes of complete frames, the handler never writes past them
+		std::atomic<std::size_t> committed{0};
+
+		// name of the running test, size 0 when no test is running
+		char test_name[QaseSerialEncoder::max_string];
+		std::atomic<std::size_t> test_name_size{0};
+
+		std::unique_ptr<uint8_t[]> alt_stack;
+		struct sigaction previous[crash_signal_count];
+	} crash_journal;
+
+	static void restore_crash_signals() {
+		for (std::size_t i = 0; i < crash_signal_count; ++i) {
+			sigaction(crash_signals[i], &crash_journal.previous[i], nullptr);
+		}
+	}
+
+	static const char* crash_signal_name(int sig) {
+		switch (sig) {
+		case SIGSEGV: return "SIGSEGV";
+		case SIGBUS: return "SIGBUS";
+		case SIGILL: return "SIGILL";
+		case SIGFPE: return "SIGFPE";
+		case SIGABRT: return "SIGABRT";
+		default: return "signal";
+		}
+	}
+
+	// runs in the signal context: no allocation, no locks, async-signal-safe calls only
+	static void crash_signal_handler(int sig) {
+		CrashJournal& journal = crash_journal;
+		std::size_t size = journal.committed.load(std::memory_order_acquire);
+
+		const std::size_t name_size = journal.test_name_size.load(std::memory_order_acquire);
+		if (name_size > 0) {
+			// a fresh encoder, as the journal one may have been interrupted halfway through a frame;
+			// its string frames redefine ids the host has already resolved
+			JournalSink sink;
+			sink.data = journal.buffer.get();
+			sink.capacity = journal.capacity;
+			sink.size = size;
+
+			char message[64] = "Crashed with ";
+			std::size_t message_size = std::strlen(message);
+			const char* name = crash_signal_name(sig);
+			const std::size_t n = std::min(std::strlen(name), sizeof(message) - message_size);
+			std::memcpy(message + message_size, name, n);
+			message_size += n;
+
+			QaseSerialEncoder encoder(sink);
+			encoder.write_result(std::string_view(journal.test_name, name_size), false,
+				std::string_view(message, message_size));
+			if (!sink.full) {
+				size = sink.size;
+			}
+		}
+
+		// no run_end frame: the collector reads the journal up to EOF
+		std::size_t written = 0;
+		while (written < size) {
+			ssize_t n = pwrite(journal.fd, journal.buffer.get() + written, size - written,
+				static_cast<off_t>(written));
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				break;
+			}
+			written += static_cast<std::size_t>(n);
+		}
+		(void)ftruncate(journal.fd, static_cast<off_t>(written));
+		fsync(journal.fd);
+
+		// the previous disposition handles the signal once this handler returns
+		restore_crash_signals();
+		raise(sig);
+	}
+
+	static void journal_result(const TestResult& result) {
+		CrashJournal& journal = crash_journal;
+		journal.test_name_size.store(0, std::memory_order_release);
+		if (!journal.encoder || journal.sink.full) {
+			return;
+		}
+
+		// once a frame didn't fit the journal stops: later frames could refer to its strings
+		journal.encoder->write_result(result);
+		if (!journal.sink.full) {
+			journal.committed.store(journal.sink.size, std::memory_order_release);
+		}
+	}
+
+	static void journal_begin_test(std::string_view name) {
+		CrashJournal& journal = crash_journal;
+		journal.test_name_size.store(0, std::memory_order_release);
+		if (!journal.encoder || name.empty()) {
+			return;
+		}
+		name = name.substr(0, sizeof(journal.test_name));
+		std::memcpy(journal.test_name, name.data(), name.size());
+		journal.test_name_size.store(name.size(), std::memory_order_release);
+	}
+
+	static void journal_end_test() {
+		crash_journal.test_name_size.store(0, std::memory_order_release);
+	}
+
+	// starts the journal over, e.g. once the recorder is reset
+	static void journal_rewind() {
+		CrashJournal& journal = crash_journal;
+		journal.test_name_size.store(0, std::memory_order_release);
+		if (!journal.encoder) {
+			return;
+		}
+		journal.sink.size = 0;
+		journal.sink.full = false;
+		journal.encoder->begin_run();
+		journal.committed.store(journal.sink.size, std::memory_order_release);
+	}
+
+	void qase_crash_handler_install(const std::string& path, std::size_t capacity) {
+		qase_crash_handler_uninstall();
+
+		if (capacity < 2 * crash_reserve) {
+			throw std::invalid_argument("Crash journal capacity must be at least " +
+				std::to_string(2 * crash_reserve) + " bytes");
+		}
+
+		// not truncated here: a journal of the previous run may still be waiting for recovery
+		int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			throw std::runtime_error("Could not open crash journal: " + path + ": " + std::strerror(errno));
+		}
+
+		CrashJournal& journal = crash_journal;
+		journal.path = path;
+		journal.fd = fd;
+		journal.buffer.reset(new uint8_t[capacity]);
+		journal.capacity = capacity;
+		journal.sink = JournalSink();
+		journal.sink.data = journal.buffer.get();
+		journal.sink.capacity = capacity - crash_reserve;
+		journal.encoder.emplace(journal.sink);
+
+		journal_rewind();
+		qase_reporter_for_each_result(journal_result);
+
+		// a stack overflow leaves no stack to run the handler on
+		constexpr std::size_t alt_stack_size = 64 * 1024;
+		journal.alt_stack.reset(new uint8_t[alt_stack_size]);
+		stack_t stack = {};
+		stack.ss_sp = journal.alt_stack.get();
+		stack.ss_size = alt_stack_size;
+		sigaltstack(&stack, nullptr);
+
+		struct sigaction action = {};
+		action.sa_handler = crash_signal_handler;
+		action.sa_flags = SA_ONSTACK;
+		sigemptyset(&action.sa_mask);
+		for (std::size_t i = 0; i < crash_signal_count; ++i) {
+			sigaction(crash_signals[i], &action, &journal.previous[i]);
+		}
+	}
+
+	void qase_crash_handler_uninstall() {
+		CrashJournal& journal = crash_journal;
+		if (journal.fd < 0) {
+			return;
+		}
+
+		restore_crash_signals();
+		stack_t stack = {};
+		stack.ss_flags = SS_DISABLE;
+		sigaltstack(&stack, nullptr);
+
+		// nothing crashed, so the file is still the empty one created on install
+		struct stat st;
+		if (fstat(journal.fd, &st) == 0 && st.st_size == 0) {
+			std::remove(journal.path.c_str());
+		}
+		close(journal.fd);
+
+		journal.fd = -1;
+		journal.test_name_size.store(0);
+		journal.committed.store(0);
+		journal.encoder.reset();
+		journal.sink = JournalSink();
+		journal.buffer.reset();
+		journal.alt_stack.reset();
+		journal.capacity = 0;
+	}
+
+	bool qase_crash_recover(const std::string& path, IQaseApi& api, HttpClient& http, const QaseConfig& cfg) {
+		int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+		if (fd < 0) {
+			return false;
+		}
+
+		struct stat st;
+		const bool found = fstat(fd, &st) == 0 && st.st_size > 0;
+		if (found) {
+			// on failure the journal stays, so the next start tries again
+			try {
+				qase_serial_collect(fd, api, http, cfg);
+			} catch (...) {
+				close(fd);
+				throw;
+			}
+		}
+		close(fd);
+
+		std::remove(path.c_str());
+		return found;
+	}
+#else
+	static void journal_result(const TestResult&) {}
+	static void journal_begin_test(std::string_view) {}
+	static void journal_end_test() {}
+	static void journal_rewind() {}
+#endif
+
+	// ========= RESULT OBSERVERS =======
+#ifndef ESP_PLATFORM
+	// single-producer single-consumer ring between the test thread and the consumer thread
+	// head and tail only grow, a slot is head or tail modulo the power of two capacity;
+	// the producer owns head and the slot at it, the consumer owns tail and the slot at it
+	// slots keep their TestResult between laps, so once the ring went round copying a
+	// result into it reuses the slot's string storage instead of allocating
+
+	static struct ResultObservers {
+		// qase_observers_start's default
+		static constexpr std::size_t default_capacity = 4096;
+
+		std::vector<TestResult> slots;
+		std::size_t mask = 0;
+
+		alignas(64) std::atomic<uint64_t> head{0};
+		alignas(64) std::atomic<uint64_t> tail{0};
+
+		alignas(64) std::atomic<bool> running{false};
+		std::atomic<bool> stopping{false};
+		std::thread consumer;
+
+		// serializes starting and stopping the consumer, a subscriber may start it from any thread
+		std::mutex lifecycle_mutex;
+
+		// the consumer sleeps on `wake` when the ring is empty, flush waits on `drained`;
+		// the producer only takes the mutex to notify, and only if the consumer is asleep
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::condition_variable drained;
+		std::atomic<bool> consumer_waiting{false};
+		std::atomic<bool> flush_waiting{false};
+
+		// copied on write, the consumer delivers to a snapshot
+		std::mutex observers_mutex;
+		std::shared_ptr<const std::vector<std::pair<int, QaseResultObserver>>> observers =
+			std::make_shared<const std::vector<std::pair<int, QaseResultObserver>>>();
+		int next_id = 1;
+
+		// deliveries started and finished, under observers_mutex; unsubscribe waits on
+		// `delivery_done` for the ones that may still hold the old snapshot
+		uint64_t deliveries_started = 0;
+		uint64_t deliveries_finished = 0;
+		int unsubscribe_waiting = 0;
+		std::condition_variable delivery_done;
+
+		std::atomic<uint64_t> published{0};
+		std::atomic<uint64_t> delivered{0};
+		std::atomic<uint64_t> dropped{0};
+		std::atomic<uint64_t> failed{0};
+
+		~ResultObservers() { qase_observers_stop(); }
+	} result_observers;
+
+	static void deliver_result(const TestResult& result) {
+		ResultObservers& obs = result_observers;
+		std::shared_ptr<const std::vector<std::pair<int, QaseResultObserver>>> observers;
+		{
+			std::lock_guard<std::mutex> lock(obs.observers_mutex);
+			observers = obs.observers;
+			++obs.deliveries_started;
+		}
+		for (const auto& entry : *observers) {
+			try {
+				entry.second(result);
+			} catch (...) {
+				obs.failed.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(obs.observers_mutex);
+		++obs.deliveries_finished;
+		if (obs.unsubscribe_waiting > 0) {
+			obs.delivery_done.notify_all();
+		}
+	}
+
+	static void consume_results() {
+		ResultObservers& obs = result_observers;
+		for (;;) {
+			const uint64_t tail = obs.tail.load(std::memory_order_relaxed);
+			if (tail == obs.head.load(std::memory_order_acquire)) {
+				if (obs.stopping.load()) {
+					return;
+				}
+				// the flag is up before the ring is checked again, so a result published
+				// in between either is seen here or notifies; the timeout is a backstop
+				std::unique_lock<std::mutex> lock(obs.mutex);
+				obs.consumer_waiting.store(true);
+				if (tail == obs.head.load() && !obs.stopping.load()) {
+					obs.wake.wait_for(lock, std::chrono::milliseconds(100));
+				}
+				obs.consumer_waiting.store(false);
+				continue;
+			}
+
+			deliver_result(obs.slots[tail & obs.mask]);
+			obs.tail.store(tail + 1);
+			obs.delivered.fetch_add(1, std::memory_order_relaxed);
+
+			if (obs.flush_waiting.load()) {
+				std::lock_guard<std::mutex> lock(obs.mutex);
+				obs.drained.notify_all();
+			}
+		}
+	}
+
+	// test thread side: never blocks and, in steady state, never allocates
+	static void publish_result(const TestResult& result) {
+		ResultObservers& obs = result_observers;
+		if (!obs.running.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		const uint64_t head = obs.head.load(std::memory_order_relaxed);
+		if (head - obs.tail.load(std::memory_order_acquire) == obs.slots.size()) {
+			obs.dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		obs.slots[head & obs.mask] = result;
+		obs.head.store(head + 1);
+		obs.published.fetch_add(1, std::memory_order_relaxed);
+
+		// the consumer holds the mutex from its empty check until it waits, so taking it
+		// here keeps the notification from landing in between and being lost
+		if (obs.consumer_waiting.load()) {
+			{
+				std::lock_guard<std::mutex> lock(obs.mutex);
+			}
+			obs.wake.notify_one();
+		}
+	}
+
+	static void observers_stop_locked();
+
+	static void observers_start_locked(std::size_t capacity) {
+		observers_stop_locked();
+
+		std::size_t size = 1;
+		while (size < capacity) {
+			size <<= 1;
+		}
+
+		ResultObservers& obs = result_observers;
+		obs.slots.assign(size, TestResult{});
+		obs.mask = size - 1;
+		obs.head.store(0);
+		obs.tail.store(0);
+		obs.stopping.store(false);
+		obs.consumer = std::thread(consume_results);
+		obs.running.store(true);
+	}
+
+	void qase_observers_start(std::size_t capacity) {
+		std::lock_guard<std::mutex> lock(result_observers.lifecycle_mutex);
+		observers_start_locked(capacity);
+	}
+
+	static void observers_stop_locked() {
+		ResultObservers& obs = result_observers;
+		if (!obs.consumer.joinable()) {
+			return;
+		}
+		obs.running.store(false);
+		{
+			std::lock_guard<std::mutex> lock(obs.mutex);
+			obs.stopping.store(true);
+		}
+		obs.wake.notify_one();
+		obs.consumer.join();
+
+		std::lock_guard<std::mutex> lock(obs.mutex);
+		obs.drained.notify_all();
+	}
+
+	void qase_observers_stop() {
+		std::lock_guard<std::mutex> lock(result_observers.lifecycle_mutex);
+		observers_stop_locked();
+	}
+
+	void qase_observers_flush() {
+		ResultObservers& obs = result_observers;
+		if (!obs.consumer.joinable()) {
+			return;
+		}
+		const uint64_t target = obs.head.load();
+
+		std::unique_lock<std::mutex> lock(obs.mutex);
+		obs.flush_waiting.store(true);
+		obs.wake.notify_one();
+		obs.drained.wait(lock, [&obs, target] { return obs.tail.load() >= target; });
+		obs.flush_waiting.store(false);
+	}
+
+	int qase_observer_subscribe(QaseResultObserver observer) {
+		if (!observer) {
+			throw std::invalid_argument("Observer must not be empty");
+		}
+
+		ResultObservers& obs = result_observers;
+		int id;
+		{
+			std::lock_guard<std::mutex> lock(obs.observers_mutex);
+			auto observers = std::make_shared<std::vector<std::pair<int, QaseResultObserver>>>(*obs.observers);
+			id = obs.next_id++;
+			observers->emplace_back(id, std::move(observer));
+			obs.observers = std::move(observers);
+		}
+
+		// an observer subscribing another one runs on the consumer, which may be being stopped
+		if (std::this_thread::get_id() == obs.consumer.get_id()) {
+			return id;
+		}
+		// checked under the lifecycle mutex, so a concurrent qase_observers_start(capacity)
+		// either wins or sees the consumer this one started
+		std::lock_guard<std::mutex> lock(obs.lifecycle_mutex);
+		if (!obs.consumer.joinable()) {
+			observers_start_locked(ResultObservers::default_capacity);
+		}
+		return id;
+	}
+
+	void qase_observer_unsubscribe(int id) {
+		ResultObservers& obs = result_observers;
+		std::unique_lock<std::mutex> lock(obs.observers_mutex);
+		auto observers = std::make_shared<std::vector<std::pair<int, QaseResultObserver>>>(*obs.observers);
+		observers->erase(std::remove_if(observers->begin(), observers->end(),
+			[id](const auto& entry) { return entry.first == id; }), observers->end());
+		obs.observers = std::move(observers);
+
+		// deliveries from here on use the new snapshot, the one in flight may still call the
+		// observer; an observer unsubscribing from the consumer thread is that delivery
+		if (std::this_thread::get_id() == obs.consumer.get_id()) {
+			return;
+		}
+		const uint64_t in_flight = obs.deliveries_started;
+		++obs.unsubscribe_waiting;
+		obs.delivery_done.wait(lock, [&obs, in_flight] { return obs.deliveries_finished >= in_flight; });
+		--obs.unsubscribe_waiting;
+	}
+
+	QaseObserverStats qase_observer_stats() {
+		const ResultObservers& obs = result_observers;
+		QaseObserverStats stats;
+		stats.published = obs.published.load();
+		stats.delivered = obs.delivered.load();
+		stats.dropped = obs.dropped.load();
+		stats.failed = obs.failed.load();
+		return stats;
+	}
+#else
+	static void publish_result(const TestResult&) {}
+#endif
+
+	// ========= MEMORY PROFILE =======
+#ifndef ESP_PLATFORM
+	// the counters live here rather than in src/qase_alloc_hooks.cpp, so the reporter
+	// links whether the hooks are there or not; thread_local keeps allocations of other
+	// threads (observers, upload workers) out of a test's numbers
+	QaseAllocCounters& qase_alloc_counters() noexcept {
+		static thread_local QaseAllocCounters counters;
+		return counters;
+	}
+
+	// set during static initialization, before any test runs
+	static bool alloc_hooks_registered = false;
+
+	void qase_alloc_hooks_register() noexcept {
+		alloc_hooks_registered = true;
+	}
+
+	bool qase_alloc_hooks_registered() noexcept {
+		return alloc_hooks_registered;
+	}
+
+	static struct MemoryProfiler {
+		bool enabled = false;
+
+		// snapshot taken when the running test began
+		bool running = false;
+		QaseAllocCounters start;
+		long start_peak_rss_kb = 0;
+	} memory_profiler;
+
+	static long peak_rss_kb() {
+		struct rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+	}
+
+	static void memory_profile_configure(const QaseConfig& cfg) {
+		memory_profiler.enabled = cfg.profile_memory;
+		memory_profiler.running = false;
+	}
+
+	// taken last thing when a test begins, so the reporter's own work isn't counted
+	static void memory_profile_begin() {
+		memory_profiler.running = memory_profiler.enabled;
+		if (memory_profiler.running) {
+			memory_profiler.start_peak_rss_kb = peak_rss_kb();
+			memory_profiler.start = qase_alloc_counters();
+		}
+	}
+
+	// taken first thing when the result is recorded
+	static QaseMemoryProfile memory_profile_end() {
+		QaseMemoryProfile profile;
+		if (!memory_profiler.running) {
+			return profile;
+		}
+		const QaseAllocCounters now = qase_alloc_counters();
+		memory_profiler.running = false;
+
+		profile.recorded = true;
+		if (alloc_hooks_registered) {
+			profile.allocations = static_cast<int64_t>(now.allocations - memory_profiler.start.allocations);
+			profile.bytes = static_cast<int64_t>(now.bytes - memory_profiler.start.bytes);
+		}
+		profile.peak_rss_delta_kb = peak_rss_kb() - memory_profiler.start_peak_rss_kb;
+		return profile;
+	}
+#else
+	static void memory_profile_configure(const QaseConfig&) {}
+	static void memory_profile_begin() {}
+	static QaseMemoryProfile memory_profile_end() { return {}; }
+#endif
+
+	void qase_reporter_begin_test(std::string_view name) {
+		// steps of a test that was never closed with qase_reporter_add_result
+		step_recorder.clear();
+		journal_begin_test(name);
+
+		if (log_capture.enabled) {
+			// previous test was never closed with qase_reporter_add_result
+			stop_log_capture();
+
+			{
+				std::lock_guard<std::mutex> lock(log_capture.mutex);
+				log_capture.ring.clear();
+				log_capture.active = true;
+			}
+
+#ifndef ESP_PLATFORM
+			start_stream_capture();
+#endif
+		}
+
+		memory_profile_begin();
+	}
+
+	// set in the worker processes of qase_run_registered_tests, the parent records their results
+	static bool parallel_worker = false;
+
+	// called once the result is fully recorded: closes the running test
+	static void complete_result(TestResult& result) {
+		take_steps(result);
+
+		if (log_capture.active) {
+			std::string logs = stop_log_capture();
+			if (!result.passed || !log_capture.failed_only) {
+				result.logs = std::move(logs);
+			}
+		}
+
+		if (parallel_worker) {
+			return;
+		}
+
+		journal_result(result);
+		publish_result(result);
+
+#ifdef QASE_REPORTER_FULL_MODE_ENABLED
+		if (report_stream_write(result)) {
+			// report mode: the line in the report is all that's kept
+			collected.pop_back();
+			return;
+		}
+#endif
+
+		spill_account(result);
+	}
+
+	// constructs a new result directly in the recorder storage
+	static TestResult& emplace_result(std::string_view name, bool passed) {
+		if (name.empty()) {
+			throw std::invalid_argument("Test name must not be empty");
+		}
+		// before the result itself allocates anything
+		const QaseMemoryProfile memory = memory_profile_end();
+
+		TestResult& result = collected.emplace_back();
+		result.name.assign(name.data(), name.size());
+		result.passed = passed;
+		result.memory = memory;
+		return result;
+	}
+
+	void qase_reporter_add_result(std::string_view name, bool passed) {
+		complete_result(emplace_result(name, passed));
+	}
+
+	void qase_reporter_add_result(std::string_view name, bool passed, const QaseResultMeta& meta) {
+		TestResult& result = emplace_result(name, passed);
+		result.meta = meta;
+		complete_result(result);
+	}
+
+	void qase_reporter_add_result(std::string_view name, bool passed, QaseResultMeta&& meta) {
+		TestResult& result = emplace_result(name, passed);
+		result.meta = std::move(meta);
+		complete_result(result);
+	}
+
+	const std::vector<TestResult>& qase_reporter_get_results() {
+		return collected;
+	}
+
+	void qase_reporter_for_each_result(const std::function<void(const TestResult&)>& visit) {
+#ifndef ESP_PLATFORM
+		spill_replay([&visit](std::vector<TestResult>& chunk) {
+			for (const auto& result : chunk) {
+				visit(result);
+			}
+		});
+#endif
+		for (const auto& result : collected) {
+			visit(result);
+		}
+	}
+
+	void qase_reporter_reset() {
+		stop_log_capture();
+		step_recorder.clear();
+		collected.clear();
+		collected_params.clear();
+		journal_rewind();
+		spill_clear();
+	}
+
+	void qase_reporter_reserve(std::size_t count) {
+		collected.reserve(count);
+	}
+
+	// ========= PARAMETERIZED RESULTS =======
+
+	uint32_t QaseParamResults::define_test(std::string_view name, QaseResultMeta meta) {
+		if (name.empty()) {
+			throw std::invalid_argument("Test name must not be empty");
+		}
+		Test& test = tests_.emplace_back();
+		test.name.assign(name.data(), name.size());
+		test.meta = std::move(meta);
+		return static_cast<uint32_t>(tests_.size() - 1);
+	}
+
+	void QaseParamResults::add(uint32_t test, bool passed, const QaseFields& params) {
+		if (test >= tests_.size()) {
+			throw std::out_of_range("Unknown parameterized test: " + std::to_string(test));
+		}
+		iterations_.push_back({test, intern_params(params), passed});
+	}
+
+	uint32_t QaseParamResults::intern(std::string_view value) {
+		auto known = string_ids_.find(value);
+		if (known != string_ids_.end()) {
+			return known->second;
+		}
+
+		const uint32_t id = static_cast<uint32_t>(strings_.size());
+		strings_.emplace_back(value);
+		string_ids_.emplace(strings_.back(), id);
+		return id;
+	}
+
+	uint32_t QaseParamResults::intern_params(const QaseFields& params) {
+		// the candidate set is appended, and dropped again if it's already known
+		const uint32_t begin = set_offsets_.back();
+		for (const auto& [key, value] : params) {
+			set_data_.push_back(intern(key));
+			set_data_.push_back(intern(value));
+		}
+
+		const std::size_t size = set_data_.size() - begin;
+		const uint64_t hash = qase_hash64(set_data_.data() + begin, size * sizeof(uint32_t));
+
+		auto [first, last] = set_ids_.equal_range(hash);
+		for (auto it = first; it != last; ++it) {
+			const uint32_t known = it->second;
+			if (set_offsets_[known + 1] - set_offsets_[known] == size &&
+					std::equal(set_data_.begin() + set_offsets_[known], set_data_.begin() + set_offsets_[known + 1],
+						set_data_.begin() + begin)) {
+				set_data_.resize(begin);
+				return known;
+			}
+		}
+
+		const uint32_t id = static_cast<uint32_t>(set_offsets_.size() - 1);
+		set_offsets_.push_back(static_cast<uint32_t>(set_data_.size()));
+		set_ids_.emplace(hash, id);
+		return id;
+	}
+
+	const std::string& QaseParamResults::logs(std::size_t iteration) const {
+		static const std::string none;
+		auto it = logs_.find(iteration);
+		return it != logs_.end() ? it->second : none;
+	}
+
+	void QaseParamResults::set_logs(std::size_t iteration, std::string logs) {
+		if (logs.empty()) {
+			logs_.erase(iteration);
+		} else {
+			logs_[iteration] = std::move(logs);
+		}
+	}
+
+	void QaseParamResults::clear() {
+		tests_.clear();
+		iterations_.clear();
+		strings_.clear();
+		string_ids_.clear();
+		set_data_.clear();
+		set_offsets_.assign(1, 0);
+		set_ids_.clear();
+		logs_.clear();
+	}
+
+	uint32_t qase_reporter_define_test(std::string_view name, QaseResultMeta meta) {
+		return collected_params.define_test(name, std::move(meta));
+	}
+
+	void qase_reporter_add_param_result(uint32_t test, bool passed, const QaseFields& params) {
+		collected_params.add(test, passed, params);
+		journal_end_test();
+
+		// iterations don't carry a memory profile
+		memory_profile_end();
+
+		// steps aren't kept per iteration, logs are like for plain results
+		step_recorder.clear();
+		if (log_capture.active) {
+			std::string logs = stop_log_capture();
+			if (!passed || !log_capture.failed_only) {
+				collected_params.set_logs(collected_params.size() - 1, std::move(logs));
+			}
+		}
+	}
+
+	const QaseParamResults& qase_reporter_get_param_results() {
+		return collected_params;
+	}
+
+	// ========= TEST REGISTRY =======
+
+	// a function-local static, so registration works whatever the order of static initialization
+	static std::vector<QaseRegisteredTest>& test_registry() {
+		static std::vector<QaseRegisteredTest> tests;
+		return tests;
+	}
+
+	bool qase_register_test(std::string_view name, void (*func)(), QaseResultMeta meta) {
+		if (name.empty() || !func) {
+			throw std::invalid_argument("Registered test needs a name and a function");
+		}
+		test_registry().push_back({std::string(name), func, std::move(meta)});
+		return true;
+	}
+
+	const std::vector<QaseRegisteredTest>& qase_registered_tests() {
+		return test_registry();
+	}
+
+	// what the last run knows about a test
+	struct TestHistory {
+		// consecutive runs the test failed in, 0 if it passed last time
+		uint32_t failures = 0;
+		int64_t duration_us = 0;
+	};
+
+#ifndef ESP_PLATFORM
+	// one line per test: "<consecutive failures> <duration in us> <name>"
+	static std::unordered_map<std::string, TestHistory> load_test_history(const std::string& path) {
+		std::unordered_map<std::string, TestHistory> history;
+		std::ifstream in(path);
+		std::string line;
+		while (std::getline(in, line)) {
+			char* end;
+			TestHistory entry;
+			entry.failures = static_cast<uint32_t>(std::strtoul(line.c_str(), &end, 10));
+			entry.duration_us = std::strtoll(end, &end, 10);
+			if (*end == ' ' && end[1] != '\0') {
+				history[end + 1] = entry;
+			}
+		}
+		return history;
+	}
+
+	// written aside and renamed over, like the delta state
+	static void save_test_history(const std::string& path, const std::unordered_map<std::string, TestHistory>& history) {
+		const std::string tmp_path = path + ".tmp";
+		{
+			std::ofstream out(tmp_path, std::ios::trunc);
+			for (const auto& [name, entry] : history) {
+				out << entry.failures << ' ' << entry.duration_us << ' ' << name << '\n';
+			}
+			if (!out) {
+				throw std::runtime_error("Failed to write test history: " + tmp_path);
+			}
+		}
+		if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+			throw std::runtime_error("Failed to replace test history: " + path);
+		}
+	}
+#endif
+
+	// how a registered test went in this run
+	struct TestOutcome {
+		bool ran = false;
+		bool passed = false;
+		int64_t duration_us = 0;
+	};
+
+	static void run_tests_in_order(const std::vector<QaseRegisteredTest>& tests, const std::vector<std::size_t>& order,
+			const QaseTestInvoker& invoke, const QaseTestRunOptions& options, std::vector<TestOutcome>& outcomes) {
+		int failed = 0;
+		for (std::size_t index : order) {
+			const QaseRegisteredTest& test = tests[index];
+
+			qase_reporter_begin_test(test.name);
+			const auto start = std::chrono::steady_clock::now();
+			const bool passed = invoke(test);
+			const auto duration = std::chrono::steady_clock::now() - start;
+			qase_reporter_add_result(test.name, passed, test.meta);
+
+			outcomes[index] = {true, passed, std::chrono::duration_cast<std::chrono::microseconds>(duration).count()};
+			if (!passed && ++failed == options.max_failures) {
+				break;
+			}
+		}
+	}
+
+	// ========= PARALLEL TEST WORKERS =======
+#ifndef ESP_PLATFORM
+	// the workers are forked from the runner and share one MAP_SHARED region with it: a header,
+	// a ParallelWorker per worker, a ParallelSlot per registered test, then the arena the
+	// results are copied into, encoded as the memory budget segment records them
+	// tests are dealt round-robin in run order, so every worker starts with the likely
+	// failures; a worker that runs out steals from the back of the others' queues
+
+	static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<int64_t>::is_always_lock_free,
+		"worker processes share the atomics of the result region");
+
+	enum ParallelSlotState : uint32_t {
+		slot_pending,
+		slot_running,
+		slot_done,
+	};
+
+	struct ParallelSlot {
+		std::atomic<uint32_t> state{slot_pending};
+		uint32_t passed = 0;
+		int64_t duration_us = 0;
+
+		// encoded result in the arena, size 0 if it didn't fit
+		uint64_t record_offset = 0;
+		uint64_t record_size = 0;
+	};
+
+	struct alignas(64) ParallelWorker {
+		// the worker's share of the run order is positions `worker + k * workers` for k in
+		// [low, high), low in the lower half and high in the upper one; the worker takes
+		// from low, thieves take from high, both with one compare-exchange
+		std::atomic<uint64_t> queue{0};
+
+		// slot of the test it is running, -1 between tests
+		std::atomic<int64_t> running{-1};
+	};
+
+	struct ParallelHeader {
+		std::atomic<int> failed{0};
+		std::atomic<uint64_t> arena_used{0};
+	};
+
+	class ParallelRegion {
+	public:
+		ParallelRegion(std::size_t workers, std::size_t tests, std::size_t arena_size) {
+			workers_offset_ = align(sizeof(ParallelHeader));
+			slots_offset_ = align(workers_offset_ + workers * sizeof(ParallelWorker));
+			arena_offset_ = align(slots_offset_ + tests * sizeof(ParallelSlot));
+			arena_size_ = arena_size;
+			size_ = arena_offset_ + arena_size;
+
+			// pages of the arena no result reaches are never touched
+			void* memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+			if (memory == MAP_FAILED) {
+				throw std::runtime_error(std::string("Could not map the worker result region: ") + std::strerror(errno));
+			}
+			base_ = static_cast<uint8_t*>(memory);
+
+			new (base_) ParallelHeader();
+			for (std::size_t i = 0; i < workers; ++i) {
+				new (&worker(i)) ParallelWorker();
+			}
+			for (std::size_t i = 0; i < tests; ++i) {
+				new (&slot(i)) ParallelSlot();
+			}
+		}
+
+		~ParallelRegion() { munmap(base_, size_); }
+
+		ParallelRegion(const ParallelRegion&) = delete;
+		ParallelRegion& operator=(const ParallelRegion&) = delete;
+
+		ParallelHeader& header() { return *reinterpret_cast<ParallelHeader*>(base_); }
+		ParallelWorker& worker(std::size_t i) { return reinterpret_cast<ParallelWorker*>(base_ + workers_offset_)[i]; }
+		ParallelSlot& slot(std::size_t i) { return reinterpret_cast<ParallelSlot*>(base_ + slots_offset_)[i]; }
+
+		// copies a record into the arena, false once it's full
+		bool store(ParallelSlot& slot, const std::string& record) {
+			const uint64_t offset = header().arena_used.fetch_add(record.size());
+			if (record.size() > arena_size_ || offset > arena_size_ - record.size()) {
+				return false;
+			}
+			std::memcpy(base_ + arena_offset_ + offset, record.data(), record.size());
+			slot.record_offset = offset;
+			slot.record_size = record.size();
+			return true;
+		}
+
+		std::string record(const ParallelSlot& slot) const {
+			return std::string(reinterpret_cast<const char*>(base_ + arena_offset_ + slot.record_offset), slot.record_size);
+		}
+
+	private:
+		static std::size_t align(std::size_t offset) { return (offset + 63) & ~std::size_t(63); }
+
+		uint8_t* base_ = nullptr;
+		std::size_t size_ = 0;
+		std::size_t workers_offset_ = 0;
+		std::size_t slots_offset_ = 0;
+		std::size_t arena_offset_ = 0;
+		std::size_t arena_size_ = 0;
+	};
+
+	// takes k from the front of a worker queue, or from the back when stealing; -1 if it's empty
+	static int64_t take_queued(ParallelWorker& worker, bool steal) {
+		uint64_t queue = worker.queue.load();
+		for (;;) {
+			const uint32_t low = static_cast<uint32_t>(queue);
+			const uint32_t high = static_cast<uint32_t>(queue >> 32);
+			if (low >= high) {
+				return -1;
+			}
+			const uint64_t next = steal
+				? static_cast<uint64_t>(high - 1) << 32 | low
+				: static_cast<uint64_t>(high) << 32 | (low + 1);
+			if (worker.queue.compare_exchange_weak(queue, next)) {
+				return steal ? high - 1 : low;
+			}
+		}
+	}
+
+	// position in the run order of the next test for worker `self`, -1 once every queue is empty
+	static int64_t next_parallel_test(ParallelRegion& region, std::size_t self, std::size_t workers) {
+		for (std::size_t i = 0; i < workers; ++i) {
+			const std::size_t victim = (self + i) % workers;
+			const int64_t k = take_queued(region.worker(victim), i > 0);
+			if (k >= 0) {
+				return static_cast<int64_t>(victim + static_cast<std::size_t>(k) * workers);
+			}
+		}
+		return -1;
+	}
+
+	static bool parallel_work_left(ParallelRegion& region, std::size_t workers) {
+		for (std::size_t i = 0; i < workers; ++i) {
+			const uint64_t queue = region.worker(i).queue.load();
+			if (static_cast<uint32_t>(queue) < static_cast<uint32_t>(queue >> 32)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// fails the test a worker is running when it threw, with `message` as the result log
+	static void fail_running_test(ParallelRegion& region, ParallelWorker& worker,
+			const std::vector<QaseRegisteredTest>& tests, const std::string& message) noexcept {
+		const int64_t running = worker.running.load();
+		if (running < 0) {
+			return;
+		}
+		ParallelSlot& slot = region.slot(static_cast<std::size_t>(running));
+		if (slot.state.load() == slot_done) {
+			return;
+		}
+
+		// without a record the runner still fails the test, only the log is lost
+		try {
+			TestResult result;
+			result.name = tests[static_cast<std::size_t>(running)].name;
+			result.meta = tests[static_cast<std::size_t>(running)].meta;
+			result.logs = message;
+			std::string record;
+			encode_spilled_result(record, result);
+			region.store(slot, record);
+		} catch (...) {
+		}
+
+		slot.passed = 0;
+		slot.state.store(slot_done);
+		worker.running.store(-1);
+		region.header().failed.fetch_add(1);
+	}
+
+	// body of a forked worker: runs tests until there are none left, never returns
+	// a test that throws fails, and the worker exits so the runner replaces it
+	[[noreturn]] static void parallel_worker_main(ParallelRegion& region, std::size_t self, std::size_t workers,
+			const std::vector<QaseRegisteredTest>& tests, const std::vector<std::size_t>& order,
+			const QaseTestInvoker& invoke, const QaseTestRunOptions& options) {
+		parallel_worker = true;
+
+		// the journal belongs to the parent; a crash here kills the worker and the parent
+		// records it against the running test
+		if (crash_journal.fd >= 0) {
+			restore_crash_signals();
+		}
+		crash_journal.encoder.reset();
+		crash_journal.test_name_size.store(0);
+
+		ParallelWorker& worker = region.worker(self);
+		int status = 0;
+		try {
+			for (;;) {
+				if (options.max_failures > 0 && region.header().failed.load() >= options.max_failures) {
+					break;
+				}
+				const int64_t position = next_parallel_test(region, self, workers);
+				if (position < 0) {
+					break;
+				}
+				const std::size_t index = order[static_cast<std::size_t>(position)];
+				const QaseRegisteredTest& test = tests[index];
+				ParallelSlot& slot = region.slot(index);
+				worker.running.store(static_cast<int64_t>(index));
+				slot.state.store(slot_running);
+
+				qase_reporter_begin_test(test.name);
+				const auto start = std::chrono::steady_clock::now();
+				const bool passed = invoke(test);
+				const auto duration = std::chrono::steady_clock::now() - start;
+				qase_reporter_add_result(test.name, passed, test.meta);
+
+				std::string record;
+				encode_spilled_result(record, collected.back());
+				collected.clear();
+				region.store(slot, record);
+
+				slot.passed = passed ? 1 : 0;
+				slot.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+				slot.state.store(slot_done);
+				worker.running.store(-1);
+				if (!passed) {
+					region.header().failed.fetch_add(1);
+				}
+			}
+		} catch (const std::exception& e) {
+			fail_running_test(region, worker, tests, std::string("Threw an exception: ") + e.what());
+			status = 1;
+		} catch (...) {
+			fail_running_test(region, worker, tests, "Threw an exception");
+			status = 1;
+		}
+
+		// static destructors belong to the parent, e.g. the observer thread isn't running here
+		shutdown_stream_capture();
+		std::cout.flush();
+		std::fflush(nullptr);
+		_exit(status);
+	}
+
+	// a pipe that tests exec'ing other programs don't pass on
+	static int pipe_cloexec(int fds[2]) {
+#ifdef __APPLE__
+		if (pipe(fds) != 0) {
+			return -1;
+		}
+		fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+		fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+		return 0;
+#else
+		return pipe2(fds, O_CLOEXEC);
+#endif
+	}
+
+	// result log of a test whose worker died while running it
+	static std::string worker_exit_message(int status) {
+		if (WIFSIGNALED(status)) {
+			const int sig = WTERMSIG(status);
+			const char* name = crash_signal_name(sig);
+			return std::string("Crashed with ") + (std::strcmp(name, "signal") == 0 ? "signal " + std::to_string(sig) : name);
+		}
+		return "Worker exited with status " + std::to_string(WEXITSTATUS(status));
+	}
+
+	static void run_tests_in_workers(const std::vector<QaseRegisteredTest>& tests, const std::vector<std::size_t>& order,
+			const QaseTestInvoker& invoke, const QaseTestRunOptions& options, std::vector<TestOutcome>& outcomes) {
+		const std::size_t workers = std::min(static_cast<std::size_t>(options.workers), order.size());
+		if (workers == 0) {
+			return;
+		}
+
+		// no drain thread may hold the log capture mutex across a fork
+		shutdown_stream_capture();
+
+		ParallelRegion region(workers, tests.size(), options.result_region_size);
+		for (std::size_t i = 0; i < workers; ++i) {
+			const uint64_t count = (order.size() - i + workers - 1) / workers;
+			region.worker(i).queue.store(count << 32);
+		}
+
+		// a worker holds the write end of its pipe until it exits, so the read end
+		// polls as hung up once it's gone, whatever else this process forked
+		struct WorkerProcess {
+			pid_t pid = -1;
+			int pipe = -1;
+		};
+		std::vector<WorkerProcess> processes(workers);
+
+		auto spawn = [&](std::size_t self) {
+			int fds[2];
+			if (pipe_cloexec(fds) != 0) {
+				throw std::runtime_error(std::string("Could not create a worker pipe: ") + std::strerror(errno));
+			}
+			// buffered output would be written again by the child
+			std::cout.flush();
+			std::fflush(nullptr);
+			const pid_t pid = fork();
+			if (pid < 0) {
+				close(fds[0]);
+				close(fds[1]);
+				throw std::runtime_error(std::string("Could not fork a test worker: ") + std::strerror(errno));
+			}
+			if (pid == 0) {
+				close(fds[0]);
+				parallel_worker_main(region, self, workers, tests, order, invoke, options);
+			}
+			close(fds[1]);
+			processes[self] = {pid, fds[0]};
+		};
+
+		// the test each worker died in, with the message it fails with
+		std::vector<std::string> crashes(tests.size());
+
+		// how the last worker that died between tests went, see the claimed tests below
+		std::string between_tests_exit;
+
+		for (std::size_t i = 0; i < workers; ++i) {
+			spawn(i);
+		}
+		for (;;) {
+			std::vector<pollfd> fds;
+			std::vector<std::size_t> owners;
+			for (std::size_t i = 0; i < workers; ++i) {
+				if (processes[i].pid > 0) {
+					fds.push_back({processes[i].pipe, POLLIN, 0});
+					owners.push_back(i);
+				}
+			}
+			if (fds.empty()) {
+				break;
+			}
+			if (poll(fds.data(), fds.size(), -1) < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				throw std::runtime_error(std::string("Could not wait for the test workers: ") + std::strerror(errno));
+			}
+
+			for (std::size_t j = 0; j < fds.size(); ++j) {
+				if (fds[j].revents == 0) {
+					continue;
+				}
+				const std::size_t self = owners[j];
+				int status = 0;
+				while (waitpid(processes[self].pid, &status, 0) < 0 && errno == EINTR) {
+				}
+				close(processes[self].pipe);
+				processes[self] = {};
+
+				ParallelWorker& worker = region.worker(self);
+				const int64_t running = worker.running.exchange(-1);
+				if (running >= 0 && region.slot(static_cast<std::size_t>(running)).state.load() != slot_done) {
+					ParallelSlot& slot = region.slot(static_cast<std::size_t>(running));
+					slot.passed = 0;
+					slot.state.store(slot_done);
+					region.header().failed.fetch_add(1);
+					crashes[static_cast<std::size_t>(running)] = worker_exit_message(status);
+				} else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+					between_tests_exit = worker_exit_message(status);
+				}
+
+				// the rest of its queue goes to a fresh worker rather than waiting to be stolen
+				const bool clean_exit = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+				const bool stopped = options.max_failures > 0 && region.header().failed.load() >= options.max_failures;
+				if (!clean_exit && !stopped && parallel_work_left(region, workers)) {
+					spawn(self);
+				}
+			}
+		}
+
+		// a worker publishes `running` just after taking a test off a queue; one that died in
+		// between leaves a test that is neither queued nor done, and it fails like a crash
+		std::vector<char> queued(order.size(), 0);
+		for (std::size_t i = 0; i < workers; ++i) {
+			const uint64_t queue = region.worker(i).queue.load();
+			for (uint64_t k = static_cast<uint32_t>(queue); k < (queue >> 32); ++k) {
+				queued[i + k * workers] = 1;
+			}
+		}
+		for (std::size_t position = 0; position < order.size(); ++position) {
+			ParallelSlot& slot = region.slot(order[position]);
+			if (queued[position] || slot.state.load() == slot_done) {
+				continue;
+			}
+			slot.passed = 0;
+			slot.state.store(slot_done);
+			region.header().failed.fetch_add(1);
+			crashes[order[position]] = !between_tests_exit.empty() ? between_tests_exit : "Worker exited before reporting the test";
+		}
+
+		// recorded in registration order, whichever worker ran what and when
+		for (std::size_t index = 0; index < tests.size(); ++index) {
+			ParallelSlot& slot = region.slot(index);
+			if (slot.state.load() != slot_done) {
+				continue;
+			}
+			const QaseRegisteredTest& test = tests[index];
+
+			TestResult& result = collected.emplace_back();
+			if (slot.record_size == 0 || !decode_spilled_result(region.record(slot), result)) {
+				result = TestResult();
+				result.name = test.name;
+				result.passed = slot.passed != 0;
+				result.meta = test.meta;
+			}
+			if (!crashes[index].empty()) {
+				result.logs = crashes[index];
+			}
+			complete_result(result);
+
+			outcomes[index] = {true, slot.passed != 0, slot.duration_us};
+		}
+	}
+#endif
+
+	QaseTestRunSummary qase_run_registered_tests(const QaseTestInvoker& invoke, const QaseTestRunOptions& options) {
+		const std::vector<QaseRegisteredTest>& tests = test_registry();
+
+		std::unordered_map<std::string, TestHistory> history;
+#ifndef ESP_PLATFORM
+		if (!options.history_path.empty()) {
+			history = load_test_history(options.history_path);
+		}
+#endif
+
+		// failed last time (the longer the streak, the earlier), then unknown, then passed;
+		// the quicker test first within each group, registration order on ties
+		auto rank = [&history](const QaseRegisteredTest& test) {
+			auto known = history.find(test.name);
+			if (known == history.end()) {
+				return std::make_tuple(1, int64_t(0), int64_t(0));
+			}
+			const TestHistory& entry = known->second;
+			return entry.failures > 0
+				? std::make_tuple(0, -int64_t(entry.failures), entry.duration_us)
+				: std::make_tuple(2, int64_t(0), entry.duration_us);
+		};
+
+		std::vector<std::size_t> order(tests.size());
+		for (std::size_t i = 0; i < order.size(); ++i) {
+			order[i] = i;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+			return rank(tests[a]) < rank(tests[b]);
+		});
+
+		std::vector<TestOutcome> outcomes(tests.size());
+#ifndef ESP_PLATFORM
+		if (options.workers > 1) {
+			run_tests_in_workers(tests, order, invoke, options, outcomes);
+		} else
+#endif
+		{
+			run_tests_in_order(tests, order, invoke, options, outcomes);
+		}
+
+		QaseTestRunSummary summary;
+		for (std::size_t index = 0; index < tests.size(); ++index) {
+			const TestOutcome& outcome = outcomes[index];
+			if (!outcome.ran) {
+				continue;
+			}
+			++summary.run;
+			summary.failed += outcome.passed ? 0 : 1;
+
+			TestHistory& entry = history[tests[index].name];
+			entry.failures = outcome.passed ? 0 : entry.failures + 1;
+			entry.duration_us = outcome.duration_us;
+		}
+
+#ifndef ESP_PLATFORM
+		if (!options.history_path.empty()) {
+			save_test_history(options.history_path, history);
+		}
+#endif
+		return summary;
+	}
+
+	// turns flat steps into a nested json array, make_node(step, index, position) builds one node
+	// steps are in start order and every step's descendants follow it directly,
+	// so a single pass starting at `next` collects the children of `parent`
+	template <typename MakeNode>
+	static json nest_steps(const std::vector<QaseStep>& steps, std::size_t& next, int parent, const MakeNode& make_node) {
+		json nodes = json::array();
+		while (next < steps.size() && steps[next].parent == parent) {
+			const std::size_t index = next++;
+			json node = make_node(steps[index], index, nodes.size() + 1);
+
+			json children = nest_steps(steps, next, static_cast<int>(index), make_node);
+			if (!children.empty()) {
+				node["steps"] = std::move(children);
+			}
+			nodes.push_back(std::move(node));
+		}
+		return nodes;
+	}
+
+	template <typename MakeNode>
+	static json nest_steps(const std::vector<QaseStep>& steps, const MakeNode& make_node) {
+		std::size_t next = 0;
+		return nest_steps(steps, next, -1, make_node);
+	}
+
+	// results are serialized from contiguous storage or from a selection of pointers to them
+	static const TestResult& result_ref(const TestResult& result) { return result; }
+	static const TestResult& result_ref(const TestResult* result) { return *result; }
+
+	// memory profile of a result as number fields, next to its custom fields
+	static void add_memory_fields(json& target, const QaseMemoryProfile& memory) {
+		if (!memory.recorded) {
+			return;
+		}
+		if (memory.allocations >= 0) {
+			target["memory_allocations"] = memory.allocations;
+			target["memory_bytes"] = memory.bytes;
+		}
+		target["memory_peak_rss_delta_kb"] = memory.peak_rss_delta_kb;
+	}
+
+	// result entry of a bulk payload
+	static json result_entry(const TestResult& result, const QaseAttachmentHashes* attachment_hashes) {
+		json entry;
+		json case_json;
+
+		// use title from meta if provided, else - result.name
+		if (!result.meta.title.empty()) {
+			case_json["title"] = result.meta.title;
+		} else {
+			case_json["title"] = result.name;
+		}
+
+		// add case_id if set
+		if (result.meta.case_id > 0) {
+			case_json["case_id"] = result.meta.case_id;
+		}
+
+		// add custom fields if present
+		for (const auto& kv : result.meta.fields) {
+			case_json[kv.first] = kv.second;
+		}
+		add_memory_fields(case_json, result.memory);
+
+		entry["case"] = case_json;
+		entry["status"] = result.passed ? "passed" : "failed";
+
+		// captured stdout/stderr goes to the result comment
+		if (!result.logs.empty()) {
+			entry["comment"] = result.logs;
+		}
+
+		// the api has no step timing, the duration goes to the step comment
+		if (!result.steps.empty()) {
+			entry["steps"] = nest_steps(result.steps, [](const QaseStep& step, std::size_t, std::size_t position) {
+				return json{
+					{"position", position},
+					{"action", step.name},
+					{"status", step.passed ? "passed" : "failed"},
+					{"comment", "Took " + std::to_string(step.duration_us / 1000) + " ms"}
+				};
+			});
+		}
+
+		// attachments are referenced by the hashes they were uploaded with
+		if (attachment_hashes && !result.meta.attachments.empty()) {
+			json hashes = json::array();
+			for (const auto& path : result.meta.attachments) {
+				auto it = attachment_hashes->find(path);
+				if (it != attachment_hashes->end()) {
+					hashes.push_back(it->second);
+				}
+			}
+			entry["attachments"] = hashes;
+		}
+
+		return entry;
+	}
+
+	// serializes `count` results starting at `first`, one bulk payload
+	template <typename It>
+	static std::string serialize_results(It first, std::size_t count, const QaseAttachmentHashes* attachment_hashes) {
+		json root;
+		root["results"] = json::array();
+
+		for (It it = first; it != first + count; ++it) {
+			root["results"].push_back(result_entry(result_ref(*it), attachment_hashes));
+		}
+
+		return root.dump();
+	}
+
+	std::string qase_serialize_results(const std::vector<TestResult>& collected, const QaseAttachmentHashes* attachment_hashes) {
+		return serialize_results(collected.data(), collected.size(), attachment_hashes);
+	}
+
+#ifndef ESP_PLATFORM
+	QaseResultObserver qase_fd_observer(int fd) {
+		return [fd](const TestResult& result) {
+			const std::string line = result_entry(result, nullptr).dump() + "\n";
+
+			std::size_t written = 0;
+			while (written < line.size()) {
+				ssize_t n = write(fd, line.data() + written, line.size() - written);
+				if (n < 0 && errno == EINTR) {
+					continue;
+				}
+				if (n < 0) {
+					throw std::runtime_error(std::string("Could not write result: ") + std::strerror(errno));
+				}
+				written += static_cast<std::size_t>(n);
+			}
+		};
+	}
+#endif
+
+	// serializes `count` iterations starting at `first`, one bulk payload
+	static std::string serialize_param_results(const QaseParamResults& results, std::size_t first, std::size_t count) {
+		json root;
+		root["results"] = json::array();
+
+		// the case title and fields go with the first iteration of each test only
+		std::vector<char> described(results.tests().size(), 0);
+
+		for (std::size_t i = first; i < first + count; ++i) {
+			const QaseParamResults::Iteration& iteration = results.iterations()[i];
+			const QaseParamResults::Test& test = results.tests()[iteration.test];
+			json entry;
+			json case_json;
+
+			if (test.meta.case_id > 0) {
+				case_json["case_id"] = test.meta.case_id;
+			}
+			if (test.meta.case_id <= 0 || !described[iteration.test]) {
+				case_json["title"] = !test.meta.title.empty() ? test.meta.title : test.name;
+			}
+			if (!described[iteration.test]) {
+				for (const auto& kv : test.meta.fields) {
+					case_json[kv.first] = kv.second;
+				}
+				described[iteration.test] = 1;
+			}
+
+			entry["case"] = std::move(case_json);
+			entry["status"] = iteration.passed ? "passed" : "failed";
+
+			json params = json::object();
+			results.for_each_param(iteration.params, [&params](std::string_view key, std::string_view value) {
+				params[std::string(key)] = value;
+			});
+			entry["param"] = std::move(params);
+
+			const std::string& logs = results.logs(i);
+			if (!logs.empty()) {
+				entry["comment"] = logs;
+			}
+
+			root["results"].push_back(std::move(entry));
+		}
+
+		return root.dump();
+	}
+
+	std::string qase_serialize_param_results(const QaseParamResults& results) {
+		return serialize_param_results(results, 0, results.size());
+	}
+
+	// helper: builds vector of headers for the specified token
+	std::vector<std::string> make_headers(const std::string& token, const std::string& content_type = "application/json") {
+		return {
+			"accept: application/json",
+			"content-type: " + content_type,
+			"Token: " + token
+		};
+	}
+
+	std::string HttpClient::post_stream(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers) {
+		std::string buffered;
+		buffered.reserve(body.size());
+
+		char chunk[4096];
+		while (std::size_t n = body.read(chunk, sizeof(chunk))) {
+			buffered.append(chunk, n);
+		}
+		return post(url, buffered, headers);
+	}
+
+	HttpResponse HttpClient::post_with_response(const std::string& url, const std::string& body, const std::vector<std::string>& headers) {
+		HttpResponse response;
+		response.body = post(url, body, headers);
+		return response;
+	}
+
+	HttpResponse HttpClient::post_stream_with_response(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers) {
+		HttpResponse response;
+		response.body = post_stream(url, body, headers);
+		return response;
+	}
+
+	// ========= RATE LIMITING =======
+
+	template <typename Rep, typename Period>
+	static QaseRateLimiter::clock::duration to_clock_duration(std::chrono::duration<Rep, Period> d) {
+		return std::chrono::duration_cast<QaseRateLimiter::clock::duration>(d);
+	}
+
+	void QaseRateLimiter::set_limits(double requests_per_sec, double bytes_per_sec) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (requests_per_sec == requests_per_sec_ && bytes_per_sec == bytes_per_sec_) {
+			return;
+		}
+		requests_per_sec_ = requests_per_sec;
+		bytes_per_sec_ = bytes_per_sec;
+		backoff_ = 1.0;
+		requests_tat_ = bytes_tat_ = clock::time_point{};
+	}
+
+	QaseRateLimiter::clock::time_point QaseRateLimiter::reserve(std::size_t bytes, clock::time_point now) {
+		using seconds = std::chrono::duration<double>;
+		const auto burst = to_clock_duration(seconds(1));
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// a request conforms once the bucket's arrival time is within one burst of it
+		clock::time_point start = std::max(now, paused_until_);
+		if (requests_per_sec_ > 0) {
+			start = std::max(start, requests_tat_ - burst);
+		}
+		if (bytes_per_sec_ > 0) {
+			start = std::max(start, bytes_tat_ - burst);
+		}
+
+		if (requests_per_sec_ > 0) {
+			requests_tat_ = std::max(requests_tat_, start) + to_clock_duration(seconds(1.0 / (requests_per_sec_ * backoff_)));
+		}
+		if (bytes_per_sec_ > 0) {
+			bytes_tat_ = std::max(bytes_tat_, start) + to_clock_duration(seconds(bytes / bytes_per_sec_));
+		}
+		return start;
+	}
+
+	void QaseRateLimiter::acquire(std::size_t bytes) {
+		const clock::time_point start = reserve(bytes, clock::now());
+		std::this_thread::sleep_until(start);
+	}
+
+	void QaseRateLimiter::throttled(clock::time_point until) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		paused_until_ = std::max(paused_until_, until);
+		backoff_ = std::max(min_backoff, backoff_ / 2);
+	}
+
+	void QaseRateLimiter::succeeded() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		backoff_ = std::min(1.0, backoff_ + min_backoff);
+	}
+
+	QaseRateLimiter& qase_rate_limiter() {
+		static QaseRateLimiter limiter;
+		return limiter;
+	}
+
+	static std::optional<std::string> find_header(const HttpResponse& response, std::string_view name) {
+		for (const auto& header : response.headers) {
+			const std::size_t colon = header.find(':');
+			if (colon != name.size()) {
+				continue;
+			}
+
+			bool same = true;
+			for (std::size_t i = 0; i < colon && same; ++i) {
+				same = std::tolower(static_cast<unsigned char>(header[i])) == std::tolower(static_cast<unsigned char>(name[i]));
+			}
+			if (same) {
+				const std::size_t value = header.find_first_not_of(" \t", colon + 1);
+				return value == std::string::npos ? std::string() : header.substr(value);
+			}
+		}
+		return std::nullopt;
+	}
+
+	static bool is_throttled(const HttpResponse& response) {
+		return response.status == 429 || (response.status == 503 && find_header(response, "Retry-After"));
+	}
+
+	// how long to wait after a throttled response: Retry-After in seconds or as an
+	// HTTP date, otherwise exponential backoff from one second
+	static QaseRateLimiter::clock::duration retry_delay(const HttpResponse& response, int attempt) {
+		if (auto retry_after = find_header(response, "Retry-After")) {
+			char* end = nullptr;
+			const long seconds = std::strtol(retry_after->c_str(), &end, 10);
+			if (end != retry_after->c_str() && seconds >= 0) {
+				return to_clock_duration(std::chrono::seconds(seconds));
+			}
+
+#ifndef ESP_PLATFORM
+			std::tm tm{};
+			if (strptime(retry_after->c_str(), "%a, %d %b %Y %H:%M:%S", &tm)) {
+				const auto at = std::chrono::system_clock::from_time_t(timegm(&tm));
+				const auto wait = at - std::chrono::system_clock::now();
+				return to_clock_duration(std::max(wait, std::chrono::system_clock::duration::zero()));
+			}
+#endif
+		}
+
+		return to_clock_duration(std::chrono::seconds(1 << std::min(attempt, 5)));
+	}
+
+	// sends a request through the process-wide rate limiter and resends it while Qase throttles
+	// send(attempt) performs one request
+	template <typename Send>
+	static std::string send_paced(const QaseConfig& cfg, std::size_t bytes, Send send) {
+		QaseRateLimiter& limiter = qase_rate_limiter();
+		limiter.set_limits(cfg.rate_limit_requests_per_sec, cfg.rate_limit_bytes_per_sec);
+
+		for (int attempt = 0;; ++attempt) {
+			limiter.acquire(bytes);
+			HttpResponse response = send(attempt);
+
+			if (!is_throttled(response)) {
+				limiter.succeeded();
+				return std::move(response.body);
+			}
+
+			if (attempt >= cfg.rate_limit_max_retries) {
+				throw std::runtime_error("Qase API error: rate limited, gave up after " + std::to_string(attempt + 1) + " attempts");
+			}
+			limiter.throttled(QaseRateLimiter::clock::now() + retry_delay(response, attempt));
+		}
+	}
+
+	static std::string post_paced(HttpClient& http, const QaseConfig& cfg, const std::string& url,
+			const std::string& body, const std::vector<std::string>& headers) {
+		return send_paced(cfg, body.size(), [&](int) {
+			return http.post_with_response(url, body, headers);
+		});
+	}
+
+	// a host with a scheme is taken as is, e.g. "http://127.0.0.1:8080" for a local mock server
+	inline std::string qase_api_base(const QaseConfig& cfg) {
+		if (cfg.host.find("://") != std::string::npos) {
+			return cfg.host + "/v1/";
+		}
+		return "https://" + cfg.host + "/v1/";
+	}
+
+	// qase_start_run should call Qase API and return new test run
+	// the run holds only the given cases (and the plan's, if set) unless cfg.include_all_cases
+	uint64_t QaseApi::qase_start_run(HttpClient& http, const QaseConfig& cfg, const std::vector<int>& case_ids) {
+		const std::string url = qase_api_base(cfg) + "run/" + cfg.project;
+		nlohmann::json payload;
+		payload["title"] = cfg.run_title;
+
+		payload["include_all_cases"] = cfg.include_all_cases;
+		if (!cfg.include_all_cases && !case_ids.empty()) {
+			payload["cases"] = case_ids;
+		}
+
+		if (cfg.plan_id > 0) {
+			payload["plan_id"] = cfg.plan_id;
+		}
+
+		if (!cfg.run_description.empty()) {
+			payload["description"] = cfg.run_description;
+		}
+
+		const auto headers = make_headers(cfg.token);
+
+		std::string response = post_paced(http, cfg, url, payload.dump(), headers);
+		auto json = nlohmann::json::parse(response);
+
+		check_qase_api_error(json);
+
+		// extract result.id if present
+		if (json.contains("result") && json["result"].contains("id")) {
+			return json["result"]["id"].get<uint64_t>();
+		}
+
+		throw std::runtime_error("Qase API response missing result.id field");
+	}
+
+	bool QaseApi::qase_submit_results(HttpClient& http, const QaseConfig& cfg, uint64_t run_id, const std::string& payload) {
+
+		const std::string url = qase_api_base(cfg) + "result/" + cfg.project + "/" + std::to_string(run_id) + "/bulk";
+		const auto headers = make_headers(cfg.token);
+
+		std::string response = post_paced(http, cfg, url, payload, headers);
+		auto json = nlohmann::json::parse(response);
+
+		check_qase_api_error(json);
+
+		return json.contains("status") && json["status"] == true;
+
+	}
+
+	bool QaseApi::qase_complete_run(HttpClient& http, const QaseConfig& cfg, uint64_t run_id) {
+
+		const std::string url = qase_api_base(cfg) + "run/" + cfg.project + "/" + std::to_string(run_id) + "/complete";
+
+		const auto headers = make_headers(cfg.token);
+
+		std::string response = post_paced(http, cfg, url, "", headers);
+		auto json = nlohmann::json::parse(response);
+
+		check_qase_api_error(json);
+
+		return json.contains("status") && json["status"] == true;
+
+	}
+
+	// ========= ATTACHMENT UPLOADS ARE NOT AVAILABLE ON ESP32 =======
+	#ifndef ESP_PLATFORM
+	static std::string attachment_mime_type(const std::string& path) {
+		const std::string ext = std::filesystem::path(path).extension().string();
+		if (ext == ".txt" || ext == ".log") return "text/plain";
+		if (ext == ".json") return "application/json";
+		if (ext == ".png") return "image/png";
+		if (ext == ".jpg" || ext == ".jpeg") return "image/jpeg";
+		return "application/octet-stream";
+	}
+
+	// read-only memory mapping of a whole file, read front to back
+	// release_until() drops pages that were already consumed, so resident memory
+	// stays flat no matter how big the file is
+	class MappedFile {
+	public:
+		explicit MappedFile(const std::string& path, int advice = MADV_SEQUENTIAL) {
+			fd_ = open(path.c_str(), O_RDONLY);
+			if (fd_ < 0) {
+				throw std::runtime_error("Could not open file: " + path);
+			}
+
+			struct stat st;
+			if (fstat(fd_, &st) != 0) {
+				close(fd_);
+				throw std::runtime_error("Could not stat file: " + path);
+			}
+			size_ = static_cast<std::size_t>(st.st_size);
+
+			if (size_ > 0) {
+				void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+				if (mapped == MAP_FAILED) {
+					close(fd_);
+					throw std::runtime_error("Could not map file: " + path);
+				}
+				data_ = static_cast<const char*>(mapped);
+				madvise(mapped, size_, advice);
+			}
+		}
+
+		~MappedFile() {
+			if (data_) {
+				munmap(const_cast<char*>(data_), size_);
+			}
+			close(fd_);
+		}
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* data() const { return data_; }
+		std::size_t size() const { return size_; }
+
+		// releases the pages of [0, consumed) once enough of them piled up
+		void release_until(std::size_t consumed) {
+			static const std::size_t release_step = 4 * 1024 * 1024;
+
+			if (!data_ || (consumed - released_ < release_step && consumed < size_)) {
+				return;
+			}
+
+			const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+			const std::size_t end = std::min(consumed, size_) / page * page;
+			if (end > released_) {
+				madvise(const_cast<char*>(data_) + released_, end - released_, MADV_DONTNEED);
+				released_ = end;
+			}
+		}
+
+	private:
+		int fd_ = -1;
+		const char* data_ = nullptr;
+		std::size_t size_ = 0;
+		std::size_t released_ = 0;
+	};
+
+	uint64_t qase_hash_file(const std::string& path) {
+		static const std::size_t window = 4 * 1024 * 1024;
+
+		MappedFile file(path);
+		Xxh64 hasher(0);
+		for (std::size_t offset = 0; offset < file.size(); offset += window) {
+			const std::size_t n = std::min(window, file.size() - offset);
+			hasher.update(reinterpret_cast<const unsigned char*>(file.data()) + offset, n);
+			file.release_until(offset + n);
+		}
+		return hasher.digest();
+	}
+
+	static std::string hash_to_hex(uint64_t hash) {
+		char buf[17];
+		std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(hash));
+		return buf;
+	}
+
+	// multipart/form-data body with a single file part
+	// the file content is copied out of the mapping chunk by chunk
+	class MultipartFileBody : public HttpBodySource {
+	public:
+		MultipartFileBody(const std::string& path, const std::string& boundary) : file_(path) {
+			const std::string file_name = std::filesystem::path(path).filename().string();
+			head_ = "--" + boundary + "\r\n"
+				"Content-Disposition: form-data; name=\"file\"; filename=\"" + file_name + "\"\r\n"
+				"Content-Type: " + attachment_mime_type(path) + "\r\n\r\n";
+			tail_ = "\r\n--" + boundary + "--\r\n";
+		}
+
+		std::size_t size() const override {
+			return head_.size() + file_.size() + tail_.size();
+		}
+
+		std::size_t read(char* buf, std::size_t max) override {
+			std::size_t copied = 0;
+
+			copied += copy_part(head_.data(), head_.size(), 0, buf, max);
+			copied += copy_part(file_.data(), file_.size(), head_.size(), buf + copied, max - copied);
+			copied += copy_part(tail_.data(), tail_.size(), head_.size() + file_.size(), buf + copied, max - copied);
+
+			if (pos_ > head_.size()) {
+				file_.release_until(pos_ - head_.size());
+			}
+			return copied;
+		}
+
+		// pages already released are read back from the file
+		bool rewind() override {
+			pos_ = 0;
+			return true;
+		}
+
+	private:
+		// copies the part of [offset, offset + size) of the body that is not sent yet
+		std::size_t copy_part(const char* data, std::size_t size, std::size_t offset, char* buf, std::size_t max) {
+			if (max == 0 || pos_ < offset || pos_ >= offset + size) {
+				return 0;
+			}
+			const std::size_t n = std::min(max, offset + size - pos_);
+			std::memcpy(buf, data + (pos_ - offset), n);
+			pos_ += n;
+			return n;
+		}
+
+		MappedFile file_;
+		std::size_t pos_ = 0;
+		std::string head_;
+		std::string tail_;
+	};
+
+	static std::string make_multipart_boundary() {
+		std::random_device rd;
+		std::mt19937_64 gen(rd());
+		return "qase-reporter-" + hash_to_hex(gen());
+	}
+
+	std::string IQaseApi::qase_upload_attachment(HttpClient&, const QaseConfig&, const std::string& path) {
+		throw std::runtime_error("Attachment uploads are not supported by this api: " + path);
+	}
+
+	std::string QaseApi::qase_upload_attachment(HttpClient& http, const QaseConfig& cfg, const std::string& path) {
+		const std::string url = qase_api_base(cfg) + "attachment/" + cfg.project;
+		const std::string boundary = make_multipart_boundary();
+
+		MultipartFileBody body(path, boundary);
+		const auto headers = make_headers(cfg.token, "multipart/form-data; boundary=" + boundary);
+
+		std::string response = send_paced(cfg, body.size(), [&](int attempt) {
+			if (attempt > 0 && !body.rewind()) {
+				throw std::runtime_error("Failed to resend attachment: " + path);
+			}
+			return http.post_stream_with_response(url, body, headers);
+		});
+		auto json = nlohmann::json::parse(response);
+
+		check_qase_api_error(json);
+
+		// extract result[0].hash if present
+		if (json.contains("result") && json["result"].is_array() && !json["result"].empty()
+				&& json["result"][0].contains("hash")) {
+			return json["result"][0]["hash"].get<std::string>();
+		}
+
+		throw std::runtime_error("Qase API response missing result[0].hash field");
+	}
+
+	std::vector<int> IQaseApi::qase_create_cases(HttpClient&, const QaseConfig&, const std::vector<std::string>&) {
+		throw std::runtime_error("Case creation is not supported by this api");
+	}
+
+	std::vector<int> QaseApi::qase_create_cases(HttpClient& http, const QaseConfig& cfg, const std::vector<std::string>& titles) {
+		const std::string url = qase_api_base(cfg) + "case/" + cfg.project + "/bulk";
+
+		nlohmann::json payload;
+		payload["cases"] = nlohmann::json::array();
+		for (const auto& title : titles) {
+			payload["cases"].push_back({{"title", title}});
+		}
+
+		const auto headers = make_headers(cfg.token);
+
+		std::string response = post_paced(http, cfg, url, payload.dump(), headers);
+		auto json = nlohmann::json::parse(response);
+
+		check_qase_api_error(json);
+
+		// extract result.ids, one per created case
+		if (json.contains("result") && json["result"].contains("ids") && json["result"]["ids"].is_array()
+				&& json["result"]["ids"].size() == titles.size()) {
+			return json["result"]["ids"].get<std::vector<int>>();
+		}
+
+		throw std::runtime_error("Qase API response missing result.ids field");
+	}
+
+	// ========= CASE ID CACHE =======
+
+	// test name -> Qase case id, kept between runs, see QaseConfig::case_cache_path
+	// the file is mapped and searched in place: a header, index entries sorted by the
+	// hash of the name, then the names they point to
+	// a file of another project (or a damaged one) reads as empty and is rewritten
+	class CaseIdCache {
+	public:
+		CaseIdCache(const std::string& path, const std::string& project)
+			: path_(path), project_hash_(qase_hash64(project.data(), project.size())) {
+			std::error_code ec;
+			if (!std::filesystem::exists(path_, ec)) {
+				return;
+			}
+
+			file_ = std::make_unique<MappedFile>(path_, MADV_RANDOM);
+			if (file_->size() < sizeof(Header)) {
+				return;
+			}
+
+			Header header;
+			std::memcpy(&header, file_->data(), sizeof(header));
+			if (std::memcmp(header.magic, magic, sizeof(magic)) != 0 || header.version != version ||
+					header.project_hash != project_hash_ ||
+					header.count > (file_->size() - sizeof(Header)) / sizeof(IndexEntry)) {
+				return;
+			}
+
+			index_ = reinterpret_cast<const IndexEntry*>(file_->data() + sizeof(Header));
+			count_ = static_cast<std::size_t>(header.count);
+			names_ = file_->data() + sizeof(Header) + count_ * sizeof(IndexEntry);
+			names_size_ = file_->size() - sizeof(Header) - count_ * sizeof(IndexEntry);
+		}
+
+		// 0 when the name is unknown
+		int find(std::string_view name) const {
+			auto added = added_.find(name);
+			if (added != added_.end()) {
+				return added->second;
+			}
+			return find_mapped(name, qase_hash64(name.data(), name.size()));
+		}
+
+		void add(std::string_view name, int case_id) {
+			if (find(name) == case_id) {
+				return;
+			}
+			auto added = added_.find(name);
+			if (added != added_.end()) {
+				added->second = case_id;
+			} else {
+				added_.emplace(std::string(name), case_id);
+			}
+		}
+
+		// writes the mapped entries together with the added ones, if anything was added
+		void save() {
+			if (added_.empty()) {
+				return;
+			}
+
+			struct Pending {
+				uint64_t hash;
+				std::string_view name;
+				int case_id;
+			};
+
+			std::vector<Pending> entries;
+			entries.reserve(count_ + added_.size());
+			for (std::size_t i = 0; i < count_; ++i) {
+				const std::string_view name = mapped_name(index_[i]);
+				if (added_.count(name) == 0) {
+					entries.push_back({index_[i].name_hash, name, index_[i].case_id});
+				}
+			}
+			for (const auto& [name, case_id] : added_) {
+				entries.push_back({qase_hash64(name.data(), name.size()), name, case_id});
+			}
+			std::sort(entries.begin(), entries.end(), [](const Pending& a, const Pending& b) { return a.hash < b.hash; });
+
+			Header header;
+			std::memcpy(header.magic, magic, sizeof(magic));
+			header.version = version;
+			header.reserved = 0;
+			header.project_hash = project_hash_;
+			header.count = entries.size();
+
+			std::vector<IndexEntry> index;
+			index.reserve(entries.size());
+			uint32_t offset = 0;
+			for (const auto& entry : entries) {
+				index.push_back({entry.hash, offset, static_cast<uint32_t>(entry.name.size()), entry.case_id, 0});
+				offset += static_cast<uint32_t>(entry.name.size());
+			}
+
+			// written aside and renamed over, readers keep the old mapping meanwhile
+			const std::string tmp_path = path_ + ".tmp";
+			{
+				std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+				out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				out.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(IndexEntry)));
+				for (const auto& entry : entries) {
+					out.write(entry.name.data(), static_cast<std::streamsize>(entry.name.size()));
+				}
+				if (!out) {
+					throw std::runtime_error("Failed to write case cache file: " + tmp_path);
+				}
+			}
+
+			if (std::rename(tmp_path.c_str(), path_.c_str()) != 0) {
+				throw std::runtime_error("Failed to replace case cache file: " + path_);
+			}
+		}
+
+	private:
+		struct Header {
+			char magic[4];
+			uint32_t version;
+			uint32_t reserved;
+			uint64_t project_hash;
+			uint64_t count;
+		};
+
+		struct IndexEntry {
+			uint64_t name_hash;
+			uint32_t name_offset;
+			uint32_t name_size;
+			int32_t case_id;
+			uint32_t reserved;
+		};
+
+		static constexpr char magic[4] = {'Q', 'C', 'I', 'D'};
+		static constexpr uint32_t version = 1;
+
+		std::string_view mapped_name(const IndexEntry& entry) const {
+			if (entry.name_offset > names_size_ || entry.name_size > names_size_ - entry.name_offset) {
+				return {};
+			}
+			return std::string_view(names_ + entry.name_offset, entry.name_size);
+		}
+
+		int find_mapped(std::string_view name, uint64_t hash) const {
+			const IndexEntry* end = index_ + count_;
+			const IndexEntry* it = std::lower_bound(index_, end, hash,
+				[](const IndexEntry& entry, uint64_t value) { return entry.name_hash < value; });
+
+			// names are compared too, hashes may collide
+			for (; it != end && it->name_hash == hash; ++it) {
+				if (mapped_name(*it) == name) {
+					return it->case_id;
+				}
+			}
+			return 0;
+		}
+
+		std::string path_;
+		uint64_t project_hash_;
+		std::unique_ptr<MappedFile> file_;
+		const IndexEntry* index_ = nullptr;
+		std::size_t count_ = 0;
+		const char* names_ = nullptr;
+		std::size_t names_size_ = 0;
+		// transparent comparator, names are looked up as string_view
+		std::map<std::string, int, std::less<>> added_;
+	};
+
+	// gives every result without meta.case_id the case id cached for its name,
+	// unknown tests are created as cases in one call and remembered
+	static void resolve_case_ids(IQaseApi& api, HttpClient& http, const QaseConfig& cfg, std::vector<TestResult>& results) {
+		CaseIdCache cache(cfg.case_cache_path, cfg.project);
+
+		std::vector<std::string> unknown_names;
+		std::vector<std::string> unknown_titles;
+		std::unordered_set<std::string_view> unknown;
+		for (auto& result : results) {
+			if (result.meta.case_id > 0) {
+				cache.add(result.name, result.meta.case_id);
+				continue;
+			}
+
+			result.meta.case_id = cache.find(result.name);
+			if (result.meta.case_id == 0 && unknown.insert(result.name).second) {
+				unknown_names.push_back(result.name);
+				unknown_titles.push_back(!result.meta.title.empty() ? result.meta.title : result.name);
+			}
+		}
+
+		if (!unknown_names.empty()) {
+			const std::vector<int> created = api.qase_create_cases(http, cfg, unknown_titles);
+			// a short or long answer can't be matched to the names, nothing is cached from it
+			if (created.size() != unknown_names.size()) {
+				throw std::runtime_error("Case creation failed: got " + std::to_string(created.size()) +
+					" case ids for " + std::to_string(unknown_names.size()) + " cases");
+			}
+			for (std::size_t i = 0; i < unknown_names.size(); ++i) {
+				cache.add(unknown_names[i], created[i]);
+			}
+			for (auto& result : results) {
+				if (result.meta.case_id == 0) {
+					result.meta.case_id = cache.find(result.name);
+				}
+			}
+		}
+
+		cache.save();
+	}
+
+	void qase_reporter_resolve_case_ids(IQaseApi& api, HttpClient& http, const QaseConfig& cfg) {
+		if (!cfg.case_cache_path.empty()) {
+			resolve_case_ids(api, http, cfg, collected);
+		}
+	}
+	#endif
+
+	// what submit_batches throws, with the results (offset, count) of the batches that
+	// didn't go through; the others were accepted and must not be sent again
+	struct BatchSubmitError : std::runtime_error {
+		BatchSubmitError(const std::string& message, std::vector<std::pair<std::size_t, std::size_t>> failed)
+			: std::runtime_error(message), failed(std::move(failed)) {}
+
+		std::vector<std::pair<std::size_t, std::size_t>> failed;
+	};
+
+	// bulk submits results in payloads of at most cfg.batch_size results
+	// with a client factory and cfg.upload_workers > 1 the batches are sent by a pool of
+	// threads, each with its own client; every batch is attempted either way, and the
+	// ones that were not acknowledged are reported together, in batch order
+	// serialize_batch(offset, n) builds the payload of `n` results starting at `offset`
+	template <typename SerializeBatch>
+	static void submit_batches(
+			IQaseApi& api,
+			HttpClient& http,
+			const QaseConfig& cfg,
+			uint64_t run_id,
+			std::size_t count,
+			const SerializeBatch& serialize_batch,
+			const HttpClientFactory* make_client
+		) {
+		if (count == 0) {
+			return;
+		}
+
+		const std::size_t batch_size = cfg.batch_size > 0 ? static_cast<std::size_t>(cfg.batch_size) : count;
+		const std::size_t batches = (count + batch_size - 1) / batch_size;
+		const std::size_t workers = make_client && cfg.upload_workers > 1
+			? std::min(static_cast<std::size_t>(cfg.upload_workers), batches)
+			: 1;
+
+		// batches are handed out in order; each one ends up acknowledged or with an error
+		std::atomic<std::size_t> next_batch{0};
+		std::vector<char> acknowledged(batches, 0);
+		std::mutex errors_mutex;
+		std::vector<std::pair<std::size_t, std::string>> errors;
+
+		auto record_error = [&](std::size_t batch, std::string message) {
+			std::lock_guard<std::mutex> lock(errors_mutex);
+			errors.emplace_back(batch, std::move(message));
+		};
+
+		auto work = [&](HttpClient& client) {
+			for (std::size_t batch; (batch = next_batch++) < batches;) {
+				const std::size_t offset = batch * batch_size;
+				const std::size_t n = std::min(batch_size, count - offset);
+				try {
+					if (api.qase_submit_results(client, cfg, run_id, serialize_batch(offset, n))) {
+						acknowledged[batch] = 1;
+					} else {
+						record_error(batch, "not acknowledged by Qase API");
+					}
+				} catch (const std::exception& e) {
+					record_error(batch, e.what());
+				}
+			}
+		};
+
+		if (workers == 1) {
+			work(http);
+		} else {
+			std::vector<std::thread> pool;
+			pool.reserve(workers);
+			for (std::size_t i = 0; i < workers; ++i) {
+				pool.emplace_back([&] {
+					std::unique_ptr<HttpClient> client;
+					try {
+						client = (*make_client)();
+					} catch (const std::exception&) {
+					}
+					if (!client) {
+						// the batches go to the other workers
+						return;
+					}
+					work(*client);
+				});
+			}
+			for (auto& worker : pool) {
+				worker.join();
+			}
+		}
+
+		// batches no worker could take, when no client could be created
+		for (std::size_t batch = 0; batch < batches; ++batch) {
+			if (!acknowledged[batch] && std::none_of(errors.begin(), errors.end(),
+					[batch](const auto& error) { return error.first == batch; })) {
+				errors.emplace_back(batch, "not sent, no HTTP client could be created");
+			}
+		}
+
+		if (errors.empty()) {
+			return;
+		}
+
+		std::sort(errors.begin(), errors.end());
+		std::string message = "Failed to submit " + std::to_string(errors.size()) + " of " +
+			std::to_string(batches) + " result batches:";
+		std::vector<std::pair<std::size_t, std::size_t>> failed;
+		failed.reserve(errors.size());
+		for (const auto& [batch, error] : errors) {
+			const std::size_t offset = batch * batch_size;
+			const std::size_t n = std::min(batch_size, count - offset);
+			message += "\n  batch " + std::to_string(batch + 1) + " (results " + std::to_string(offset + 1) + "-" +
+				std::to_string(offset + n) + "): " + error;
+			failed.emplace_back(offset, n);
+		}
+		throw BatchSubmitError(message, std::move(failed));
+	}
+
+	template <typename It>
+	static void submit_in_batches(
+			IQaseApi& api,
+			HttpClient& http,
+			const QaseConfig& cfg,
+			uint64_t run_id,
+			It first,
+			std::size_t count,
+			const QaseAttachmentHashes* attachment_hashes,
+			const HttpClientFactory* make_client = nullptr
+		) {
+		submit_batches(api, http, cfg, run_id, count, [&](std::size_t offset, std::size_t n) {
+			return serialize_results(first + offset, n, attachment_hashes);
+		}, make_client);
+	}
+
+	// sorted, unique Qase case ids of `count` results starting at `first`
+	template <typename It>
+	static std::vector<int> collect_case_ids(It first, std::size_t count) {
+		std::vector<int> case_ids;
+		for (It it = first; it != first + count; ++it) {
+			if (result_ref(*it).meta.case_id > 0) {
+				case_ids.push_back(result_ref(*it).meta.case_id);
+			}
+		}
+		std::sort(case_ids.begin(), case_ids.end());
+		case_ids.erase(std::unique(case_ids.begin(), case_ids.end()), case_ids.end());
+		return case_ids;
+	}
+
+	// NOTE: Can throw std::runtime_error if Qase API returns an error
+	// qase_submit_report must follow this flow:
+	// 1. take all the results accumulated from qase_reporter_add_result calls
+	//    (only new or changed ones with a delta state, desktop only)
+	//    and upload their attachments (desktop only)
+	// 2. start test run in Qase API with qase_start_run
+	// 3. bulk submit all serialized results to Qase API with qase_submit_results, in batches
+	// 4. complete test run in Qase API with qase_complete_run
+	#ifndef ESP_PLATFORM
+	// shard processes with the same QaseConfig::shared_run_key meet in a state file in the
+	// temp directory, locked with flock while it's read or changed; the file holds the
+	// run id (0 until the first shard to submit starts the run) and the pids of the shards
+	// that joined and didn't leave yet; the last shard to leave removes the file
+	// shards that died without leaving are dropped whenever the file is read
+
+	static struct SharedRun {
+		std::string path;
+		bool joined = false;
+	} shared_run;
+
+	struct SharedRunState {
+		uint64_t run_id = 0;
+		std::vector<pid_t> members;
+	};
+
+	static std::string shared_run_path(const QaseConfig& cfg) {
+		const std::string identity = cfg.host + '\n' + cfg.project + '\n' + cfg.shared_run_key;
+		char name[64];
+		std::snprintf(name, sizeof(name), "qase-run-%016llx.lock",
+			static_cast<unsigned long long>(qase_hash64(identity.data(), identity.size())));
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	// the state file, locked for the lifetime of the object
+	class SharedRunFile {
+	public:
+		explicit SharedRunFile(const std::string& path) : path_(path) {
+			for (;;) {
+				fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+				if (fd_ < 0) {
+					throw std::runtime_error("Could not open shared run file: " + path + ": " + std::strerror(errno));
+				}
+				while (flock(fd_, LOCK_EX) != 0) {
+					if (errno != EINTR) {
+						close(fd_);
+						throw std::runtime_error("Could not lock shared run file: " + path + ": " + std::strerror(errno));
+					}
+				}
+
+				// the last shard may have removed the file while we waited for the lock,
+				// then it's opened again
+				struct stat locked;
+				struct stat linked;
+				if (fstat(fd_, &locked) == 0 && stat(path.c_str(), &linked) == 0 &&
+						locked.st_dev == linked.st_dev && locked.st_ino == linked.st_ino) {
+					return;
+				}
+				close(fd_);
+			}
+		}
+
+		~SharedRunFile() { close(fd_); }
+
+		SharedRunFile(const SharedRunFile&) = delete;
+		SharedRunFile& operator=(const SharedRunFile&) = delete;
+
+		// "<run id>\n<pid> <pid> ...\n"
+		SharedRunState read() const {
+			std::string text;
+			char buf[4096];
+			off_t offset = 0;
+			ssize_t n;
+			while ((n = pread(fd_, buf, sizeof(buf), offset)) > 0) {
+				text.append(buf, static_cast<std::size_t>(n));
+				offset += n;
+			}
+
+			SharedRunState state;
+			const char* p = text.c_str();
+			char* end;
+			state.run_id = std::strtoull(p, &end, 10);
+			for (p = end; ; p = end) {
+				const long pid = std::strtol(p, &end, 10);
+				if (end == p) {
+					break;
+				}
+				if (kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM) {
+					state.members.push_back(static_cast<pid_t>(pid));
+				}
+			}
+			return state;
+		}
+
+		void write(const SharedRunState& state) {
+			std::string text = std::to_string(state.run_id) + "\n";
+			for (pid_t pid : state.members) {
+				text += std::to_string(pid) + " ";
+			}
+			text += "\n";
+
+			if (ftruncate(fd_, 0) != 0 || pwrite(fd_, text.data(), text.size(), 0) != static_cast<ssize_t>(text.size())) {
+				throw std::runtime_error("Could not write shared run file: " + path_ + ": " + std::strerror(errno));
+			}
+		}
+
+		void remove() { unlink(path_.c_str()); }
+
+	private:
+		std::string path_;
+		int fd_ = -1;
+	};
+
+	static bool shared_run_leave(uint64_t* run_id = nullptr);
+
+	static void shared_run_join(const QaseConfig& cfg) {
+		if (cfg.shared_run_key.empty()) {
+			return;
+		}
+		const std::string path = shared_run_path(cfg);
+		if (shared_run.joined) {
+			if (shared_run.path == path) {
+				return;
+			}
+			shared_run_leave();
+		}
+
+		SharedRunFile file(path);
+		SharedRunState state = file.read();
+		if (state.members.empty()) {
+			// the shards of that run are gone without completing it, it's not reused
+			state.run_id = 0;
+		}
+		state.members.push_back(getpid());
+		file.write(state);
+
+		shared_run.path = path;
+		shared_run.joined = true;
+	}
+
+	// id of the shared run; the first shard to ask starts it with its case_ids,
+	// the others wait for the lock meanwhile
+	static uint64_t shared_run_start(IQaseApi& api, HttpClient& http, const QaseConfig& cfg, const std::vector<int>& case_ids) {
+		// for callers that submit without configuring the recorder
+		shared_run_join(cfg);
+
+		SharedRunFile file(shared_run.path);
+		SharedRunState state = file.read();
+		if (state.run_id == 0) {
+			state.run_id = api.qase_start_run(http, cfg, case_ids);
+			file.write(state);
+		}
+		return state.run_id;
+	}
+
+	// leaves the shared run, returns true if this was the last shard in it;
+	// run_id gets the id of the run, 0 if none was started
+	static bool shared_run_leave(uint64_t* run_id) {
+		if (!shared_run.joined) {
+			return false;
+		}
+		shared_run.joined = false;
+
+		SharedRunFile file(shared_run.path);
+		SharedRunState state = file.read();
+		if (run_id) {
+			*run_id = state.run_id;
+		}
+		state.members.erase(std::remove(state.members.begin(), state.members.end(), getpid()), state.members.end());
+		if (!state.members.empty()) {
+			file.write(state);
+			return false;
+		}
+		file.remove();
+		return true;
+	}
+
+	// a shard whose submission failed leaves the run without completing it
+	struct SharedRunGuard {
+		~SharedRunGuard() {
+			try {
+				shared_run_leave();
+			} catch (const std::exception&) {
+			}
+		}
+	};
+	#endif
+
+	#ifndef ESP_PLATFORM
+	// uploads the attachments of `count` results, so results can reference them by hash
+	// files are recognised by content: identical files are uploaded once,
+	// whatever their paths are; uploaded_by_content carries that over between calls
+	template <typename It>
+	static void upload_attachments(IQaseApi& api, HttpClient& http, const QaseConfig& cfg, It first, std::size_t count,
+			QaseAttachmentHashes& attachment_hashes, std::unordered_map<uint64_t, std::string>& uploaded_by_content) {
+		for (It it = first; it != first + count; ++it) {
+			for (const auto& path : result_ref(*it).meta.attachments) {
+				if (attachment_hashes.count(path) > 0) {
+					continue;
+				}
+
+				const uint64_t content_hash = qase_hash_file(path);
+				auto uploaded = uploaded_by_content.find(content_hash);
+				if (uploaded == uploaded_by_content.end()) {
+					uploaded = uploaded_by_content.emplace(content_hash, api.qase_upload_attachment(http, cfg, path)).first;
+				}
+				attachment_hashes[path] = uploaded->second;
+			}
+		}
+	}
+
+	// "upload" spill mode: submits the recorded results right away, into the run started
+	// on the first flush; returns false if that failed, with `collected` cut down to the
+	// results that weren't accepted
+	static bool spill_upload() {
+		RecorderSpill& spill = recorder_spill;
+		IQaseApi& api = *spill.api;
+		HttpClient& http = *spill.http;
+		const QaseConfig& cfg = spill.cfg;
+
+		std::vector<TestResult*> pending;
+		try {
+			if (!cfg.case_cache_path.empty()) {
+				resolve_case_ids(api, http, cfg, collected);
+			}
+
+			// with a delta state, results that didn't change are dropped here like at submission
+			DeltaSubmission& delta = spill_delta(cfg);
+			pending.reserve(collected.size());
+			for (auto& result : collected) {
+				if (delta.should_send(result)) {
+					pending.push_back(&result);
+				}
+				delta.record(result);
+			}
+
+			QaseAttachmentHashes attachment_hashes;
+			upload_attachments(api, http, cfg, pending.data(), pending.size(), attachment_hashes, spill.uploaded_attachments);
+
+			if (spill.run_id == 0) {
+				const std::vector<int> case_ids = collect_case_ids(collected.data(), collected.size());
+				spill.run_id = cfg.run_id != 0 ? cfg.run_id :
+					!cfg.shared_run_key.empty() ? shared_run_start(api, http, cfg, case_ids) :
+					api.qase_start_run(http, cfg, case_ids);
+			}
+			submit_in_batches(api, http, cfg, spill.run_id, pending.data(), pending.size(), &attachment_hashes);
+		} catch (const BatchSubmitError& e) {
+			// the accepted batches are in the run already, only the rest goes to disk
+			// (compacted in place, the ranges come in order)
+			auto kept = collected.begin();
+			for (const auto& [offset, n] : e.failed) {
+				for (std::size_t i = offset; i < offset + n; ++i, ++kept) {
+					if (&*kept != pending[i]) {
+						*kept = std::move(*pending[i]);
+					}
+				}
+			}
+			collected.erase(kept, collected.end());
+			return false;
+		} catch (const std::exception&) {
+			return false;
+		}
+		return true;
+	}
+	#endif
+
+	// adds the ids of `more` missing from the sorted `case_ids`
+	static void merge_case_ids(std::vector<int>& case_ids, const std::vector<int>& more) {
+		for (int case_id : more) {
+			if (!std::binary_search(case_ids.begin(), case_ids.end(), case_id)) {
+				case_ids.insert(std::upper_bound(case_ids.begin(), case_ids.end(), case_id), case_id);
+			}
+		}
+	}
+
+	static void submit_report(
+			IQaseApi& api,
+			HttpClient& http,
+			const HttpClientFactory* make_client,
+			const QaseConfig& cfg
+		) {
+
+		// step 0: take all the results accumulated from qase_reporter_add_result calls
+		// (and the ones that went over the recorder's memory budget)
+		const auto& results = qase_reporter_get_results();
+		#ifndef ESP_PLATFORM
+		const bool spilled = recorder_spill.spilled > 0 || recorder_spill.run_id != 0;
+		#else
+		const bool spilled = false;
+		#endif
+		if (results.empty() && collected_params.empty() && !spilled) {
+			#ifndef ESP_PLATFORM
+			// a shard with nothing to send still leaves its shared run, and completes it if it's the last
+			uint64_t shared_run_id = 0;
+			if (shared_run_leave(&shared_run_id) && shared_run_id != 0 && cfg.run_complete) {
+				api.qase_complete_run(http, cfg, shared_run_id);
+			}
+			#endif
+			return; // nothing to submit, skip orchestration
+		}
+
+		#ifndef ESP_PLATFORM
+		SharedRunGuard shared_run_guard;
+		#endif
+
+		// with a delta state, results that didn't change since the last submission
+		// into the same run are left out
+		std::vector<const TestResult*> pending;
+		pending.reserve(results.size());
+		#ifndef ESP_PLATFORM
+		DeltaSubmission& delta = spill_delta(cfg);
+		for (const auto& result : results) {
+			if (delta.should_send(result)) {
+				pending.push_back(&result);
+			}
+		}
+		#else
+		for (const auto& result : results) {
+			pending.push_back(&result);
+		}
+		#endif
+
+		// step 1: upload attachments, so results can reference them by hash
+		QaseAttachmentHashes attachment_hashes;
+		#ifndef ESP_PLATFORM
+		std::unordered_map<uint64_t, std::string> uploaded_by_content = recorder_spill.uploaded_attachments;
+		upload_attachments(api, http, cfg, pending.data(), pending.size(), attachment_hashes, uploaded_by_content);
+		#endif
+
+		// step 2: if run_id is sent from the config, use it
+		// if no run_id is sent, start new test run in Qase API with qase_start_run 
+		// and get the run_id of this new run
+		// the run is created with the cases of the collected results only
+		uint64_t run_id = cfg.run_id;
+		#ifndef ESP_PLATFORM
+		if (run_id == 0) {
+			// an upload flush of the recorder started it already
+			run_id = recorder_spill.run_id;
+		}
+		#endif
+		if (run_id == 0) {
+			std::vector<int> case_ids = collect_case_ids(results.data(), results.size());
+			#ifndef ESP_PLATFORM
+			merge_case_ids(case_ids, recorder_spill.case_ids);
+			#endif
+			for (const auto& test : collected_params.tests()) {
+				if (test.meta.case_id > 0) {
+					merge_case_ids(case_ids, {test.meta.case_id});
+				}
+			}
+			#ifndef ESP_PLATFORM
+			if (!cfg.shared_run_key.empty()) {
+				// another shard may have started the run already
+				run_id = shared_run_start(api, http, cfg, case_ids);
+			} else
+			#endif
+			run_id = api.qase_start_run(http, cfg, case_ids);
+		}
+
+		// results spilled to disk go first, read back a budget's worth at a time
+		#ifndef ESP_PLATFORM
+		spill_replay([&](std::vector<TestResult>& chunk) {
+			if (!cfg.case_cache_path.empty()) {
+				resolve_case_ids(api, http, cfg, chunk);
+			}
+			std::vector<const TestResult*> chunk_pending;
+			chunk_pending.reserve(chunk.size());
+			for (const auto& result : chunk) {
+				if (delta.should_send(result)) {
+					chunk_pending.push_back(&result);
+				}
+				delta.record(result);
+			}
+			QaseAttachmentHashes chunk_hashes;
+			upload_attachments(api, http, cfg, chunk_pending.data(), chunk_pending.size(), chunk_hashes, uploaded_by_content);
+			submit_in_batches(api, http, cfg, run_id, chunk_pending.data(), chunk_pending.size(), &chunk_hashes, make_client);
+		});
+		#endif
+
+		// step 3: bulk submit all serialized results to Qase API with qase_submit_results,
+		// cfg.batch_size results per request, from up to cfg.upload_workers threads
+		// throws if any batch failed, so the run is never completed with results missing
+		submit_in_batches(api, http, cfg, run_id, pending.data(), pending.size(), &attachment_hashes, make_client);
+
+		// iterations of parameterized tests follow, in batches of their own
+		submit_batches(api, http, cfg, run_id, collected_params.size(), [](std::size_t offset, std::size_t n) {
+			return serialize_param_results(collected_params, offset, n);
+		}, make_client);
+
+		#ifndef ESP_PLATFORM
+		// the results kept in memory were sent after the spilled ones
+		for (const auto& result : results) {
+			delta.record(result);
+		}
+		delta.commit();
+		spill_clear();
+		#endif
+
+		// step 4: complete test run in Qase API with qase_complete_run
+		// but do it only if the config doesn't prohibit this
+		// (and, in a shared run, only once the other shards are done)
+		bool complete = cfg.run_complete;
+		#ifndef ESP_PLATFORM
+		if (shared_run.joined) {
+			complete = shared_run_leave() && complete;
+		}
+		#endif
+		if (complete) {
+			api.qase_complete_run(http, cfg, run_id);
+		}
+
+	}
+
+	void qase_submit_report(
+			IQaseApi& api,
+			HttpClient& http,
+			const QaseConfig& cfg
+		) {
+		submit_report(api, http, nullptr, cfg);
+	}
+
+	void qase_submit_report(
+			IQaseApi& api,
+			const HttpClientFactory& make_client,
+			const QaseConfig& cfg
+		) {
+		// this one serves the attachments, the run start and completion
+		std::unique_ptr<HttpClient> http = make_client();
+		if (!http) {
+			throw std::runtime_error("HTTP client factory returned no client");
+		}
+		submit_report(api, *http, &make_client, cfg);
+	}
+
+	
+
+	// ========= SERIAL RESULT PROTOCOL =======
+
+	static uint8_t crc8(const uint8_t* data, std::size_t size) {
+		uint8_t crc = 0;
+		for (std::size_t i = 0; i < size; ++i) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit) {
+				crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+			}
+		}
+		return crc;
+	}
+
+	// writes v as LEB128 at out[pos], returns the new position
+	static std::size_t put_varint(uint8_t* out, std::size_t pos, uint32_t v) {
+		while (v >= 0x80) {
+			out[pos++] = static_cast<uint8_t>(v | 0x80);
+			v >>= 7;
+		}
+		out[pos++] = static_cast<uint8_t>(v);
+		return pos;
+	}
+
+	// COBS: replaces every 0x00 with the distance to the next one, output is never longer
+	// than size + size / 254 + 1
+	static std::size_t cobs_encode(const uint8_t* in, std::size_t size, uint8_t* out) {
+		std::size_t write = 1;
+		std::size_t code_pos = 0;
+		uint8_t code = 1;
+
+		for (std::size_t read = 0; read < size; ++read) {
+			if (in[read] == 0) {
+				out[code_pos] = code;
+				code = 1;
+				code_pos = write++;
+				continue;
+			}
+
+			out[write++] = in[read];
+			if (++code == 0xFF) {
+				out[code_pos] = code;
+				code = 1;
+				code_pos = write++;
+			}
+		}
+		out[code_pos] = code;
+		return write;
+	}
+
+	void QaseSerialEncoder::emit(std::size_t payload_size) {
+		payload_[payload_size] = crc8(payload_, payload_size);
+		std::size_t encoded_size = cobs_encode(payload_, payload_size + 1, encoded_);
+		encoded_[encoded_size++] = 0x00;
+		sink_.write(encoded_, encoded_size);
+	}
+
+	// returns the id of the string, defining it on the host first if it isn't known yet
+	// when the table is full, the oldest slot the current result doesn't use is reused
+	uint32_t QaseSerialEncoder::intern(std::string_view str) {
+		if (str.size() > max_string) {
+			str = str.substr(0, max_string);
+		}
+
+		const uint64_t hash = qase_hash64(str.data(), str.size());
+		for (std::size_t i = 0; i < interned_count_; ++i) {
+			if (interned_[i] == hash && interned_size_[i] == str.size() &&
+					std::memcmp(interned_data_[i], str.data(), str.size()) == 0) {
+				pinned_ |= uint64_t(1) << i;
+				return static_cast<uint32_t>(i);
+			}
+		}
+
+		while (pinned_ & (uint64_t(1) << next_slot_)) {
+			next_slot_ = (next_slot_ + 1) % intern_capacity;
+		}
+		const std::size_t slot = next_slot_;
+		next_slot_ = (next_slot_ + 1) % intern_capacity;
+		interned_count_ = std::max(interned_count_, slot + 1);
+		interned_[slot] = hash;
+		interned_size_[slot] = static_cast<uint8_t>(str.size());
+		std::memcpy(interned_data_[slot], str.data(), str.size());
+		pinned_ |= uint64_t(1) << slot;
+
+		std::size_t pos = 0;
+		payload_[pos++] = static_cast<uint8_t>(QaseSerialFrame::string);
+		pos = put_varint(payload_, pos, static_cast<uint32_t>(slot));
+		pos = put_varint(payload_, pos, static_cast<uint32_t>(str.size()));
+		std::memcpy(payload_ + pos, str.data(), str.size());
+		emit(pos + str.size());
+
+		return static_cast<uint32_t>(slot);
+	}
+
+	void QaseSerialEncoder::begin_run() {
+		interned_count_ = 0;
+		next_slot_ = 0;
+		pinned_ = 0;
+		result_count_ = 0;
+
+		payload_[0] = static_cast<uint8_t>(QaseSerialFrame::run_begin);
+		payload_[1] = version;
+		emit(2);
+	}
+
+	// logs go first, the result frame closes them
+	void QaseSerialEncoder::write_logs(std::string_view logs) {
+		const std::size_t log_chunk = max_payload - 8;
+		for (std::size_t offset = 0; offset < logs.size(); offset += log_chunk) {
+			const std::size_t n = std::min(log_chunk, logs.size() - offset);
+			std::size_t pos = 0;
+			payload_[pos++] = static_cast<uint8_t>(QaseSerialFrame::log_chunk);
+			pos = put_varint(payload_, pos, static_cast<uint32_t>(n));
+			std::memcpy(payload_ + pos, logs.data() + offset, n);
+			emit(pos + n);
+		}
+	}
+
+	void QaseSerialEncoder::write_result(std::string_view name, bool passed, std::string_view logs) {
+		pinned_ = 0;
+		write_logs(logs);
+		const uint32_t name_id = intern(name);
+
+		std::size_t pos = 0;
+		payload_[pos++] = static_cast<uint8_t>(QaseSerialFrame::result);
+		payload_[pos++] = passed ? 0x01 : 0x00;
+		pos = put_varint(payload_, pos, name_id);
+		emit(pos);
+
+		++result_count_;
+	}
+
+	void QaseSerialEncoder::write_result(const TestResult& result) {
+		pinned_ = 0;
+		write_logs(result.logs);
+
+		// strings are interned before the result frame is built, as interning emits frames itself
+		const uint32_t name_id = intern(result.name);
+		const uint32_t title_id = result.meta.title.empty() ? 0 : intern(result.meta.title);
+
+		uint32_t field_ids[max_fields * 2];
+		std::size_t field_count = 0;
+		for (const auto& kv : result.meta.fields) {
+			if (field_count == max_fields) {
+				break;
+			}
+			field_ids[field_count * 2] = intern(kv.first);
+			field_ids[field_count * 2 + 1] = intern(kv.second);
+			++field_count;
+		}
+
+		uint8_t flags = result.passed ? 0x01 : 0x00;
+		if (result.meta.case_id > 0) flags |= 0x02;
+		if (!result.meta.title.empty()) flags |= 0x04;
+		if (field_count > 0) flags |= 0x08;
+
+		std::size_t pos = 0;
+		payload_[pos++] = static_cast<uint8_t>(QaseSerialFrame::result);
+		payload_[pos++] = flags;
+		pos = put_varint(payload_, pos, name_id);
+		if (flags & 0x02) pos = put_varint(payload_, pos, static_cast<uint32_t>(result.meta.case_id));
+		if (flags & 0x04) pos = put_varint(payload_, pos, title_id);
+		if (flags & 0x08) {
+			pos = put_varint(payload_, pos, static_cast<uint32_t>(field_count));
+			for (std::size_t i = 0; i < field_count * 2; ++i) {
+				pos = put_varint(payload_, pos, field_ids[i]);
+			}
+		}
+		emit(pos);
+
+		++result_count_;
+	}
+
+	void QaseSerialEncoder::end_run() {
+		std::size_t pos = 0;
+		payload_[pos++] = static_cast<uint8_t>(QaseSerialFrame::run_end);
+		pos = put_varint(payload_, pos, result_count_);
+		emit(pos);
+	}
+
+	void qase_serial_emit_results(QaseByteSink& sink, const std::vector<TestResult>& results) {
+		// the intern table is too big for a small task stack
+		auto encoder = std::make_unique<QaseSerialEncoder>(sink);
+		encoder->begin_run();
+		for (const auto& result : results) {
+			encoder->write_result(result);
 		}
+		encoder->end_run();
+	}
 
-		throw std::runtime_error("Qase API response missing result.id field");
+	void qase_serial_emit_recorded(QaseByteSink& sink) {
+		auto encoder = std::make_unique<QaseSerialEncoder>(sink);
+		encoder->begin_run();
+		qase_reporter_for_each_result([&encoder](const TestResult& result) {
+			encoder->write_result(result);
+		});
+		encoder->end_run();
 	}
 
-	bool QaseApi::qase_submit_results(HttpClient& http, const QaseConfig& cfg, uint64_t run_id, const std::string& payload) {
+	void QaseSerialAdapter::submit_report(IQaseApi&, HttpClient&, const QaseConfig&) {
+		qase_serial_emit_recorded(sink);
+	}
 
-		const std::string url = qase_api_base(cfg) + "result/" + cfg.project + "/" + std::to_string(run_id) + "/bulk";
-		const auto headers = make_headers(cfg.token);
+	#ifndef ESP_PLATFORM
+	// bounds-checked reader over a decoded frame payload
+	struct FrameReader {
+		const uint8_t* data;
+		std::size_t size;
+		std::size_t pos = 0;
+		bool failed = false;
 
-		std::string response = http.post(url, payload, headers);
-		auto json = nlohmann::json::parse(response);
+		uint8_t byte() {
+			if (pos >= size) {
+				failed = true;
+				return 0;
+			}
+			return data[pos++];
+		}
 
-		check_qase_api_error(json);
+		uint32_t varint() {
+			uint32_t v = 0;
+			for (int shift = 0; shift < 35; shift += 7) {
+				uint8_t b = byte();
+				v |= static_cast<uint32_t>(b & 0x7F) << shift;
+				if (!(b & 0x80)) {
+					return v;
+				}
+			}
+			failed = true;
+			return 0;
+		}
 
-		return json.contains("status") && json["status"] == true;
+		std::string_view bytes(std::size_t n) {
+			if (n > size - pos) {
+				failed = true;
+				return std::string_view();
+			}
+			std::string_view out(reinterpret_cast<const char*>(data + pos), n);
+			pos += n;
+			return out;
+		}
+	};
 
-	}
+	void QaseSerialDecoder::feed(const uint8_t* data, std::size_t size) {
+		static const std::size_t max_frame = QaseSerialEncoder::max_payload * 2;
 
-	bool QaseApi::qase_complete_run(HttpClient& http, const QaseConfig& cfg, uint64_t run_id) {
+		for (std::size_t i = 0; i < size; ++i) {
+			if (data[i] == 0x00) {
+				if (frame_overflow_) {
+					++corrupt_frames_;
+				} else if (!frame_.empty()) {
+					decode_frame();
+				}
+				frame_.clear();
+				frame_overflow_ = false;
+			} else if (frame_.size() < max_frame) {
+				frame_.push_back(data[i]);
+			} else {
+				frame_overflow_ = true;
+			}
+		}
+	}
 
-		const std::string url = qase_api_base(cfg) + "run/" + cfg.project + "/" + std::to_string(run_id) + "/complete";
+	void QaseSerialDecoder::decode_frame() {
+		// COBS decode in place: the output is never longer than the input
+		std::size_t read = 0;
+		std::size_t write = 0;
+		while (read < frame_.size()) {
+			const uint8_t code = frame_[read++];
+			if (code - 1u > frame_.size() - read) {
+				++corrupt_frames_;
+				return;
+			}
+			for (uint8_t i = 1; i < code; ++i) {
+				frame_[write++] = frame_[read++];
+			}
+			if (code != 0xFF && read < frame_.size()) {
+				frame_[write++] = 0x00;
+			}
+		}
 
-		const auto headers = make_headers(cfg.token);
+		if (write < 2 || crc8(frame_.data(), write - 1) != frame_[write - 1] || !dispatch(frame_.data(), write - 1)) {
+			++corrupt_frames_;
+		}
+	}
 
-		std::string response = http.post(url, "", headers);
-		auto json = nlohmann::json::parse(response);
+	bool QaseSerialDecoder::dispatch(const uint8_t* payload, std::size_t size) {
+		FrameReader in{payload, size};
+		const uint8_t type = in.byte();
 
-		check_qase_api_error(json);
+		auto string_at = [this, &in](uint32_t id) -> const std::string& {
+			static const std::string missing;
+			if (id >= strings_.size()) {
+				in.failed = true;
+				return missing;
+			}
+			return strings_[id];
+		};
 
-		return json.contains("status") && json["status"] == true;
+		switch (static_cast<QaseSerialFrame>(type)) {
+		case QaseSerialFrame::run_begin: {
+			const uint8_t version = in.byte();
+			if (in.failed || version != QaseSerialEncoder::version) {
+				return false;
+			}
+			strings_.clear();
+			pending_logs_.clear();
+			decoded_count_ = 0;
+			run_ended_ = false;
+			return true;
+		}
+		case QaseSerialFrame::string: {
+			const uint32_t id = in.varint();
+			const std::string_view str = in.bytes(in.varint());
+			if (in.failed || id >= QaseSerialEncoder::intern_capacity) {
+				return false;
+			}
+			if (strings_.size() <= id) {
+				strings_.resize(id + 1);
+			}
+			strings_[id].assign(str.data(), str.size());
+			return true;
+		}
+		case QaseSerialFrame::log_chunk: {
+			const std::string_view chunk = in.bytes(in.varint());
+			if (in.failed) {
+				return false;
+			}
+			pending_logs_.append(chunk.data(), chunk.size());
+			return true;
+		}
+		case QaseSerialFrame::result: {
+			TestResult result;
+			const uint8_t flags = in.byte();
+			result.passed = flags & 0x01;
+			result.name = string_at(in.varint());
+			if (flags & 0x02) result.meta.case_id = static_cast<int>(in.varint());
+			if (flags & 0x04) result.meta.title = string_at(in.varint());
+			if (flags & 0x08) {
+				const uint32_t count = in.varint();
+				for (uint32_t i = 0; i < count && !in.failed; ++i) {
+					const std::string& key = string_at(in.varint());
+					const std::string& value = string_at(in.varint());
+					result.meta.fields[key] = value;
+				}
+			}
+			if (in.failed || result.name.empty()) {
+				pending_logs_.clear();
+				return false;
+			}
+			result.logs = std::move(pending_logs_);
+			pending_logs_.clear();
+			results_.push_back(std::move(result));
+			++decoded_count_;
+			return true;
+		}
+		case QaseSerialFrame::run_end: {
+			const uint32_t expected = in.varint();
+			if (in.failed) {
+				return false;
+			}
+			lost_results_ += expected > decoded_count_ ? expected - decoded_count_ : 0;
+			run_ended_ = true;
+			return true;
+		}
+		}
+		return false;
+	}
 
+	void QaseSerialDecoder::take_results(std::vector<TestResult>& out) {
+		std::move(results_.begin(), results_.end(), std::back_inserter(out));
+		results_.clear();
 	}
 
-	// NOTE: Can throw std::runtime_error if Qase API returns an error
-	// qase_submit_report must follow this flow:
-	// 1. take all the results accumulated from qase_reporter_add_result calls
-	// 2. start test run in Qase API with qase_start_run
-	// 3. bulk submit all serialized results to Qase API with qase_submit_results
-	// 4. complete test run in Qase API with qase_complete_run
-	void qase_submit_report(
-			IQaseApi& api,
-			HttpClient& http,
-			const QaseConfig& cfg
-		) {
+	void qase_serial_collect(int fd, IQaseApi& api, HttpClient& http, const QaseConfig& cfg) {
+		const std::size_t batch_size = cfg.batch_size > 0 ? static_cast<std::size_t>(cfg.batch_size) : 200;
 
-		// step 0: take all the results accumulated from qase_reporter_add_result calls
-		const auto& results = qase_reporter_get_results();
-		if (results.empty()) {
-			return; // nothing to submit, skip orchestration
-		}
+		QaseSerialDecoder decoder;
+		std::vector<TestResult> pending;
+		uint64_t run_id = cfg.run_id;
 
-		// step 1: take all serialised results accumulated from qase_reporter_add_result calls
-		const std::string payload = qase_serialize_results(results);
+		// submits full batches, or everything that's left when the stream is over
+		auto flush = [&](bool all) {
+			std::size_t ready = all ? pending.size() : pending.size() / batch_size * batch_size;
+			if (ready == 0) {
+				return;
+			}
+			// the run starts with the cases of the first batch, later ones join as they are submitted
+			if (run_id == 0) {
+				run_id = api.qase_start_run(http, cfg, collect_case_ids(pending.data(), ready));
+			}
+			submit_in_batches(api, http, cfg, run_id, pending.data(), ready, nullptr);
+			pending.erase(pending.begin(), pending.begin() + ready);
+		};
 
-		// step 2: if run_id is sent from the config, use it
-		// if no run_id is sent, start new test run in Qase API with qase_start_run 
-		// and get the run_id of this new run
-		uint64_t run_id = cfg.run_id;
-		if (run_id == 0) {
-			run_id = api.qase_start_run(http, cfg);
+		uint8_t buf[4096];
+		while (!decoder.run_ended()) {
+			ssize_t n = read(fd, buf, sizeof(buf));
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				break;
+			}
+			decoder.feed(buf, static_cast<std::size_t>(n));
+			decoder.take_results(pending);
+			flush(false);
 		}
+		flush(true);
 
-		// step 3: bulk submit all serialized results to Qase API with qase_submit_results
-		bool bulk_result = api.qase_submit_results(http, cfg, run_id, payload);
-
-		// step 4: complete test run in Qase API with qase_complete_run
-		// but do it only if the config doesn't prohibit this
-		if (cfg.run_complete) {
+		if (run_id != 0 && cfg.run_complete) {
 			api.qase_complete_run(http, cfg, run_id);
 		}
-
 	}
-
-	
+	#endif
 
 	// ========= READING CONFIG FROM A FILE IS NOT AVAILABLE ON ESP32 =======
 	#ifndef ESP_PLATFORM
@@ -257,6 +4505,45 @@ namespace qase {
 			cfg.capture_logs = j["captureLogs"].get<bool>();
 		}
 
+		if (j.contains("captureLogsMaxBytes") && j["captureLogsMaxBytes"].is_number_unsigned()) {
+			cfg.capture_logs_max_bytes = j["captureLogsMaxBytes"].get<std::size_t>();
+		}
+
+		if (j.contains("captureLogsFailedOnly") && j["captureLogsFailedOnly"].is_boolean()) {
+			cfg.capture_logs_failed_only = j["captureLogsFailedOnly"].get<bool>();
+		}
+
+		if (j.contains("profileMemory") && j["profileMemory"].is_boolean()) {
+			cfg.profile_memory = j["profileMemory"].get<bool>();
+		}
+
+		if (j.contains("recorder") && j["recorder"].is_object()) {
+			const auto& recorder = j["recorder"];
+			// a mistyped budget would silently turn it off, so it's an error like a bad spill mode
+			if (recorder.contains("memoryBudget")) {
+				if (!recorder["memoryBudget"].is_number_unsigned()) {
+					throw std::runtime_error("Invalid recorder.memoryBudget: " + recorder["memoryBudget"].dump() +
+						", expected a number of bytes");
+				}
+				cfg.recorder_memory_budget = recorder["memoryBudget"].get<std::size_t>();
+			}
+			if (recorder.contains("spill")) {
+				if (!recorder["spill"].is_string()) {
+					throw std::runtime_error("Invalid recorder.spill: " + recorder["spill"].dump() + ", expected disk or upload");
+				}
+				cfg.recorder_spill = recorder["spill"].get<std::string>();
+				if (cfg.recorder_spill != "disk" && cfg.recorder_spill != "upload") {
+					throw std::runtime_error("Invalid recorder.spill: " + cfg.recorder_spill + ", expected disk or upload");
+				}
+			}
+			if (recorder.contains("spillPath")) {
+				if (!recorder["spillPath"].is_string()) {
+					throw std::runtime_error("Invalid recorder.spillPath: " + recorder["spillPath"].dump() + ", expected a path");
+				}
+				cfg.recorder_spill_path = recorder["spillPath"].get<std::string>();
+			}
+		}
+
 		if (testops.contains("report") && testops["report"].contains("driver")) {
 			cfg.report_driver = testops["report"]["driver"].get<std::string>();
 		}
@@ -271,6 +4558,12 @@ namespace qase {
 			cfg.connection_format = testops["report"]["connection"]["format"].get<std::string>();
 		}
 
+		if (testops.contains("report") && testops["report"].contains("connection") &&
+				testops["report"]["connection"].contains("flushIntervalMs") &&
+				testops["report"]["connection"]["flushIntervalMs"].is_number_integer()) {
+			cfg.report_flush_interval_ms = testops["report"]["connection"]["flushIntervalMs"].get<long>();
+		}
+
 		if (tapi.contains("enterprise") && tapi["enterprise"].is_boolean()) {
 			cfg.enterprise = tapi["enterprise"].get<bool>();
 		}
@@ -285,6 +4578,48 @@ namespace qase {
 			cfg.run_id = testops["run"]["id"].get<int>();
 		}
 
+		if (testops.contains("caseCache") && testops["caseCache"].contains("path") &&
+				testops["caseCache"]["path"].is_string()) {
+			cfg.case_cache_path = testops["caseCache"]["path"].get<std::string>();
+		}
+
+		if (testops.contains("batch") && testops["batch"].is_object()) {
+			if (testops["batch"].contains("size") && testops["batch"]["size"].is_number_integer()) {
+				cfg.batch_size = testops["batch"]["size"].get<int>();
+			}
+			if (testops["batch"].contains("workers") && testops["batch"]["workers"].is_number_integer()) {
+				cfg.upload_workers = testops["batch"]["workers"].get<int>();
+			}
+		}
+
+		if (testops.contains("rateLimit") && testops["rateLimit"].is_object()) {
+			const auto& rate_limit = testops["rateLimit"];
+			if (rate_limit.contains("requestsPerSecond") && rate_limit["requestsPerSecond"].is_number()) {
+				cfg.rate_limit_requests_per_sec = rate_limit["requestsPerSecond"].get<double>();
+			}
+			if (rate_limit.contains("bytesPerSecond") && rate_limit["bytesPerSecond"].is_number()) {
+				cfg.rate_limit_bytes_per_sec = rate_limit["bytesPerSecond"].get<double>();
+			}
+			if (rate_limit.contains("maxRetries") && rate_limit["maxRetries"].is_number_integer()) {
+				cfg.rate_limit_max_retries = rate_limit["maxRetries"].get<int>();
+			}
+		}
+
+		if (testops.contains("run") && testops["run"].contains("shareKey") &&
+				testops["run"]["shareKey"].is_string()) {
+			cfg.shared_run_key = testops["run"]["shareKey"].get<std::string>();
+		}
+
+		if (testops.contains("run") && testops["run"].contains("delta")) {
+			const auto& delta = testops["run"]["delta"];
+			if (delta.contains("path") && delta["path"].is_string()) {
+				cfg.delta_state_path = delta["path"].get<std::string>();
+			}
+			if (delta.contains("resyncEvery") && delta["resyncEvery"].is_number_integer()) {
+				cfg.delta_resync_every = delta["resyncEvery"].get<int>();
+			}
+		}
+
 		if (testops.contains("run") && testops["run"].contains("title")) {
 			cfg.run_title = testops["run"]["title"].get<std::string>();
 		}
@@ -294,14 +4629,13 @@ namespace qase {
 			cfg.run_description = testops["run"]["description"].get<std::string>();
 		}
 
-		// todo: support passing plan_id further down in the logics
-		if (testops.contains("plan") && testops["plan"].contains("id")) {
-			cfg.plan_id = testops["plan"]["id"].get<int>();
+		if (testops.contains("run") && testops["run"].contains("includeAllCases") &&
+				testops["run"]["includeAllCases"].is_boolean()) {
+			cfg.include_all_cases = testops["run"]["includeAllCases"].get<bool>();
 		}
 
-		// todo: support passing batch_size further down in the logics
-		if (testops.contains("batch") && testops["batch"].contains("size")) {
-			cfg.batch_size = testops["batch"]["size"].get<int>();
+		if (testops.contains("plan") && testops["plan"].contains("id")) {
+			cfg.plan_id = testops["plan"]["id"].get<int>();
 		}
 
 		return cfg;
@@ -324,6 +4658,21 @@ namespace qase {
 		const char* complete = std::getenv((prefix + "RUN_COMPLETE").c_str());
 		if (complete) cfg.run_complete = std::string(complete) == "true";
 
+		const char* capture_logs = std::getenv((prefix + "CAPTURE_LOGS").c_str());
+		if (capture_logs) cfg.capture_logs = std::string(capture_logs) == "true";
+
+		const char* profile_memory = std::getenv((prefix + "PROFILE_MEMORY").c_str());
+		if (profile_memory) cfg.profile_memory = std::string(profile_memory) == "true";
+
+		const char* delta_path = std::getenv((prefix + "RUN_DELTA_PATH").c_str());
+		if (delta_path) cfg.delta_state_path = delta_path;
+
+		const char* case_cache_path = std::getenv((prefix + "CASE_CACHE_PATH").c_str());
+		if (case_cache_path) cfg.case_cache_path = case_cache_path;
+
+		const char* share_key = std::getenv((prefix + "RUN_SHARE_KEY").c_str());
+		if (share_key) cfg.shared_run_key = share_key;
+
 		return cfg;
 	}
 
@@ -373,60 +4722,489 @@ namespace qase {
 
 		if (incoming.debug) result.debug = true;
 		if (incoming.capture_logs) result.capture_logs = true;
+		if (incoming.capture_logs_max_bytes != QaseConfig::default_capture_logs_max_bytes) {
+			result.capture_logs_max_bytes = incoming.capture_logs_max_bytes;
+		}
+		if (!incoming.capture_logs_failed_only) result.capture_logs_failed_only = false;
+		if (incoming.profile_memory) result.profile_memory = true;
+		if (incoming.recorder_memory_budget > 0) result.recorder_memory_budget = incoming.recorder_memory_budget;
+		if (incoming.recorder_spill != "disk") result.recorder_spill = incoming.recorder_spill;
+		if (!incoming.recorder_spill_path.empty()) result.recorder_spill_path = incoming.recorder_spill_path;
 		if (!incoming.report_driver.empty()) result.report_driver = incoming.report_driver;
 		if (!incoming.report_connection_path.empty()) result.report_connection_path = incoming.report_connection_path;
 		if (!incoming.connection_format.empty()) result.connection_format = incoming.connection_format;
+		if (incoming.report_flush_interval_ms != QaseConfig::default_report_flush_interval_ms) {
+			result.report_flush_interval_ms = incoming.report_flush_interval_ms;
+		}
 
 		if (incoming.enterprise) result.enterprise = true;
 		if (incoming.defect) result.defect = true;
 
 		if (incoming.run_id > 0) result.run_id = incoming.run_id;
+		if (!incoming.delta_state_path.empty()) result.delta_state_path = incoming.delta_state_path;
+		if (incoming.delta_resync_every > 0) result.delta_resync_every = incoming.delta_resync_every;
+		if (incoming.rate_limit_requests_per_sec > 0) result.rate_limit_requests_per_sec = incoming.rate_limit_requests_per_sec;
+		if (incoming.rate_limit_bytes_per_sec > 0) result.rate_limit_bytes_per_sec = incoming.rate_limit_bytes_per_sec;
+		if (incoming.rate_limit_max_retries != QaseConfig::default_rate_limit_max_retries) {
+			result.rate_limit_max_retries = incoming.rate_limit_max_retries;
+		}
 		if (!incoming.run_title.empty()) result.run_title = incoming.run_title;
 		if (!incoming.run_description.empty()) result.run_description = incoming.run_description;
 		if (incoming.plan_id > 0) result.plan_id = incoming.plan_id;
+		if (incoming.include_all_cases) result.include_all_cases = true;
+		if (!incoming.case_cache_path.empty()) result.case_cache_path = incoming.case_cache_path;
+		if (!incoming.shared_run_key.empty()) result.shared_run_key = incoming.shared_run_key;
 		if (incoming.batch_size > 0) result.batch_size = incoming.batch_size;
+		if (incoming.upload_workers > 1) result.upload_workers = incoming.upload_workers;
 
 		return result;
 	}
 
 	void qase_reporter_finish(HttpClient& http, const QaseConfig& cfg) {
-		MinimalQaseApiAdapter adapter;
+#ifndef ESP_PLATFORM
+		stop_log_capture();
+		shutdown_stream_capture();
+
+		// observers have seen every result before the report goes out
+		qase_observers_flush();
+#endif
+
+#ifdef QASE_REPORTER_FULL_MODE_ENABLED
+		// the streamed report is complete before anything is sent
+		const bool streamed = report_stream_close();
+		if (cfg.mode == "report") {
+			if (!streamed) {
+				save_local_report(cfg);
+			}
+			return;
+		}
+#endif
+
 		QaseApi api;
+#ifndef ESP_PLATFORM
+		qase_reporter_resolve_case_ids(api, http, cfg);
+#endif
+#ifdef QASE_REPORTER_FULL_MODE_ENABLED
+		// full QaseApiAdapter is not there yet, submit directly
+		qase_submit_report(api, http, cfg);
+#else
+		MinimalQaseApiAdapter adapter;
 		adapter.submit_report(api, http, cfg);
+#endif
 	}
 
 #ifdef QASE_REPORTER_FULL_MODE_ENABLED
-	void qase_save_report(const std::vector<TestResult>& results, const std::string& path) {
-		// prepare flat JSON for schema
-		nlohmann::json report;
-		report["results"] = nlohmann::json::array();
+	namespace {
+		// builds flat report entries one result at a time, so binary formats can stream them
+		class ReportEntryBuilder {
+		public:
+			nlohmann::json build(const TestResult& r) {
+				nlohmann::json entry;
+				entry["title"] = !r.meta.title.empty() ? r.meta.title : r.name;
+				entry["status"] = r.passed ? "passed" : "failed";
+
+				if (r.meta.case_id > 0) {
+					entry["id"] = "TC-" + std::to_string(r.meta.case_id);
+				}
+
+				for (const auto& [key, val] : r.meta.fields) {
+					try {
+						entry[key] = std::stod(val);
+					} catch (...) {
+						entry[key] = val;
+					}
+				}
+				add_memory_fields(entry, r.memory);
+
+				if (!r.logs.empty()) {
+					entry["message"] = r.logs;
+				}
+
+				// attachments are identified by content: results attaching identical files
+				// reference the same id and the file path it was first seen at
+				if (!r.meta.attachments.empty()) {
+					entry["attachments"] = nlohmann::json::array();
+					for (const auto& path : r.meta.attachments) {
+						auto known_path = path_ids_.find(path);
+						if (known_path == path_ids_.end()) {
+							const std::string id = hash_to_hex(qase_hash_file(path));
+							known_path = path_ids_.emplace(path, id).first;
+							attachments_by_id_.emplace(id, path);
+						}
+
+						const std::string& id = known_path->second;
+						const std::string& file_path = attachments_by_id_.at(id);
+						entry["attachments"].push_back({
+							{"id", id},
+							{"file_name", std::filesystem::path(file_path).filename().string()},
+							{"file_path", file_path},
+							{"mime_type", attachment_mime_type(file_path)}
+						});
+					}
+				}
+
+				// steps follow models/step.json
+				if (!r.steps.empty()) {
+					const std::string id_prefix = std::to_string(entry_count_) + "-";
+					entry["steps"] = nest_steps(r.steps, [&](const QaseStep& step, std::size_t index, std::size_t) {
+						const double start_time = step.start_time_ms / 1000.0;
+						return nlohmann::json{
+							{"id", id_prefix + std::to_string(index)},
+							{"step_type", "text"},
+							{"data", {{"action", step.name}}},
+							{"parent_id", step.parent < 0 ? nlohmann::json(nullptr) : nlohmann::json(id_prefix + std::to_string(step.parent))},
+							{"execution", {
+								{"start_time", start_time},
+								{"end_time", start_time + step.duration_us / 1e6},
+								{"duration", step.duration_us / 1000},
+								{"status", step.passed ? "passed" : "failed"}
+							}}
+						};
+					});
+				}
+
+				++entry_count_;
+				return entry;
+			}
+
+		private:
+			std::size_t entry_count_ = 0;
+
+			// per-report attachment cache: path -> content id, content id -> first path
+			std::unordered_map<std::string, std::string> path_ids_;
+			std::unordered_map<std::string, std::string> attachments_by_id_;
+		};
+
+		// the report is {"results": [...]}, binary formats write the envelope by hand
+		// and encode entries straight into the file as they are built
+		// for_each(emit) calls emit(result) for each of the `count` results, in report order
+		constexpr char report_key[] = "results";
+
+		template <typename ForEach>
+		void write_cbor_report(std::ofstream& out, const ForEach& for_each) {
+			ReportEntryBuilder builder;
 
-		for (const auto& r : results) {
-			nlohmann::json entry;
-			entry["title"] = !r.meta.title.empty() ? r.meta.title : r.name;
-			entry["status"] = r.passed ? "passed" : "failed";
+			// map(1), text(7) "results", indefinite-length array
+			out.put(static_cast<char>(0xA1));
+			out.put(static_cast<char>(0x60 | (sizeof(report_key) - 1)));
+			out.write(report_key, sizeof(report_key) - 1);
+			out.put(static_cast<char>(0x9F));
 
-			if (r.meta.case_id > 0) {
-				entry["id"] = "TC-" + std::to_string(r.meta.case_id);
+			for_each([&](const TestResult& r) {
+				nlohmann::json::to_cbor(builder.build(r), out);
+			});
+
+			// break
+			out.put(static_cast<char>(0xFF));
+		}
+
+		template <typename ForEach>
+		void write_msgpack_report(std::ofstream& out, std::size_t count, const ForEach& for_each) {
+			ReportEntryBuilder builder;
+
+			// fixmap(1), fixstr(7) "results", array32 with the count known upfront
+			out.put(static_cast<char>(0x81));
+			out.put(static_cast<char>(0xA0 | (sizeof(report_key) - 1)));
+			out.write(report_key, sizeof(report_key) - 1);
+
+			const uint32_t size = static_cast<uint32_t>(count);
+			out.put(static_cast<char>(0xDD));
+			for (int shift = 24; shift >= 0; shift -= 8) {
+				out.put(static_cast<char>((size >> shift) & 0xFF));
 			}
 
-			for (const auto& [key, val] : r.meta.fields) {
-				try {
-					entry[key] = std::stod(val);
-				} catch (...) {
-					entry[key] = val;
+			for_each([&](const TestResult& r) {
+				nlohmann::json::to_msgpack(builder.build(r), out);
+			});
+		}
+
+		template <typename ForEach>
+		void save_report(const std::string& path, const std::string& format, std::size_t count, const ForEach& for_each) {
+			if (format != "json" && format != "ndjson" && format != "cbor" && format != "msgpack") {
+				throw std::invalid_argument("Unsupported report format: " + format);
+			}
+
+			std::ofstream out(path, std::ios::binary);
+			if (!out) {
+				throw std::runtime_error("Failed to open file for writing report");
+			}
+
+			if (format == "cbor") {
+				write_cbor_report(out, for_each);
+			} else if (format == "msgpack") {
+				write_msgpack_report(out, count, for_each);
+			} else if (format == "ndjson") {
+				ReportEntryBuilder builder;
+				for_each([&](const TestResult& r) {
+					out << builder.build(r).dump() << '\n';
+				});
+			} else {
+				// prepare flat JSON for schema
+				ReportEntryBuilder builder;
+				nlohmann::json report;
+				report["results"] = nlohmann::json::array();
+				for_each([&](const TestResult& r) {
+					report["results"].push_back(builder.build(r));
+				});
+				out << report.dump(2);
+			}
+
+			out.close();
+			if (!out) {
+				throw std::runtime_error("Failed to write report: " + path);
+			}
+		}
+	}
+
+	// an ndjson report has a whole entry on its first line, the JSON report only "{"
+	// or the complete {"results": [...]}; returns false if it's not ndjson
+	static bool read_ndjson_report(std::istream& in, nlohmann::json& report) {
+		std::string line;
+		std::getline(in, line);
+		nlohmann::json entry = nlohmann::json::parse(line, nullptr, false);
+		if (entry.is_discarded() || !entry.is_object() || entry.contains(report_key)) {
+			return false;
+		}
+
+		report[report_key] = nlohmann::json::array();
+		do {
+			if (line.empty()) {
+				continue;
+			}
+			entry = nlohmann::json::parse(line, nullptr, false);
+			if (entry.is_discarded()) {
+				// the run was interrupted halfway through writing this line
+				break;
+			}
+			report[report_key].push_back(std::move(entry));
+		} while (std::getline(in, line));
+		return true;
+	}
+
+	// ========= STREAMED NDJSON REPORT =======
+
+	// lines are collected in a buffer and written out once it's full; a flusher thread writes
+	// out lines that waited for the flush interval, so a hanging test doesn't hold them back
+	static void report_stream_stop_flusher();
+
+	static struct ReportStream {
+		static constexpr std::size_t buffer_size = 64 * 1024;
+
+		int fd = -1;
+		std::string path;
+		bool results_kept = true;
+		std::chrono::milliseconds flush_interval{0};
+		std::chrono::steady_clock::time_point last_flush;
+		std::string buffer;
+		std::unique_ptr<ReportEntryBuilder> builder;
+
+		// guards buffer, last_flush and error against the flusher
+		std::mutex mutex;
+		std::condition_variable wake;
+		std::thread flusher;
+		bool stopping = false;
+
+		// a failed write of the flusher, thrown by the next write or the close
+		std::exception_ptr error;
+
+		~ReportStream() { report_stream_stop_flusher(); }
+	} report_stream;
+
+	static std::string local_report_path(const QaseConfig& cfg) {
+		if (!cfg.report_connection_path.empty()) {
+			return cfg.report_connection_path;
+		}
+		return "qase-report." + cfg.connection_format;
+	}
+
+	// called with the stream mutex held
+	static void report_stream_flush() {
+		ReportStream& stream = report_stream;
+		std::size_t written = 0;
+		while (written < stream.buffer.size()) {
+			ssize_t n = write(stream.fd, stream.buffer.data() + written, stream.buffer.size() - written);
+			if (n < 0 && errno == EINTR) {
+				continue;
+			}
+			if (n <= 0) {
+				throw std::runtime_error("Failed to write report: " + stream.path);
+			}
+			written += static_cast<std::size_t>(n);
+		}
+		stream.buffer.clear();
+		stream.last_flush = std::chrono::steady_clock::now();
+	}
+
+	static void report_stream_flush_loop() {
+		ReportStream& stream = report_stream;
+		std::unique_lock<std::mutex> lock(stream.mutex);
+		while (!stream.stopping) {
+			if (stream.buffer.empty() || stream.error) {
+				stream.wake.wait(lock);
+				continue;
+			}
+			const auto due = stream.last_flush + stream.flush_interval;
+			if (std::chrono::steady_clock::now() < due) {
+				stream.wake.wait_until(lock, due);
+				continue;
+			}
+			try {
+				report_stream_flush();
+			} catch (...) {
+				stream.error = std::current_exception();
+			}
+		}
+	}
+
+	static void report_stream_stop_flusher() {
+		ReportStream& stream = report_stream;
+		if (!stream.flusher.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(stream.mutex);
+			stream.stopping = true;
+		}
+		stream.wake.notify_all();
+		stream.flusher.join();
+		stream.stopping = false;
+	}
+
+	static void report_stream_open(const QaseConfig& cfg) {
+		report_stream_close();
+		if (cfg.connection_format != "ndjson") {
+			return;
+		}
+
+		ReportStream& stream = report_stream;
+		stream.path = local_report_path(cfg);
+		stream.fd = open(stream.path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+		if (stream.fd < 0) {
+			throw std::runtime_error("Failed to open file for writing report");
+		}
+
+		stream.results_kept = cfg.mode != "report";
+		stream.flush_interval = std::chrono::milliseconds(cfg.report_flush_interval_ms);
+		stream.last_flush = std::chrono::steady_clock::now();
+		stream.buffer.reserve(ReportStream::buffer_size);
+		stream.builder = std::make_unique<ReportEntryBuilder>();
+		stream.error = nullptr;
+
+		// with no interval every line is written right away
+		if (stream.flush_interval.count() > 0) {
+			stream.flusher = std::thread(report_stream_flush_loop);
+		}
+	}
+
+	// returns true if the result isn't needed in memory anymore
+	static bool report_stream_write(const TestResult& result) {
+		ReportStream& stream = report_stream;
+		if (stream.fd < 0) {
+			return false;
+		}
+
+		std::string line = stream.builder->build(result).dump();
+		line += '\n';
+
+		std::lock_guard<std::mutex> lock(stream.mutex);
+		if (stream.error) {
+			std::rethrow_exception(stream.error);
+		}
+		const bool was_empty = stream.buffer.empty();
+		stream.buffer += line;
+		if (stream.buffer.size() >= ReportStream::buffer_size || stream.flush_interval.count() <= 0) {
+			report_stream_flush();
+		} else if (was_empty) {
+			stream.wake.notify_all();
+		}
+		return !stream.results_kept;
+	}
+
+	// returns false if there was no stream open
+	static bool report_stream_close() {
+		ReportStream& stream = report_stream;
+		if (stream.fd < 0) {
+			return false;
+		}
+
+		report_stream_stop_flusher();
+		const int fd = stream.fd;
+		try {
+			if (stream.error) {
+				std::rethrow_exception(stream.error);
+			}
+			report_stream_flush();
+		} catch (...) {
+			close(fd);
+			stream.fd = -1;
+			throw;
+		}
+		close(fd);
+		stream.fd = -1;
+		stream.builder.reset();
+		return true;
+	}
+
+	void qase_save_report(const std::vector<TestResult>& results, const std::string& path, const std::string& format) {
+		save_report(path, format, results.size(), [&results](const auto& emit) {
+			for (const auto& r : results) {
+				emit(r);
+			}
+		});
+	}
+
+	// the report of "report" mode: results over the recorder's memory budget are read back
+	// from the segment ahead of the ones still in memory, a budget's worth at a time
+	static void save_local_report(const QaseConfig& cfg) {
+#ifndef ESP_PLATFORM
+		const std::size_t count = recorder_spill.spilled + collected.size();
+#else
+		const std::size_t count = collected.size();
+#endif
+		save_report(local_report_path(cfg), cfg.connection_format, count, [](const auto& emit) {
+#ifndef ESP_PLATFORM
+			spill_replay([&emit](std::vector<TestResult>& chunk) {
+				for (const auto& r : chunk) {
+					emit(r);
 				}
+			});
+#endif
+			for (const auto& r : collected) {
+				emit(r);
 			}
+		});
+		spill_clear();
+	}
+
+	void qase_convert_report(const std::string& source, const std::string& destination) {
+		std::ifstream in(source, std::ios::binary);
+		if (!in) {
+			throw std::runtime_error("Could not open report file: " + source);
+		}
 
-			report["results"].push_back(entry);
+		// the first byte tells the formats apart: a map header for cbor (0xA0..0xBF) or
+		// msgpack (fixmap 0x80..0x8F, map16/32), anything else is read as json
+		const int first = in.peek();
+		nlohmann::json report;
+		try {
+			if (first >= 0xA0 && first <= 0xBF) {
+				report = nlohmann::json::from_cbor(in);
+			} else if ((first >= 0x80 && first <= 0x8F) || first == 0xDE || first == 0xDF) {
+				report = nlohmann::json::from_msgpack(in);
+			} else if (!read_ndjson_report(in, report)) {
+				in.clear();
+				in.seekg(0);
+				in >> report;
+			}
+		} catch (const nlohmann::json::exception& e) {
+			throw std::runtime_error("Failed to parse report " + source + ": " + e.what());
 		}
 
-		std::ofstream out(path);
+		std::ofstream out(destination);
 		if (!out) {
 			throw std::runtime_error("Failed to open file for writing report");
 		}
 		out << report.dump(2);
-		out.close();
 	}
 #endif
 
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <unistd.h>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// http client that consumes streamed bodies chunk by chunk, like a real socket writer would
+struct StreamingFakeHttpClient : public FakeHttpClient {
+	std::size_t streamed_bytes = 0;
+	std::size_t declared_size = 0;
+	std::size_t max_chunk = 0;
+	std::string body_head;
+	std::size_t max_resident_growth = 0;
+
+	std::string post_stream(const std::string& url, HttpBodySource& body, const std::vector<std::string>& headers) override {
+		called_url = url;
+		called_headers = headers;
+		declared_size = body.size();
+
+		const std::size_t resident_before = resident_bytes();
+		std::vector<char> chunk(64 * 1024);
+		while (std::size_t n = body.read(chunk.data(), chunk.size())) {
+			if (body_head.size() < 256) {
+				body_head.append(chunk.data(), std::min<std::size_t>(n, 256));
+			}
+			streamed_bytes += n;
+			max_chunk = std::max(max_chunk, n);
+			if (streamed_bytes % (4 * 1024 * 1024) < chunk.size()) {
+				const std::size_t resident = resident_bytes();
+				if (resident > resident_before) {
+					max_resident_growth = std::max(max_resident_growth, resident - resident_before);
+				}
+			}
+		}
+		return canned_response;
+	}
+
+	// resident set size from /proc, 0 where it isn't available
+	static std::size_t resident_bytes() {
+		std::ifstream statm("/proc/self/statm");
+		std::size_t total_pages = 0, resident_pages = 0;
+		if (!(statm >> total_pages >> resident_pages)) {
+			return 0;
+		}
+		return resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	}
+};
+
+std::string write_attachment_file(const std::string& path, std::size_t size) {
+	std::ofstream out(path, std::ios::binary);
+	std::string block(1024 * 1024, 'q');
+	for (std::size_t written = 0; written < size; written += block.size()) {
+		out.write(block.data(), std::min(block.size(), size - written));
+	}
+	return path;
+}
+
+// a large attachment is uploaded as a streamed multipart body: read in bounded chunks,
+// never held in memory as a whole
+void test_upload_attachment_streams_file_in_chunks() {
+	const std::size_t file_size = 64 * 1024 * 1024;
+	const std::string path = write_attachment_file("qase_big_attachment.bin", file_size);
+
+	QaseApi api;
+	StreamingFakeHttpClient http;
+	http.canned_response = R"({ "status": true, "result": [ { "hash": "abc123", "filename": "qase_big_attachment.bin" } ] })";
+
+	std::string hash = api.qase_upload_attachment(http, make_test_config(), path);
+
+	assert(hash == "abc123");
+	assert(http.called_url == "https://api.qase.io/v1/attachment/ET1");
+	assert(http.streamed_bytes == http.declared_size);
+	assert(http.streamed_bytes > file_size);
+	assert(http.max_chunk <= 64 * 1024);
+	assert(http.body_head.find("filename=\"qase_big_attachment.bin\"") != std::string::npos);
+
+	bool multipart = false;
+	for (const auto& header : http.called_headers) {
+		multipart = multipart || header.find("content-type: multipart/form-data; boundary=") == 0;
+	}
+	assert(multipart && "Expected multipart content type");
+
+	// sent pages are released, resident memory doesn't follow the file size
+	assert(http.max_resident_growth < file_size / 4);
+
+	std::remove(path.c_str());
+}
+
+// clients that don't support streaming still work: the default post_stream buffers the body
+void test_upload_attachment_falls_back_to_buffered_post() {
+	const std::string path = "qase_small_attachment.log";
+	std::ofstream(path) << "boot log contents";
+
+	QaseApi api;
+	FakeHttpClient http;
+	http.canned_response = R"({ "status": true, "result": [ { "hash": "def456" } ] })";
+
+	assert(api.qase_upload_attachment(http, make_test_config(), path) == "def456");
+	assert(http.called_payload.find("boot log contents") != std::string::npos);
+	assert(http.called_payload.find("Content-Type: text/plain") != std::string::npos);
+
+	std::remove(path.c_str());
+}
+
+// an api written before attachments and case creation existed still builds and
+// submits, and only fails once it's asked for either
+struct RunOnlyQaseApi : public IQaseApi {
+	uint64_t qase_start_run(HttpClient&, const QaseConfig&, const std::vector<int>& = {}) override { return 7; }
+	bool qase_submit_results(HttpClient&, const QaseConfig&, uint64_t, const std::string&) override { return true; }
+	bool qase_complete_run(HttpClient&, const QaseConfig&, uint64_t) override { return true; }
+};
+
+void test_upload_attachment_is_optional_for_apis() {
+	RunOnlyQaseApi api;
+	FakeHttpClient http;
+
+	qase_reporter_reset();
+	qase_reporter_add_result("no_attachments", true);
+	qase_submit_report(api, http, make_test_config());
+
+	bool threw = false;
+	try {
+		api.qase_upload_attachment(http, make_test_config(), "boot.log");
+	} catch (const std::runtime_error& e) {
+		threw = std::string(e.what()).find("not supported") != std::string::npos;
+	}
+	assert(threw);
+
+	threw = false;
+	try {
+		api.qase_create_cases(http, make_test_config(), {"Boots"});
+	} catch (const std::runtime_error& e) {
+		threw = std::string(e.what()).find("not supported") != std::string::npos;
+	}
+	assert(threw);
+	qase_reporter_reset();
+}
+
+// every attached file is uploaded once before the run starts,
+// and results reference it by hash
+void test_orchestrator_uploads_attachments_before_submit() {
+	std::ofstream("firmware.bin") << "firmware image";
+	std::ofstream("first.log") << "first log";
+
+	qase_reporter_reset();
+
+	QaseResultMeta first;
+	first.attachments = {"firmware.bin", "first.log"};
+	qase_reporter_add_result("first", false, std::move(first));
+
+	QaseResultMeta second;
+	second.attachments = {"firmware.bin"};
+	qase_reporter_add_result("second", false, std::move(second));
+
+	FakeQaseApi api;
+	FakeHttpClient http;
+	qase_submit_report(api, http, make_test_config());
+
+	assert((api.calls == std::vector<std::string>{"upload", "upload", "start", "submit", "complete"}));
+	assert((api.uploaded_paths == std::vector<std::string>{"firmware.bin", "first.log"}));
+
+	auto payload = nlohmann::json::parse(api.submit_payload);
+	assert((payload["results"][0]["attachments"] == nlohmann::json{"hash-1", "hash-2"}));
+	assert((payload["results"][1]["attachments"] == nlohmann::json{"hash-1"}));
+
+	std::remove("firmware.bin");
+	std::remove("first.log");
+}
+
+// files are hashed by content through the mapping, in windows, with the same result
+// as hashing the bytes in one go
+void test_hash_file_matches_in_memory_hash() {
+	std::string content(9 * 1024 * 1024 + 13, '\0');
+	for (std::size_t i = 0; i < content.size(); ++i) {
+		content[i] = static_cast<char>(i * 31 + 7);
+	}
+	std::ofstream("qase_hash_input.bin", std::ios::binary) << content;
+
+	assert(qase_hash_file("qase_hash_input.bin") == qase_hash64(content.data(), content.size()));
+	assert(qase_hash64("", 0) == 0xEF46DB3751D8E999ULL);
+	assert(qase_hash64("abc", 3) != qase_hash64("abd", 3));
+
+	std::remove("qase_hash_input.bin");
+}
+
+// identical files under different paths are uploaded once and shared by every result
+void test_orchestrator_deduplicates_attachments_by_content() {
+	std::ofstream("dump_a.bin") << "same crash dump";
+	std::ofstream("dump_b.bin") << "same crash dump";
+	std::ofstream("dump_c.bin") << "another crash dump";
+
+	qase_reporter_reset();
+	for (const char* path : {"dump_a.bin", "dump_b.bin", "dump_c.bin", "dump_a.bin"}) {
+		QaseResultMeta meta;
+		meta.attachments = {path};
+		qase_reporter_add_result(std::string("crash_") + path, false, std::move(meta));
+	}
+
+	FakeQaseApi api;
+	FakeHttpClient http;
+	qase_submit_report(api, http, make_test_config());
+
+	assert((api.uploaded_paths == std::vector<std::string>{"dump_a.bin", "dump_c.bin"}));
+
+	auto payload = nlohmann::json::parse(api.submit_payload);
+	assert((payload["results"][0]["attachments"] == nlohmann::json{"hash-1"}));
+	assert((payload["results"][1]["attachments"] == nlohmann::json{"hash-1"}));
+	assert((payload["results"][2]["attachments"] == nlohmann::json{"hash-2"}));
+	assert((payload["results"][3]["attachments"] == nlohmann::json{"hash-1"}));
+
+	std::remove("dump_a.bin");
+	std::remove("dump_b.bin");
+	std::remove("dump_c.bin");
+}
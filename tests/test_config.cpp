@@ -124,6 +124,32 @@ void test_load_qase_config_throws_on_empty_fields() {
 	std::remove(config_path.c_str());
 }
 
+// a recorder setting of the wrong type is an error, not a budget quietly turned off
+void test_load_qase_config_throws_on_invalid_recorder() {
+	const std::string config_path = "invalid_recorder_config.json";
+
+	for (const std::string recorder : {
+			R"({"memoryBudget": "64MB"})",
+			R"({"memoryBudget": -1})",
+			R"({"memoryBudget": 1.5})",
+			R"({"spill": 1})",
+			R"({"spillPath": false})"}) {
+		std::ofstream out(config_path);
+		out << R"({"testops": {"api": {"token": "T"}, "project": "P"}, "recorder": )" << recorder << "}";
+		out.close();
+
+		bool threw = false;
+		try {
+			load_qase_config_from_file(config_path);
+		} catch (const std::runtime_error& e) {
+			threw = std::string(e.what()).find("Invalid recorder.") != std::string::npos;
+		}
+		assert(threw && "Expected exception due to a mistyped recorder setting");
+	}
+
+	std::remove(config_path.c_str());
+}
+
 void test_resolve_config_uses_file_if_nothing_else() {
 	const std::string config_path = "file_only_config.json";
 
@@ -308,3 +334,151 @@ void test_load_qase_config_parses_run_complete() {
 
 	std::remove(config_path.c_str());
 }
+
+// log capture options are read from the config file
+void test_load_qase_config_parses_capture_logs_options() {
+	const std::string config_path = "config_with_capture_logs.json";
+
+	std::ofstream out(config_path);
+	out << R"({
+		"captureLogs": true,
+		"captureLogsMaxBytes": 1024,
+		"captureLogsFailedOnly": false,
+		"testops": {
+			"api": {
+				"token": "token_value"
+			},
+			"project": "project_value"
+		}
+	})";
+	out.close();
+
+	QaseConfig cfg = load_qase_config_from_file(config_path);
+
+	assert(cfg.capture_logs == true);
+	assert(cfg.capture_logs_max_bytes == 1024);
+	assert(cfg.capture_logs_failed_only == false);
+
+	// and survive merging over defaults
+	QaseConfig merged = merge_config(QaseConfig(), cfg);
+	assert(merged.capture_logs_max_bytes == 1024);
+	assert(merged.capture_logs_failed_only == false);
+
+	std::remove(config_path.c_str());
+}
+
+// delta submission options live under testops.run.delta, next to the shard share key
+void test_load_qase_config_parses_delta_options() {
+	const std::string config_path = "config_with_delta.json";
+
+	std::ofstream out(config_path);
+	out << R"({
+		"testops": {
+			"api": {
+				"token": "token_value"
+			},
+			"project": "project_value",
+			"run": {
+				"id": 12,
+				"shareKey": "pipeline-1234",
+				"delta": {
+					"path": "build/qase-delta.bin",
+					"resyncEvery": 24
+				}
+			}
+		}
+	})";
+	out.close();
+
+	QaseConfig cfg = load_qase_config_from_file(config_path);
+
+	assert(cfg.delta_state_path == "build/qase-delta.bin");
+	assert(cfg.delta_resync_every == 24);
+	assert(cfg.shared_run_key == "pipeline-1234");
+
+	QaseConfig merged = merge_config(QaseConfig(), cfg);
+	assert(merged.delta_state_path == "build/qase-delta.bin");
+	assert(merged.delta_resync_every == 24);
+	assert(merged.shared_run_key == "pipeline-1234");
+
+	std::remove(config_path.c_str());
+}
+
+void test_load_qase_config_parses_batch_options() {
+	const std::string config_path = "config_with_batch.json";
+
+	std::ofstream out(config_path);
+	out << R"({
+		"testops": {
+			"api": {
+				"token": "token_value"
+			},
+			"project": "project_value",
+			"batch": {
+				"size": 50,
+				"workers": 4
+			}
+		}
+	})";
+	out.close();
+
+	QaseConfig cfg = load_qase_config_from_file(config_path);
+
+	assert(cfg.batch_size == 50);
+	assert(cfg.upload_workers == 4);
+	assert(merge_config(QaseConfig(), cfg).upload_workers == 4);
+
+	// a batch size of the wrong type is ignored like any other mistyped option
+	std::ofstream(config_path) << R"({
+		"testops": {
+			"api": { "token": "token_value" },
+			"project": "project_value",
+			"batch": { "size": "50" }
+		}
+	})";
+	assert(load_qase_config_from_file(config_path).batch_size == QaseConfig().batch_size);
+
+	std::remove(config_path.c_str());
+}
+
+void test_load_qase_config_parses_report_options() {
+	const std::string config_path = "config_with_report.json";
+
+	std::ofstream out(config_path);
+	out << R"({
+		"testops": {
+			"api": {
+				"token": "token_value"
+			},
+			"project": "project_value",
+			"report": {
+				"connection": {
+					"path": "build/report.ndjson",
+					"format": "ndjson",
+					"flushIntervalMs": 250
+				}
+			}
+		}
+	})";
+	out.close();
+
+	QaseConfig cfg = load_qase_config_from_file(config_path);
+
+	assert(cfg.connection_format == "ndjson");
+	assert(cfg.report_connection_path == "build/report.ndjson");
+	assert(cfg.report_flush_interval_ms == 250);
+	assert(merge_config(QaseConfig(), cfg).report_flush_interval_ms == 250);
+
+	// a mistyped interval is ignored like any other mistyped option
+	std::ofstream(config_path) << R"({
+		"testops": {
+			"api": { "token": "token_value" },
+			"project": "project_value",
+			"report": { "connection": { "flushIntervalMs": "250" } }
+		}
+	})";
+	assert(load_qase_config_from_file(config_path).report_flush_interval_ms ==
+		QaseConfig::default_report_flush_interval_ms);
+
+	std::remove(config_path.c_str());
+}
@@ -0,0 +1,133 @@
+#include <iostream>
+#include <cassert>
+#include <csignal>
+#include <fstream>
+#include <iterator>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// records two results in a child process, then crashes it in the middle of a third test
+static int run_crashing_child(const std::string& journal_path, int sig) {
+	std::cout.flush();
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid == 0) {
+		qase_reporter_reset();
+		qase_crash_handler_install(journal_path);
+		qase_reporter_add_result("test_boots", true);
+		qase_reporter_add_result("test_reads_sensor", false);
+		qase_reporter_begin_test("test_crashes");
+		if (sig == SIGABRT) {
+			abort();
+		}
+		raise(sig);
+		_exit(0);
+	}
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return status;
+}
+
+// the journal holds the recorded results and a failed one for the test that crashed,
+// and the signal still terminates the process
+void test_crash_handler_journals_running_test() {
+	const std::string path = "test_crash_journal.bin";
+	std::remove(path.c_str());
+
+	int status = run_crashing_child(path, SIGABRT);
+	assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+
+	std::ifstream in(path, std::ios::binary);
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	assert(!bytes.empty());
+
+	QaseSerialDecoder decoder;
+	decoder.feed(bytes.data(), bytes.size());
+	std::vector<TestResult> decoded;
+	decoder.take_results(decoded);
+
+	assert(decoder.corrupt_frames() == 0);
+	assert(decoded.size() == 3);
+	assert(decoded[0].name == "test_boots" && decoded[0].passed);
+	assert(decoded[1].name == "test_reads_sensor" && !decoded[1].passed);
+	assert(decoded[2].name == "test_crashes" && !decoded[2].passed);
+	assert(decoded[2].logs == "Crashed with SIGABRT");
+
+	std::remove(path.c_str());
+}
+
+// a handler installed once results went over the memory budget journals the spilled ones too
+void test_crash_handler_journals_spilled_results() {
+	const std::string path = "test_crash_journal_spill.bin";
+	std::remove(path.c_str());
+
+	std::cout.flush();
+	pid_t pid = fork();
+	assert(pid >= 0);
+	if (pid == 0) {
+		QaseConfig cfg;
+		cfg.recorder_memory_budget = 2000;
+		cfg.recorder_spill_path = "test_crash_journal_spill.seg";
+		qase_reporter_configure(cfg);
+		qase_reporter_reset();
+		for (int i = 0; i < 50; ++i) {
+			qase_reporter_add_result("test_soak_" + std::to_string(i), true);
+		}
+		qase_crash_handler_install(path);
+		qase_reporter_begin_test("test_crashes");
+		abort();
+	}
+	int status = 0;
+	waitpid(pid, &status, 0);
+	assert(WIFSIGNALED(status));
+	std::remove("test_crash_journal_spill.seg");
+
+	std::ifstream in(path, std::ios::binary);
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	QaseSerialDecoder decoder;
+	decoder.feed(bytes.data(), bytes.size());
+	std::vector<TestResult> decoded;
+	decoder.take_results(decoded);
+	assert(decoded.size() == 51);
+	assert(decoded[0].name == "test_soak_0");
+	assert(decoded[49].name == "test_soak_49");
+	assert(decoded[50].name == "test_crashes" && !decoded[50].passed);
+
+	std::remove(path.c_str());
+}
+
+// the next start submits the journal and removes it; a run that didn't crash leaves none
+void test_crash_recover_submits_journal() {
+	const std::string path = "test_crash_recover.bin";
+	std::remove(path.c_str());
+
+	int status = run_crashing_child(path, SIGSEGV);
+	assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV);
+
+	FakeQaseApi api;
+	FakeHttpClient http;
+	QaseConfig cfg = make_test_config();
+
+	assert(qase_crash_recover(path, api, http, cfg));
+	assert((api.calls == std::vector<std::string>{"start", "submit", "complete"}));
+
+	auto payload = nlohmann::json::parse(api.submit_payload);
+	assert(payload["results"].size() == 3);
+	assert(payload["results"][2]["case"]["title"] == "test_crashes");
+	assert(payload["results"][2]["status"] == "failed");
+
+	assert(access(path.c_str(), F_OK) != 0);
+	assert(!qase_crash_recover(path, api, http, cfg));
+
+	qase_reporter_reset();
+	qase_crash_handler_install(path);
+	qase_reporter_add_result("test_boots", true);
+	qase_crash_handler_uninstall();
+	qase_reporter_reset();
+	assert(access(path.c_str(), F_OK) != 0);
+}
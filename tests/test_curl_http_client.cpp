@@ -0,0 +1,142 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "qase_curl_http_client.h"
+#include "qase_loopback_server.h"
+
+using namespace qase;
+
+// body source over a string, read in small pieces
+struct StringBodySource : public HttpBodySource {
+	std::string data;
+	std::size_t offset = 0;
+
+	explicit StringBodySource(std::string data) : data(std::move(data)) {}
+
+	std::size_t size() const override { return data.size(); }
+
+	std::size_t read(char* buf, std::size_t max) override {
+		std::size_t n = std::min<std::size_t>({max, data.size() - offset, 1000});
+		std::memcpy(buf, data.data() + offset, n);
+		offset += n;
+		return n;
+	}
+
+	bool rewind() override {
+		offset = 0;
+		return true;
+	}
+};
+
+// request headers and body reach the server, status and headers of the response come back
+void test_curl_client_posts_and_reads_response() {
+	std::mutex mutex;
+	LoopbackRequest seen;
+	QaseLoopbackServer server([&](const LoopbackRequest& request) {
+		std::lock_guard<std::mutex> lock(mutex);
+		seen = request;
+		LoopbackResponse response;
+		response.status = 429;
+		response.headers = {"Retry-After: 3"};
+		response.body = R"({"status":false})";
+		return response;
+	});
+
+	QaseCurlHttpClient http;
+	HttpResponse response = http.post_with_response(server.url("/v1/result/DEMO/1/bulk"),
+		R"({"results":[]})", {"Token: abc", "Content-Type: application/json"});
+
+	assert(response.status == 429);
+	assert(response.body == R"({"status":false})");
+	assert(std::find(response.headers.begin(), response.headers.end(), "Retry-After: 3") != response.headers.end());
+
+	assert(seen.method == "POST");
+	assert(seen.path == "/v1/result/DEMO/1/bulk");
+	assert(seen.header("Token") == "abc");
+	assert(seen.body == R"({"results":[]})");
+}
+
+// sequential requests go over one pooled connection, concurrent ones over at most
+// max_host_connections
+void test_curl_client_reuses_connections() {
+	QaseLoopbackServer server([](const LoopbackRequest&) {
+		LoopbackResponse response;
+		response.body = "{}";
+		response.delay = std::chrono::milliseconds(2);
+		return response;
+	});
+
+	QaseCurlOptions options;
+	options.max_host_connections = 2;
+	auto transport = std::make_shared<QaseCurlTransport>(options);
+
+	QaseCurlHttpClient http(transport);
+	for (int i = 0; i < 20; ++i) {
+		assert(http.post(server.url("/v1/run/DEMO"), "{}", {}) == "{}");
+	}
+	assert(server.connections() == 1);
+	assert(transport->connections_opened() == 1);
+
+	std::vector<std::thread> workers;
+	for (int w = 0; w < 6; ++w) {
+		workers.emplace_back([&] {
+			QaseCurlHttpClient worker_http(transport);
+			for (int i = 0; i < 10; ++i) {
+				worker_http.post(server.url("/v1/run/DEMO"), "{}", {});
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	assert(server.requests() == 80);
+	assert(server.connections() <= 2);
+}
+
+// streamed bodies are read piece by piece and arrive whole
+void test_curl_client_streams_body() {
+	std::mutex mutex;
+	std::string received;
+	QaseLoopbackServer server([&](const LoopbackRequest& request) {
+		std::lock_guard<std::mutex> lock(mutex);
+		received = request.body;
+		LoopbackResponse response;
+		response.body = R"({"status":true})";
+		return response;
+	});
+
+	std::string payload(100 * 1024, 'a');
+	for (std::size_t i = 0; i < payload.size(); i += 7) {
+		payload[i] = static_cast<char>('a' + i % 26);
+	}
+	StringBodySource source(payload);
+
+	QaseCurlHttpClient http;
+	assert(http.post_stream(server.url("/v1/attachment/DEMO"), source, {}) == R"({"status":true})");
+	assert(received == payload);
+}
+
+// a server that doesn't answer fails the request once the timeout is up
+void test_curl_client_times_out() {
+	QaseLoopbackServer server([](const LoopbackRequest&) {
+		LoopbackResponse response;
+		response.delay = std::chrono::milliseconds(3000);
+		return response;
+	});
+
+	QaseCurlOptions options;
+	options.request_timeout_ms = 200;
+	QaseCurlHttpClient http(options);
+
+	const auto start = std::chrono::steady_clock::now();
+	bool threw = false;
+	try {
+		http.post(server.url("/v1/run/DEMO"), "{}", {});
+	} catch (const std::runtime_error& e) {
+		threw = std::string(e.what()).find("HTTP request failed") != std::string::npos;
+	}
+	assert(threw);
+	assert(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(2000));
+}
@@ -1,5 +1,6 @@
 #ifdef QASE_REPORTER_FULL_MODE_ENABLED
 #include <cassert>
+#include <filesystem>
 #include <nlohmann/json.hpp>
 #include "json_schema_validator.h"
 
@@ -61,4 +62,20 @@ void test_invalid_json_fails_schema() {
 	assert(threw && "Expected invalid JSON to fail schema validation");
 }
 
+// the schemas are embedded, so validation works from any working directory
+void test_schema_validation_needs_no_schema_files() {
+	const auto original = std::filesystem::current_path();
+	std::filesystem::current_path(std::filesystem::temp_directory_path());
+
+	bool threw = false;
+	try {
+		validate_json_payload({{"results", "this should be an array"}});
+	} catch (const std::exception& e) {
+		threw = true;
+	}
+
+	std::filesystem::current_path(original);
+	assert(threw && "Expected validation against the embedded schema");
+}
+
 #endif
@@ -1,3 +1,6 @@
+#include <chrono>
+#include <thread>
+#include <filesystem>
 #include "qase_reporter.h"
 #include "json_schema_validator.h"
 
@@ -39,3 +42,192 @@ void test_qase_save_report_writes_valid_schema_json() {
 	std::remove(path.c_str());
 }
 
+
+// attachments in the local report are identified by content: identical files share one id
+void test_qase_save_report_deduplicates_attachments() {
+	std::ofstream("report_dump_a.bin") << "same crash dump";
+	std::ofstream("report_dump_b.bin") << "same crash dump";
+
+	qase_reporter_reset();
+	for (const char* path : {"report_dump_a.bin", "report_dump_b.bin"}) {
+		QaseResultMeta meta;
+		meta.attachments = {path};
+		qase_reporter_add_result(std::string("crash_") + path, false, std::move(meta));
+	}
+
+	std::string path = "qase_test_report_attachments.json";
+	qase_save_report(qase_reporter_get_results(), path);
+
+	nlohmann::json report;
+	std::ifstream(path) >> report;
+
+	const auto& a = report["results"][0]["attachments"][0];
+	const auto& b = report["results"][1]["attachments"][0];
+	assert(a["id"] == b["id"]);
+	assert(a["file_path"] == "report_dump_a.bin");
+	assert(b["file_path"] == "report_dump_a.bin");
+
+	std::remove(path.c_str());
+	std::remove("report_dump_a.bin");
+	std::remove("report_dump_b.bin");
+}
+
+// binary reports are smaller than the pretty-printed JSON and convert back to the same report
+void test_qase_save_report_binary_formats_round_trip() {
+	qase_reporter_reset();
+	for (int i = 0; i < 20; ++i) {
+		QaseResultMeta meta;
+		meta.case_id = i + 1;
+		meta.fields["priority"] = "high";
+		meta.fields["severity"] = "2";
+		qase_reporter_add_result("archived_test_" + std::to_string(i), i % 3 != 0, std::move(meta));
+	}
+
+	qase_save_report(qase_reporter_get_results(), "qase_test_report_archive.json");
+	nlohmann::json expected;
+	std::ifstream("qase_test_report_archive.json") >> expected;
+	const auto json_size = std::filesystem::file_size("qase_test_report_archive.json");
+
+	for (const std::string format : {"cbor", "msgpack"}) {
+		const std::string path = "qase_test_report_archive." + format;
+		qase_save_report(qase_reporter_get_results(), path, format);
+		assert(std::filesystem::file_size(path) < json_size);
+
+		qase_convert_report(path, "qase_test_report_converted.json");
+		nlohmann::json converted;
+		std::ifstream("qase_test_report_converted.json") >> converted;
+		assert(converted == expected);
+
+		std::remove(path.c_str());
+	}
+
+	bool threw = false;
+	try {
+		qase_save_report(qase_reporter_get_results(), "qase_test_report_archive.xml", "xml");
+	} catch (const std::invalid_argument&) {
+		threw = true;
+	}
+	assert(threw && "unknown report formats must be rejected");
+
+	std::remove("qase_test_report_archive.json");
+	std::remove("qase_test_report_converted.json");
+}
+
+// steps are written nested in the shape of models/step.json
+void test_qase_save_report_writes_steps() {
+	qase_reporter_reset();
+	qase_reporter_begin_test();
+	{
+		QASE_STEP("Outer");
+		QASE_STEP("Inner");
+	}
+	qase_reporter_add_result("test_with_steps", true);
+
+	std::string path = "qase_test_report_steps.json";
+	qase_save_report(qase_reporter_get_results(), path);
+
+	nlohmann::json report;
+	std::ifstream(path) >> report;
+
+	const auto& steps = report["results"][0]["steps"];
+	assert(steps.size() == 1);
+	assert(steps[0]["data"]["action"] == "Outer");
+	assert(steps[0]["parent_id"].is_null());
+	assert(steps[0]["execution"]["status"] == "passed");
+
+	const auto& inner = steps[0]["steps"][0];
+	assert(inner["data"]["action"] == "Inner");
+	assert(inner["parent_id"] == steps[0]["id"]);
+	assert(inner["execution"]["end_time"] >= inner["execution"]["start_time"]);
+
+	std::remove(path.c_str());
+}
+
+// in report mode with the ndjson format every result is a line in the report as soon as
+// it's recorded, and nothing piles up in memory
+void test_ndjson_report_streams_results() {
+	const std::string path = "qase_test_report.ndjson";
+
+	QaseConfig cfg;
+	cfg.mode = "report";
+	cfg.connection_format = "ndjson";
+	cfg.report_connection_path = path;
+	cfg.report_flush_interval_ms = 0;
+
+	qase_reporter_reset();
+	qase_reporter_configure(cfg);
+
+	qase_reporter_add_result("test_boots", true);
+	QaseResultMeta meta;
+	meta.case_id = 7;
+	qase_reporter_add_result("test_reads_sensor", false, std::move(meta));
+	assert(qase_reporter_get_results().empty());
+
+	// both lines are there before the run is finished
+	std::vector<nlohmann::json> lines;
+	{
+		std::ifstream in(path);
+		std::string line;
+		while (std::getline(in, line)) {
+			lines.push_back(nlohmann::json::parse(line));
+		}
+	}
+	assert(lines.size() == 2);
+	assert(lines[0]["title"] == "test_boots" && lines[0]["status"] == "passed");
+	assert(lines[1]["id"] == "TC-7" && lines[1]["status"] == "failed");
+
+	qase_reporter_add_result("test_sleeps", true);
+	FakeHttpClient http;
+	qase_reporter_finish(http, cfg);
+	assert(http.called_url.empty());
+
+	// a line cut off by an interrupted run is dropped when converting
+	std::ofstream(path, std::ios::app) << R"({"title":"test_cut_off","sta)";
+	const std::string converted = "qase_test_report_from_ndjson.json";
+	qase_convert_report(path, converted);
+
+	nlohmann::json report;
+	std::ifstream(converted) >> report;
+	assert(report["results"].size() == 3);
+	assert(report["results"][2]["title"] == "test_sleeps");
+	validate_json_payload(report);
+
+	qase_reporter_configure(QaseConfig());
+	std::remove(path.c_str());
+	std::remove(converted.c_str());
+}
+
+// lines left in the buffer are written once the flush interval is up, even if no
+// other result comes, e.g. while the next test hangs
+void test_ndjson_report_flushes_on_a_timer() {
+	const std::string path = "qase_test_report_timer.ndjson";
+
+	QaseConfig cfg;
+	cfg.mode = "report";
+	cfg.connection_format = "ndjson";
+	cfg.report_connection_path = path;
+	cfg.report_flush_interval_ms = 20;
+
+	qase_reporter_reset();
+	qase_reporter_configure(cfg);
+	qase_reporter_add_result("test_boots", true);
+
+	auto line_count = [&path]() {
+		std::ifstream in(path);
+		std::string line;
+		std::size_t count = 0;
+		while (std::getline(in, line)) {
+			++count;
+		}
+		return count;
+	};
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (line_count() == 0 && std::chrono::steady_clock::now() < deadline) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	assert(line_count() == 1);
+
+	qase_reporter_configure(QaseConfig());
+	std::remove(path.c_str());
+}
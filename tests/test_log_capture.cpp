@@ -0,0 +1,134 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+QaseConfig make_capture_config(std::size_t max_bytes = 4096, bool failed_only = true) {
+	QaseConfig cfg;
+	cfg.capture_logs = true;
+	cfg.capture_logs_max_bytes = max_bytes;
+	cfg.capture_logs_failed_only = failed_only;
+	return cfg;
+}
+
+// stdout and stderr printed by a failing test end up in its result
+void test_capture_logs_attaches_output_of_failed_test() {
+	qase_reporter_reset();
+	qase_reporter_configure(make_capture_config());
+
+	qase_reporter_begin_test();
+	std::printf("hello from stdout\n");
+	std::fprintf(stderr, "hello from stderr\n");
+	qase_reporter_add_result("failing_test", false);
+
+	qase_reporter_configure(QaseConfig());
+
+	const auto& results = qase_reporter_get_results();
+	assert(results.size() == 1);
+	assert(results[0].logs.find("hello from stdout") != std::string::npos);
+	assert(results[0].logs.find("hello from stderr") != std::string::npos);
+}
+
+// by default passing tests keep no logs, so they cost no memory or payload
+void test_capture_logs_drops_output_of_passed_test() {
+	qase_reporter_reset();
+	qase_reporter_configure(make_capture_config());
+
+	qase_reporter_begin_test();
+	std::printf("this is not kept\n");
+	qase_reporter_add_result("passing_test", true);
+
+	qase_reporter_configure(make_capture_config(4096, false));
+
+	qase_reporter_begin_test();
+	std::printf("this is kept\n");
+	qase_reporter_add_result("passing_test_with_logs", true);
+
+	qase_reporter_configure(QaseConfig());
+
+	const auto& results = qase_reporter_get_results();
+	assert(results[0].logs.empty());
+	assert(results[1].logs.find("this is kept") != std::string::npos);
+}
+
+// only the tail of the output is kept, up to the configured cap
+void test_capture_logs_keeps_tail_within_cap() {
+	qase_reporter_reset();
+	qase_reporter_configure(make_capture_config(64));
+
+	qase_reporter_begin_test();
+	for (int i = 0; i < 1000; ++i) {
+		std::printf("line %d\n", i);
+	}
+	std::printf("LAST\n");
+	qase_reporter_add_result("noisy_test", false);
+
+	qase_reporter_configure(QaseConfig());
+
+	const std::string& logs = qase_reporter_get_results()[0].logs;
+	assert(logs.find("bytes truncated]") != std::string::npos);
+	assert(logs.find("line 0\n") == std::string::npos);
+	assert(logs.size() >= 5 && logs.compare(logs.size() - 5, 5, "LAST\n") == 0);
+	assert(logs.size() <= 64 + 32);
+}
+
+// the sink used on ESP feeds the same per-test buffer, and logs reach the payload
+void test_capture_logs_sink_and_serialization() {
+	qase_reporter_reset();
+	qase_reporter_configure(make_capture_config());
+
+	qase_reporter_begin_test();
+	const std::string line = "esp log line";
+	qase_log_capture_write(line.data(), line.size());
+	qase_reporter_add_result("sink_test", false);
+
+	// nothing is captured outside of a running test
+	qase_log_capture_write(line.data(), line.size());
+
+	qase_reporter_configure(QaseConfig());
+
+	auto parsed = nlohmann::json::parse(qase_serialize_results(qase_reporter_get_results()));
+	assert(parsed["results"][0]["comment"].get<std::string>().find("esp log line") != std::string::npos);
+}
+
+static std::size_t thread_count() {
+	std::size_t count = 0;
+	for (const auto& entry : std::filesystem::directory_iterator("/proc/self/task")) {
+		(void)entry;
+		++count;
+	}
+	return count;
+}
+
+// one drain thread serves every test of the run, and each test still gets only its own output
+void test_capture_logs_uses_one_drain_thread() {
+	qase_reporter_reset();
+	qase_reporter_configure(make_capture_config(4096, false));
+
+	std::vector<std::size_t> threads;
+	for (int i = 0; i < 5; ++i) {
+		qase_reporter_begin_test();
+		std::printf("output of test %d\n", i);
+		threads.push_back(thread_count());
+		qase_reporter_add_result("test_" + std::to_string(i), true);
+
+		// the drain thread outlives the test
+		assert(thread_count() == threads.back());
+	}
+	std::printf("between tests\n");
+	std::fflush(stdout);
+
+	qase_reporter_configure(QaseConfig());
+
+	for (std::size_t count : threads) {
+		assert(count == threads[0]);
+	}
+	const auto& results = qase_reporter_get_results();
+	for (int i = 0; i < 5; ++i) {
+		assert(results[i].logs == "output of test " + std::to_string(i) + "\n");
+	}
+}
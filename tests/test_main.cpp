@@ -5,6 +5,24 @@
 #include "test_submitter.cpp"
 #include "test_config.cpp"
 #include "test_wiring.cpp"
+#include "test_log_capture.cpp"
+#include "test_attachments.cpp"
+#include "test_serial.cpp"
+#include "test_steps.cpp"
+#include "test_rate_limit.cpp"
+#include "test_param_results.cpp"
+#include "test_crash_journal.cpp"
+#include "test_observers.cpp"
+#include "test_shared_run.cpp"
+#include "test_memory_profile.cpp"
+#include "test_registry.cpp"
+#include "test_parallel_runner.cpp"
+
+// the libcurl client is only built when libcurl is found
+#ifdef QASE_REPORTER_CURL_ENABLED
+#include "test_curl_http_client.cpp"
+#include "test_mock_server.cpp"
+#endif
 
 // schema validation logics and local reporting tests are only present when QASE_REPORTER_FULL_MODE_ENABLED=ON during build time
 #ifdef QASE_REPORTER_FULL_MODE_ENABLED
@@ -43,6 +61,7 @@ int main()
 	RUN_TEST(test_load_qase_config_throws_on_invalid_json);
 	RUN_TEST(test_load_qase_config_throws_on_missing_fields);
 	RUN_TEST(test_load_qase_config_throws_on_empty_fields);
+	RUN_TEST(test_load_qase_config_throws_on_invalid_recorder);
 	RUN_TEST(test_resolve_config_uses_file_if_nothing_else);
 	RUN_TEST(test_resolve_config_env_vars_override_file);
 	RUN_TEST(test_resolve_config_preset_overrides_env_and_file);
@@ -53,14 +72,100 @@ int main()
 	RUN_TEST(test_default_run_title_contains_date_and_time);
 	RUN_TEST(test_start_run_sets_description_if_present);
 	RUN_TEST(test_load_qase_config_parses_run_complete);
+	RUN_TEST(test_load_qase_config_parses_capture_logs_options);
+	RUN_TEST(test_load_qase_config_parses_delta_options);
+	RUN_TEST(test_load_qase_config_parses_batch_options);
+	RUN_TEST(test_load_qase_config_parses_report_options);
 	RUN_TEST(test_orchestrator_skips_complete_run_if_config_false);
+	RUN_TEST(test_orchestrator_submits_in_batches);
+	RUN_TEST(test_orchestrator_submits_only_changed_results);
+	RUN_TEST(test_orchestrator_resyncs_delta_periodically);
+	RUN_TEST(test_orchestrator_submits_batches_from_worker_pool);
+	RUN_TEST(test_orchestrator_rejects_null_clients);
+	RUN_TEST(test_orchestrator_aggregates_batch_failures);
+	RUN_TEST(test_start_run_sends_selected_cases_and_plan);
+	RUN_TEST(test_orchestrator_starts_run_with_result_cases);
+	RUN_TEST(test_orchestrator_resolves_case_ids_through_cache);
+	RUN_TEST(test_create_cases_posts_titles_in_bulk);
+	RUN_TEST(test_case_resolution_rejects_wrong_id_count);
+	RUN_TEST(test_recorder_spills_to_disk_over_budget);
+	RUN_TEST(test_recorder_flushes_upstream_over_budget);
+	RUN_TEST(test_recorder_upload_resends_only_failed_batches);
+	RUN_TEST(test_recorder_spill_follows_delta_state);
+	RUN_TEST(test_recorder_spill_is_visited_and_streamed);
 	RUN_TEST(test_qase_reporter_add_result_accepts_meta);
+	RUN_TEST(test_result_fields_keep_map_semantics);
+	RUN_TEST(test_result_fields_spill_past_inline_capacity);
+	RUN_TEST(test_result_fields_reusable_after_move);
+	RUN_TEST(test_add_result_moves_meta_without_copies);
+	RUN_TEST(test_add_result_without_meta_does_not_allocate);
+	RUN_TEST(test_capture_logs_attaches_output_of_failed_test);
+	RUN_TEST(test_capture_logs_drops_output_of_passed_test);
+	RUN_TEST(test_capture_logs_keeps_tail_within_cap);
+	RUN_TEST(test_capture_logs_sink_and_serialization);
+	RUN_TEST(test_capture_logs_uses_one_drain_thread);
+	RUN_TEST(test_upload_attachment_streams_file_in_chunks);
+	RUN_TEST(test_upload_attachment_falls_back_to_buffered_post);
+	RUN_TEST(test_upload_attachment_is_optional_for_apis);
+	RUN_TEST(test_orchestrator_uploads_attachments_before_submit);
+	RUN_TEST(test_hash_file_matches_in_memory_hash);
+	RUN_TEST(test_orchestrator_deduplicates_attachments_by_content);
+	RUN_TEST(test_serial_collector_submits_results_in_batches);
+	RUN_TEST(test_serial_decoder_restores_results);
+	RUN_TEST(test_serial_encoder_is_allocation_free_and_compact);
+	RUN_TEST(test_serial_encoder_keeps_strings_of_a_result_interned);
+	RUN_TEST(test_serial_decoder_resyncs_after_garbage);
+	RUN_TEST(test_steps_are_recorded_with_nesting);
+	RUN_TEST(test_steps_left_open_are_failed);
+	RUN_TEST(test_step_scope_fails_on_exception);
+	RUN_TEST(test_steps_reuse_buffer_between_tests);
+	RUN_TEST(test_steps_are_serialized_nested);
+	RUN_TEST(test_rate_limiter_paces_requests);
+	RUN_TEST(test_rate_limiter_paces_bytes);
+	RUN_TEST(test_rate_limiter_backs_off_when_throttled);
+	RUN_TEST(test_qase_api_resends_throttled_requests);
+	RUN_TEST(test_qase_api_resends_throttled_uploads);
+	RUN_TEST(test_param_results_share_definition_and_params);
+	RUN_TEST(test_param_results_macro_takes_braced_params);
+	RUN_TEST(test_param_results_are_serialized_with_params);
+	RUN_TEST(test_orchestrator_submits_param_results);
+	RUN_TEST(test_crash_handler_journals_running_test);
+	RUN_TEST(test_crash_handler_journals_spilled_results);
+	RUN_TEST(test_crash_recover_submits_journal);
+	RUN_TEST(test_observers_receive_results_in_order);
+	RUN_TEST(test_slow_observer_drops_instead_of_blocking);
+	RUN_TEST(test_unsubscribe_waits_for_delivery_in_progress);
+	RUN_TEST(test_observers_deliver_without_waiting_for_the_backstop);
+	RUN_TEST(test_observers_start_and_subscribe_race);
+	RUN_TEST(test_shards_share_one_run);
+	RUN_TEST(test_shared_run_ignores_dead_shards);
+	RUN_TEST(test_memory_profile_counts_test_allocations);
+	RUN_TEST(test_registry_runs_failures_first);
+	RUN_TEST(test_parallel_runner_isolates_crashes);
+	RUN_TEST(test_parallel_runner_steals_work);
+	RUN_TEST(test_parallel_runner_fails_throwing_tests);
+
+#ifdef QASE_REPORTER_CURL_ENABLED
+	RUN_TEST(test_curl_client_posts_and_reads_response);
+	RUN_TEST(test_curl_client_reuses_connections);
+	RUN_TEST(test_curl_client_streams_body);
+	RUN_TEST(test_curl_client_times_out);
+	RUN_TEST(test_reporter_finish_against_mock_server);
+	RUN_TEST(test_reporter_finish_survives_mock_throttling);
+#endif
 
 	// schema validation logics is only present when QASE_REPORTER_FULL_MODE_ENABLED=ON during build time
 #ifdef QASE_REPORTER_FULL_MODE_ENABLED
 	RUN_TEST(test_valid_json_passes_schema);
 	RUN_TEST(test_invalid_json_fails_schema);
+	RUN_TEST(test_schema_validation_needs_no_schema_files);
 	RUN_TEST(test_qase_save_report_writes_valid_schema_json);
+	RUN_TEST(test_qase_save_report_deduplicates_attachments);
+	RUN_TEST(test_qase_save_report_binary_formats_round_trip);
+	RUN_TEST(test_qase_save_report_writes_steps);
+	RUN_TEST(test_ndjson_report_streams_results);
+	RUN_TEST(test_ndjson_report_flushes_on_a_timer);
+	RUN_TEST(test_recorder_spills_into_local_report);
 #else
 	RUN_TEST(test_adapter_submits_via_minimal_flow);
 #endif
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <cassert>
+#include <memory>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// allocations of a test started with qase_reporter_begin_test end up in its result
+// and in the payload as number fields
+void test_memory_profile_counts_test_allocations() {
+	qase_reporter_reset();
+	QaseConfig cfg;
+	cfg.profile_memory = true;
+	qase_reporter_configure(cfg);
+	assert(qase_alloc_hooks_registered());
+
+	qase_reporter_begin_test("test_allocates");
+	{
+		std::vector<std::unique_ptr<int[]>> blocks;
+		blocks.reserve(10);
+		for (int i = 0; i < 10; ++i) {
+			blocks.emplace_back(new int[1000]);
+		}
+	}
+	qase_reporter_add_result("test_allocates", true);
+
+	qase_reporter_begin_test("test_does_nothing");
+	qase_reporter_add_result("test_does_nothing", true);
+
+	// not started with qase_reporter_begin_test, so not profiled
+	qase_reporter_add_result("test_unprofiled", true);
+
+	const auto& results = qase_reporter_get_results();
+	assert(results[0].memory.recorded);
+	assert(results[0].memory.allocations == 11);
+	assert(results[0].memory.bytes >= 10 * 1000 * static_cast<int64_t>(sizeof(int)));
+	assert(results[0].memory.peak_rss_delta_kb >= 0);
+	assert(results[1].memory.recorded);
+	assert(results[1].memory.allocations == 0);
+	assert(results[1].memory.bytes == 0);
+	assert(!results[2].memory.recorded);
+
+	auto payload = nlohmann::json::parse(qase_serialize_results(results));
+	assert(payload["results"][0]["case"]["memory_allocations"] == 11);
+	assert(payload["results"][0]["case"]["memory_bytes"].is_number_integer());
+	assert(payload["results"][0]["case"]["memory_peak_rss_delta_kb"].is_number_integer());
+	assert(!payload["results"][2]["case"].contains("memory_allocations"));
+
+	qase_reporter_configure(QaseConfig{});
+	qase_reporter_reset();
+}
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <cassert>
+#include "qase_curl_http_client.h"
+#include "qase_mock_server.h"
+
+using namespace qase;
+
+static void record_synthetic_suite(std::size_t count) {
+	qase_reporter_reset();
+	qase_reporter_reserve(count);
+	for (std::size_t i = 0; i < count; ++i) {
+		qase_reporter_add_result("test_" + std::to_string(i), i % 10 != 0);
+	}
+}
+
+// the whole flow, over the real transport, against the mock Qase API
+void test_reporter_finish_against_mock_server() {
+	QaseMockServer server;
+	record_synthetic_suite(1000);
+
+	QaseConfig cfg = make_test_config();
+	cfg.host = server.host();
+	cfg.batch_size = 100;
+
+	QaseCurlHttpClient http;
+	qase_reporter_finish(http, cfg);
+
+	assert(server.runs_started() == 1);
+	assert(server.bulk_requests() == 10);
+	assert(server.results_received() == 1000);
+	assert(server.runs_completed() == 1);
+	assert(server.connections() == 1);
+
+	qase_reporter_reset();
+}
+
+// throttled batches are resent, so every result still arrives once
+void test_reporter_finish_survives_mock_throttling() {
+	QaseMockServerOptions options;
+	options.throttle_rate = 0.3;
+	options.seed = 7;
+	QaseMockServer server(options);
+	record_synthetic_suite(500);
+
+	QaseConfig cfg = make_test_config();
+	cfg.host = server.host();
+	cfg.batch_size = 50;
+
+	QaseCurlHttpClient http;
+	qase_reporter_finish(http, cfg);
+
+	assert(server.requests_throttled() > 0);
+	assert(server.results_received() == 500);
+	assert(server.runs_completed() == 1);
+
+	qase_reporter_reset();
+}
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <cassert>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// every observer gets the results in recording order, the fd observer as JSON lines
+void test_observers_receive_results_in_order() {
+	qase_reporter_reset();
+	const QaseObserverStats before = qase_observer_stats();
+
+	std::mutex mutex;
+	std::vector<std::string> seen;
+	const int id = qase_observer_subscribe([&](const TestResult& result) {
+		std::lock_guard<std::mutex> lock(mutex);
+		seen.push_back(result.name + (result.passed ? ":passed" : ":failed"));
+	});
+	const int failing = qase_observer_subscribe([](const TestResult&) {
+		throw std::runtime_error("observer failed");
+	});
+
+	int pipe_fds[2];
+	assert(pipe(pipe_fds) == 0);
+	const int fd_id = qase_observer_subscribe(qase_fd_observer(pipe_fds[1]));
+
+	qase_reporter_add_result("test_boots", true);
+	QaseResultMeta meta;
+	meta.title = "Reads the sensor";
+	qase_reporter_add_result("test_reads_sensor", false, std::move(meta));
+	qase_observers_flush();
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		assert((seen == std::vector<std::string>{"test_boots:passed", "test_reads_sensor:failed"}));
+	}
+
+	char buf[512];
+	ssize_t n = read(pipe_fds[0], buf, sizeof(buf));
+	assert(n > 0);
+	const std::string lines(buf, static_cast<std::size_t>(n));
+	const std::size_t newline = lines.find('\n');
+	assert(newline != std::string::npos);
+	auto first = nlohmann::json::parse(lines.substr(0, newline));
+	auto second = nlohmann::json::parse(lines.substr(newline + 1, lines.find('\n', newline + 1) - newline - 1));
+	assert(first["case"]["title"] == "test_boots");
+	assert(second["case"]["title"] == "Reads the sensor");
+	assert(second["status"] == "failed");
+
+	const QaseObserverStats after = qase_observer_stats();
+	assert(after.published - before.published == 2);
+	assert(after.delivered - before.delivered == 2);
+	assert(after.failed - before.failed == 2);
+	assert(after.dropped == before.dropped);
+
+	qase_observer_unsubscribe(id);
+	qase_observer_unsubscribe(failing);
+	qase_observer_unsubscribe(fd_id);
+	qase_observers_stop();
+	close(pipe_fds[0]);
+	close(pipe_fds[1]);
+	qase_reporter_reset();
+}
+
+// a stuck observer doesn't hold up recording: results past the queue capacity are
+// dropped for the observers and counted, the recorder keeps all of them
+void test_slow_observer_drops_instead_of_blocking() {
+	qase_reporter_reset();
+	qase_observers_start(8);
+	const QaseObserverStats before = qase_observer_stats();
+
+	std::atomic<bool> release{false};
+	const int id = qase_observer_subscribe([&](const TestResult&) {
+		while (!release.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 100; ++i) {
+		qase_reporter_add_result("test_" + std::to_string(i), true);
+	}
+	assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(1));
+	assert(qase_reporter_get_results().size() == 100);
+
+	const QaseObserverStats stalled = qase_observer_stats();
+	const uint64_t published = stalled.published - before.published;
+	const uint64_t dropped = stalled.dropped - before.dropped;
+	assert(published == 8);
+	assert(dropped == 92);
+
+	release = true;
+	qase_observers_flush();
+	const QaseObserverStats after = qase_observer_stats();
+	assert(after.delivered - before.delivered == published);
+
+	qase_observer_unsubscribe(id);
+	qase_observers_stop();
+	qase_reporter_reset();
+}
+
+// unsubscribe returns only once the observer is out of the delivery in progress,
+// and an observer can unsubscribe itself without waiting on its own delivery
+void test_unsubscribe_waits_for_delivery_in_progress() {
+	qase_reporter_reset();
+
+	std::atomic<bool> entered{false};
+	std::atomic<bool> release{false};
+	std::atomic<int> calls{0};
+	const int id = qase_observer_subscribe([&](const TestResult&) {
+		++calls;
+		entered = true;
+		while (!release.load()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+	});
+
+	qase_reporter_add_result("test_held", true);
+	while (!entered.load()) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	std::atomic<bool> returned{false};
+	std::thread unsubscriber([&] {
+		qase_observer_unsubscribe(id);
+		returned = true;
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	assert(!returned.load());
+
+	release = true;
+	unsubscriber.join();
+	qase_reporter_add_result("test_after", true);
+	qase_observers_flush();
+	assert(calls.load() == 1);
+
+	std::atomic<int> self_calls{0};
+	std::atomic<int> self_id{0};
+	self_id = qase_observer_subscribe([&](const TestResult&) {
+		++self_calls;
+		qase_observer_unsubscribe(self_id.load());
+	});
+	qase_reporter_add_result("test_first", true);
+	qase_reporter_add_result("test_second", true);
+	qase_observers_flush();
+	assert(self_calls.load() == 1);
+
+	qase_observers_stop();
+	qase_reporter_reset();
+}
+
+// a result published while the consumer is going to sleep still wakes it: each one is
+// delivered well within the consumer's 100 ms backstop, without a flush
+void test_observers_deliver_without_waiting_for_the_backstop() {
+	qase_reporter_reset();
+	std::atomic<int> seen{0};
+	const int id = qase_observer_subscribe([&seen](const TestResult&) { ++seen; });
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 200; ++i) {
+		qase_reporter_add_result("test_" + std::to_string(i), true);
+		while (seen.load() <= i) {
+			std::this_thread::yield();
+		}
+	}
+	assert(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+
+	qase_observer_unsubscribe(id);
+	qase_observers_stop();
+	qase_reporter_reset();
+}
+
+// starting the consumer explicitly and by a first subscription can race without
+// ending up with two consumer threads
+void test_observers_start_and_subscribe_race() {
+	for (int i = 0; i < 50; ++i) {
+		qase_observers_stop();
+		std::atomic<int> id{0};
+		std::thread subscriber([&id] { id = qase_observer_subscribe([](const TestResult&) {}); });
+		qase_observers_start(8);
+		subscriber.join();
+		qase_observer_unsubscribe(id.load());
+	}
+	qase_observers_stop();
+}
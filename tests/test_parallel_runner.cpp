@@ -0,0 +1,91 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <csignal>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// runs the tests registered in test_registry.cpp in worker processes: registry_test_a is slow,
+// registry_test_b crashes and registry_test_c fails; every test records its pid as a step
+static QaseTestRunSummary run_parallel(int workers) {
+	qase_reporter_reset();
+	QaseTestRunOptions options;
+	options.workers = workers;
+	return qase_run_registered_tests([](const QaseRegisteredTest& test) {
+		QASE_STEP("pid " + std::to_string(getpid()));
+		if (test.name == "registry_test_a") {
+			std::this_thread::sleep_for(std::chrono::milliseconds(300));
+		} else if (test.name == "registry_test_b") {
+			raise(SIGSEGV);
+		}
+		return test.name != "registry_test_c";
+	}, options);
+}
+
+static std::string result_pid(const TestResult& result) {
+	assert(result.steps.size() == 1);
+	return result.steps[0].name;
+}
+
+// the crash only fails the test that crashed, the results come back in registration order
+void test_parallel_runner_isolates_crashes() {
+	const QaseTestRunSummary summary = run_parallel(2);
+	assert(summary.run == 4);
+	assert(summary.failed == 2);
+
+	const auto& results = qase_reporter_get_results();
+	assert(results.size() == 4);
+	assert(results[0].name == "registry_test_a" && results[0].passed);
+	assert(results[1].name == "registry_test_b" && !results[1].passed);
+	assert(results[1].logs == "Crashed with SIGSEGV");
+	assert(results[1].steps.empty());
+	assert(results[2].name == "registry_test_c" && !results[2].passed);
+	assert(results[2].meta.case_id == 7);
+	assert(results[3].name == "registry_test_d" && results[3].passed);
+
+	const std::string parent = "pid " + std::to_string(getpid());
+	for (std::size_t i : {0, 2, 3}) {
+		assert(result_pid(results[i]) != parent);
+	}
+	qase_reporter_reset();
+}
+
+// a and c are dealt to the first worker, b and d to the second; while a sleeps, the
+// worker that replaced the crashed one runs d and steals c
+void test_parallel_runner_steals_work() {
+	run_parallel(2);
+	const auto& results = qase_reporter_get_results();
+	assert(results.size() == 4);
+	assert(result_pid(results[2]) == result_pid(results[3]));
+	assert(result_pid(results[0]) != result_pid(results[2]));
+	qase_reporter_reset();
+}
+
+// a test that throws fails with the exception as its log, the other tests still run
+void test_parallel_runner_fails_throwing_tests() {
+	qase_reporter_reset();
+	QaseTestRunOptions options;
+	options.workers = 2;
+	const QaseTestRunSummary summary = qase_run_registered_tests([](const QaseRegisteredTest& test) {
+		if (test.name == "registry_test_b") {
+			throw std::runtime_error("sensor timed out");
+		}
+		return test.name != "registry_test_c";
+	}, options);
+	assert(summary.run == 4);
+	assert(summary.failed == 2);
+
+	const auto& results = qase_reporter_get_results();
+	assert(results.size() == 4);
+	assert(results[0].name == "registry_test_a" && results[0].passed);
+	assert(results[1].name == "registry_test_b" && !results[1].passed);
+	assert(results[1].logs == "Threw an exception: sensor timed out");
+	assert(results[2].name == "registry_test_c" && !results[2].passed);
+	assert(results[3].name == "registry_test_d" && results[3].passed);
+	qase_reporter_reset();
+}
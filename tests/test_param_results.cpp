@@ -0,0 +1,160 @@
+#include <iostream>
+#include <cassert>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// iterations share their test and intern their parameter sets
+void test_param_results_share_definition_and_params() {
+	qase_reporter_reset();
+
+	QaseResultMeta meta;
+	meta.title = "UART echoes bytes";
+	meta.fields["priority"] = "high";
+	const uint32_t echo = qase_reporter_define_test("test_uart_echo", std::move(meta));
+
+	const char* bauds[] = {"9600", "115200", "921600"};
+	for (int round = 0; round < 100; ++round) {
+		for (const char* baud : bauds) {
+			qase_reporter_add_param_result(echo, true, {{"baud", baud}, {"parity", "none"}});
+		}
+	}
+
+	const auto& results = qase_reporter_get_param_results();
+	assert(results.tests().size() == 1);
+	assert(results.size() == 300);
+	assert(results.param_sets() == 3);
+	assert(results.iterations()[3].params == results.iterations()[0].params);
+	assert(results.iterations()[1].params != results.iterations()[0].params);
+
+	std::vector<std::string> params;
+	results.for_each_param(results.iterations()[1].params, [&params](std::string_view key, std::string_view value) {
+		params.push_back(std::string(key) + "=" + std::string(value));
+	});
+	assert((params == std::vector<std::string>{"baud=115200", "parity=none"}));
+
+	bool threw = false;
+	try {
+		qase_reporter_add_param_result(echo + 1, true, {});
+	} catch (const std::out_of_range&) {
+		threw = true;
+	}
+	assert(threw && "iterations of undefined tests must be rejected");
+
+	qase_reporter_reset();
+	assert(qase_reporter_get_param_results().empty());
+	assert(qase_reporter_get_param_results().param_sets() == 0);
+}
+
+// just enough of Unity for the QASE_RUN_PARAM_TEST expansion
+static struct {
+	unsigned TestFailures = 0;
+	unsigned CurrentTestFailed = 0;
+} Unity;
+
+static const char* current_baud = "";
+static std::vector<std::string> echoed_bauds;
+
+static void test_uart_echo() {
+	echoed_bauds.push_back(current_baud);
+}
+
+#define RUN_TEST(test_func) test_func()
+
+// the macro takes a braced parameter list, commas and all
+void test_param_results_macro_takes_braced_params() {
+	qase_reporter_reset();
+	echoed_bauds.clear();
+
+	const uint32_t echo = qase_reporter_define_test("test_uart_echo");
+	for (const char* baud : {"9600", "115200"}) {
+		current_baud = baud;
+		QASE_RUN_PARAM_TEST(echo, test_uart_echo, {{"baud", baud}, {"parity", "none"}});
+	}
+	current_baud = "9600";
+	const QaseFields odd_parity = {{"baud", "9600"}, {"parity", "odd"}};
+	QASE_RUN_PARAM_TEST(echo, test_uart_echo, odd_parity);
+
+	const auto& results = qase_reporter_get_param_results();
+	assert((echoed_bauds == std::vector<std::string>{"9600", "115200", "9600"}));
+	assert(results.size() == 3);
+	assert(results.param_sets() == 3);
+	assert(results.iterations()[2].passed);
+
+	std::vector<std::string> params;
+	results.for_each_param(results.iterations()[1].params, [&params](std::string_view key, std::string_view value) {
+		params.push_back(std::string(key) + "=" + std::string(value));
+	});
+	assert((params == std::vector<std::string>{"baud=115200", "parity=none"}));
+
+	qase_reporter_reset();
+}
+
+#undef RUN_TEST
+
+// iterations become results with a param object, the case is described once per payload
+void test_param_results_are_serialized_with_params() {
+	QaseParamResults results;
+
+	QaseResultMeta meta;
+	meta.fields["layer"] = "hil";
+	const uint32_t echo = results.define_test("test_uart_echo", std::move(meta));
+	QaseResultMeta known;
+	known.case_id = 44;
+	const uint32_t flash = results.define_test("test_flash_write", std::move(known));
+
+	results.add(echo, true, {{"baud", "9600"}});
+	results.add(echo, false, {{"baud", "115200"}});
+	results.add(flash, true, {{"size", "4k"}});
+	results.add(flash, true, {{"size", "64k"}});
+	results.set_logs(1, "framing error");
+
+	auto payload = nlohmann::json::parse(qase_serialize_param_results(results));
+	const auto& entries = payload["results"];
+
+	assert(entries.size() == 4);
+	assert(entries[0]["case"]["title"] == "test_uart_echo");
+	assert(entries[0]["case"]["layer"] == "hil");
+	assert(entries[0]["param"]["baud"] == "9600");
+
+	// later iterations of the same test carry only what identifies the case
+	assert(entries[1]["case"]["title"] == "test_uart_echo");
+	assert(!entries[1]["case"].contains("layer"));
+	assert(entries[1]["status"] == "failed");
+	assert(entries[1]["comment"] == "framing error");
+	assert(entries[1]["param"]["baud"] == "115200");
+
+	assert(entries[2]["case"]["case_id"] == 44);
+	assert(entries[2]["case"]["title"] == "test_flash_write");
+	assert((entries[3]["case"] == nlohmann::json{{"case_id", 44}}));
+	assert(entries[3]["param"]["size"] == "64k");
+}
+
+// iterations are submitted along with plain results, and their cases join the run
+void test_orchestrator_submits_param_results() {
+	FakeQaseApi api;
+	FakeHttpClient http;
+
+	qase_reporter_reset();
+	qase_reporter_add_result("test_plain", true);
+
+	QaseResultMeta meta;
+	meta.case_id = 8;
+	const uint32_t echo = qase_reporter_define_test("test_uart_echo", std::move(meta));
+	for (const char* baud : {"9600", "19200", "38400"}) {
+		qase_reporter_add_param_result(echo, true, {{"baud", baud}});
+	}
+
+	QaseConfig cfg = make_test_config();
+	cfg.batch_size = 2;
+	qase_submit_report(api, http, cfg);
+
+	assert((api.calls == std::vector<std::string>{"start", "submit", "submit", "submit", "complete"}));
+	assert((api.start_case_ids == std::vector<int>{8}));
+
+	auto last = nlohmann::json::parse(api.submit_payload);
+	assert(last["results"].size() == 1);
+	assert(last["results"][0]["param"]["baud"] == "38400");
+
+	qase_reporter_reset();
+}
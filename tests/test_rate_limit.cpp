@@ -0,0 +1,150 @@
+#include <iostream>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// answers with the queued responses first, then with a plain success
+struct ThrottlingHttpClient : public HttpClient {
+	std::vector<HttpResponse> queued;
+	int requests = 0;
+	std::vector<std::string> streamed_bodies;
+
+	std::string post(const std::string&, const std::string&, const std::vector<std::string>&) override {
+		return next().body;
+	}
+
+	HttpResponse post_with_response(const std::string&, const std::string&, const std::vector<std::string>&) override {
+		return next();
+	}
+
+	HttpResponse post_stream_with_response(const std::string&, HttpBodySource& body, const std::vector<std::string>&) override {
+		std::string sent;
+		char chunk[64];
+		while (std::size_t n = body.read(chunk, sizeof(chunk))) {
+			sent.append(chunk, n);
+		}
+		streamed_bodies.push_back(sent);
+		return next();
+	}
+
+	HttpResponse next() {
+		++requests;
+		if (!queued.empty()) {
+			HttpResponse response = queued.front();
+			queued.erase(queued.begin());
+			return response;
+		}
+		HttpResponse response;
+		response.body = R"({"status": true, "result": [{"hash": "abc"}]})";
+		return response;
+	}
+};
+
+static HttpResponse throttled_response(const std::string& retry_after) {
+	HttpResponse response;
+	response.status = 429;
+	response.body = "Too Many Requests";
+	response.headers = {"Content-Type: text/plain", "retry-after: " + retry_after};
+	return response;
+}
+
+// one second of requests goes out at once, the rest is spaced by the rate
+void test_rate_limiter_paces_requests() {
+	using namespace std::chrono;
+	QaseRateLimiter limiter;
+	limiter.set_limits(10, 0);
+
+	const auto now = QaseRateLimiter::clock::now();
+	for (int i = 0; i < 11; ++i) {
+		assert(limiter.reserve(100, now) == now);
+	}
+	assert(limiter.reserve(100, now) - now == duration_cast<QaseRateLimiter::clock::duration>(milliseconds(100)));
+	assert(limiter.reserve(100, now) - now == duration_cast<QaseRateLimiter::clock::duration>(milliseconds(200)));
+
+	// new limits start over
+	limiter.set_limits(0, 0);
+	assert(limiter.reserve(100, now) == now);
+}
+
+// a large body goes out, then the following ones wait until its bytes are paid for
+void test_rate_limiter_paces_bytes() {
+	using namespace std::chrono;
+	QaseRateLimiter limiter;
+	limiter.set_limits(0, 1000);
+
+	const auto now = QaseRateLimiter::clock::now();
+	assert(limiter.reserve(3000, now) == now);
+	assert(limiter.reserve(1, now) - now == duration_cast<QaseRateLimiter::clock::duration>(seconds(2)));
+}
+
+// throttling pauses everything and halves the request rate until requests succeed again
+void test_rate_limiter_backs_off_when_throttled() {
+	using namespace std::chrono;
+	QaseRateLimiter limiter;
+	limiter.set_limits(1, 0);
+
+	const auto now = QaseRateLimiter::clock::now();
+	limiter.reserve(0, now);
+	limiter.reserve(0, now);
+
+	limiter.throttled(now + seconds(5));
+	const auto after_pause = limiter.reserve(0, now);
+	assert(after_pause == now + seconds(5));
+
+	// once the burst is spent, the halved rate spaces requests by two seconds
+	const auto first = limiter.reserve(0, now);
+	assert(first > after_pause);
+	assert(limiter.reserve(0, now) - first == duration_cast<QaseRateLimiter::clock::duration>(seconds(2)));
+
+	for (int i = 0; i < 16; ++i) {
+		limiter.succeeded();
+	}
+	const auto recovered = limiter.reserve(0, now);
+	assert(limiter.reserve(0, now) - recovered == duration_cast<QaseRateLimiter::clock::duration>(seconds(1)));
+}
+
+// a 429 is resent after its Retry-After instead of failing the submission
+void test_qase_api_resends_throttled_requests() {
+	ThrottlingHttpClient http;
+	http.queued = {throttled_response("0"), throttled_response("0")};
+
+	QaseApi api;
+	QaseConfig cfg = make_test_config();
+
+	assert(api.qase_submit_results(http, cfg, 7, R"({"results": []})"));
+	assert(http.requests == 3);
+
+	// and given up after cfg.rate_limit_max_retries resends
+	http.requests = 0;
+	http.queued = {throttled_response("0"), throttled_response("0"), throttled_response("0")};
+	cfg.rate_limit_max_retries = 2;
+
+	bool threw = false;
+	try {
+		api.qase_complete_run(http, cfg, 7);
+	} catch (const std::runtime_error& e) {
+		threw = std::string(e.what()).find("rate limited") != std::string::npos;
+	}
+	assert(threw);
+	assert(http.requests == 3);
+}
+
+// a throttled attachment upload is streamed again from the start
+void test_qase_api_resends_throttled_uploads() {
+	const std::string path = "throttled_upload.txt";
+	std::ofstream(path) << "sensor log";
+
+	ThrottlingHttpClient http;
+	http.queued = {throttled_response("0")};
+
+	QaseApi api;
+	assert(api.qase_upload_attachment(http, make_test_config(), path) == "abc");
+	assert(http.streamed_bodies.size() == 2);
+	assert(http.streamed_bodies[0] == http.streamed_bodies[1]);
+	assert(http.streamed_bodies[1].find("sensor log") != std::string::npos);
+
+	std::remove(path.c_str());
+}
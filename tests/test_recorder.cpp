@@ -5,6 +5,12 @@
 
 using namespace qase;
 
+// heap allocations of the test thread so far, counted by the allocation hooks
+// (src/qase_alloc_hooks.cpp) the test binary is linked with
+static std::size_t test_allocations() {
+	return qase_alloc_counters().allocations;
+}
+
 // qase reporter should be able to accept test execution result and store it
 void test_results_accepted_stored()
 {
@@ -125,3 +131,127 @@ void test_qase_reporter_add_result_accepts_meta() {
 	assert(results[0].meta.fields.at("priority") == "high");
 	assert(results[0].meta.fields.at("layer") == "unit");
 }
+
+// custom fields are kept sorted by key, like the std::map they replaced,
+// and existing map-style usage keeps working
+void test_result_fields_keep_map_semantics() {
+	QaseFields fields;
+	fields["priority"] = "high";
+	fields["layer"] = "unit";
+	fields["severity"] = "critical";
+	fields["priority"] = "low"; // overwrite, not duplicate
+
+	assert(fields.size() == 3);
+	assert(fields.at("priority") == "low");
+	assert(fields.count("layer") == 1);
+	assert(fields.count("missing") == 0);
+
+	std::vector<std::string> keys;
+	for (const auto& [key, value] : fields) {
+		keys.push_back(key);
+	}
+	assert((keys == std::vector<std::string>{"layer", "priority", "severity"}));
+
+	bool threw = false;
+	try {
+		fields.at("missing");
+	} catch (const std::out_of_range&) {
+		threw = true;
+	}
+	assert(threw && "Expected at() to throw for a missing field");
+
+	assert(fields.erase("layer") == 1);
+	assert(fields.size() == 2);
+	assert(fields.begin()->first == "priority");
+}
+
+// results with more fields than fit inline still keep every field, in order,
+// and copies stay independent of the original
+void test_result_fields_spill_past_inline_capacity() {
+	QaseFields fields = { {"b", "2"}, {"a", "1"} };
+
+	for (int i = 0; i < 20; ++i) {
+		fields["k" + std::to_string(100 + i)] = std::to_string(i);
+	}
+	assert(fields.size() == 22);
+	assert(fields.at("a") == "1");
+	assert(fields.at("k119") == "19");
+
+	std::string previous;
+	for (const auto& kv : fields) {
+		assert(previous < kv.first);
+		previous = kv.first;
+	}
+
+	QaseFields copy = fields;
+	copy["a"] = "changed";
+	assert(fields.at("a") == "1");
+	assert(copy != fields);
+
+	copy.clear();
+	assert(copy.empty());
+	assert(copy.begin() == copy.end());
+}
+
+// a moved-from set is empty and can be filled again, whether it had spilled or not
+void test_result_fields_reusable_after_move() {
+	for (int count : {3, 10}) {
+		QaseFields fields;
+		for (int i = 0; i < count; ++i) {
+			fields["k" + std::to_string(i)] = std::to_string(i);
+		}
+
+		QaseFields moved = std::move(fields);
+		assert(moved.size() == static_cast<std::size_t>(count));
+		assert(fields.empty());
+		assert(fields.begin() == fields.end());
+
+		fields["reused"] = "yes";
+		assert(fields.size() == 1);
+		assert(fields.begin()->first == "reused");
+
+		QaseFields assigned;
+		assigned["old"] = "value";
+		assigned = std::move(moved);
+		assert(assigned.size() == static_cast<std::size_t>(count));
+		assert(assigned.at("k0") == "0");
+		assert(moved.empty());
+		moved["again"] = "1";
+		assert(moved.at("again") == "1");
+	}
+}
+
+// an rvalue meta is moved into the recorder: recording costs exactly one allocation
+// (the name copy), title and fields are never copied
+void test_add_result_moves_meta_without_copies() {
+	qase_reporter_reset();
+	qase_reporter_reserve(4);
+
+	QaseResultMeta meta;
+	meta.case_id = 7;
+	meta.title = "a title that is too long for the small string buffer";
+	meta.fields["component"] = "a field value that is too long for the small string buffer";
+
+	const std::size_t before = test_allocations();
+	qase_reporter_add_result("a_test_name_that_does_not_fit_inline", true, std::move(meta));
+	assert(test_allocations() - before == 1);
+
+	const auto& results = qase_reporter_get_results();
+	assert(results.size() == 1);
+	assert(results[0].meta.case_id == 7);
+	assert(results[0].meta.title == "a title that is too long for the small string buffer");
+	assert(results[0].meta.fields.at("component") == "a field value that is too long for the small string buffer");
+}
+
+// results without meta and with short names are recorded without touching the heap
+void test_add_result_without_meta_does_not_allocate() {
+	qase_reporter_reset();
+	qase_reporter_reserve(4);
+
+	const std::size_t before = test_allocations();
+	qase_reporter_add_result("short_name", false);
+	assert(test_allocations() - before == 0);
+
+	assert(qase_reporter_get_results()[0].name == "short_name");
+	assert(qase_reporter_get_results()[0].passed == false);
+}
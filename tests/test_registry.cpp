@@ -0,0 +1,110 @@
+#include <iostream>
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+static void registry_test_a() {}
+static void registry_test_b() {}
+static void registry_test_c() {}
+static void registry_test_d() {}
+
+QASE_TEST(registry_test_a);
+QASE_TEST(registry_test_b);
+static const QaseResultMeta registry_test_c_meta = [] {
+	QaseResultMeta meta;
+	meta.case_id = 7;
+	meta.title = "Registry test C";
+	return meta;
+}();
+QASE_TEST(registry_test_c, registry_test_c_meta);
+QASE_TEST(registry_test_d);
+
+// rewrites the durations the history file keeps for the named tests, the rest stays as it is;
+// the lines are "<consecutive failures> <duration in us> <name>"
+static void set_history_durations(const std::string& path, const std::map<std::string, long long>& durations_us) {
+	std::vector<std::string> lines;
+	{
+		std::ifstream in(path);
+		unsigned failures;
+		long long duration_us;
+		std::string name;
+		while (in >> failures >> duration_us >> name) {
+			auto known = durations_us.find(name);
+			lines.push_back(std::to_string(failures) + " " +
+				std::to_string(known != durations_us.end() ? known->second : duration_us) + " " + name);
+		}
+	}
+	std::ofstream out(path, std::ios::trunc);
+	for (const auto& line : lines) {
+		out << line << '\n';
+	}
+}
+
+// registry_test_a took the longest last time, registry_test_d the next longest
+static void seed_registry_durations(const std::string& path) {
+	set_history_durations(path, {{"registry_test_a", 60000}, {"registry_test_b", 5}, {"registry_test_c", 5}, {"registry_test_d", 15000}});
+}
+
+// runs the registered tests once, failing the named ones
+// returns the order they ran in
+static std::vector<std::string> run_registry(const QaseTestRunOptions& options, const std::set<std::string>& failing) {
+	std::vector<std::string> order;
+	qase_reporter_reset();
+	const QaseTestRunSummary summary = qase_run_registered_tests([&](const QaseRegisteredTest& test) {
+		order.push_back(test.name);
+		return failing.count(test.name) == 0;
+	}, options);
+
+	const auto& results = qase_reporter_get_results();
+	assert(results.size() == order.size());
+	int recorded_failures = 0;
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		assert(results[i].name == order[i]);
+		assert(results[i].meta.case_id == (order[i] == "registry_test_c" ? 7 : 0));
+		recorded_failures += results[i].passed ? 0 : 1;
+	}
+	assert(summary.run == static_cast<int>(order.size()));
+	assert(summary.failed == recorded_failures);
+	qase_reporter_reset();
+	return order;
+}
+
+// without history the tests run in registration order; with it the last failures
+// go first, then the passing tests, quickest first
+void test_registry_runs_failures_first() {
+	const std::vector<std::string> registered = {"registry_test_a", "registry_test_b", "registry_test_c", "registry_test_d"};
+	assert(qase_registered_tests().size() == registered.size());
+
+	QaseTestRunOptions options;
+	options.history_path = "/tmp/qase_registry_history_" + std::to_string(getpid());
+	std::remove(options.history_path.c_str());
+
+	assert(run_registry(options, {"registry_test_c"}) == registered);
+
+	seed_registry_durations(options.history_path);
+	assert((run_registry(options, {"registry_test_b", "registry_test_c"}) ==
+		std::vector<std::string>{"registry_test_c", "registry_test_b", "registry_test_d", "registry_test_a"}));
+
+	// c failed twice in a row, b once: the longer streak first, and the run stops at it
+	options.max_failures = 1;
+	assert((run_registry(options, {"registry_test_c"}) == std::vector<std::string>{"registry_test_c"}));
+
+	// the tests that didn't run keep their history
+	options.max_failures = 0;
+	seed_registry_durations(options.history_path);
+	assert((run_registry(options, {}) ==
+		std::vector<std::string>{"registry_test_c", "registry_test_b", "registry_test_d", "registry_test_a"}));
+
+	// everything passed: the slow test goes last
+	seed_registry_durations(options.history_path);
+	assert(run_registry(options, {}).back() == "registry_test_a");
+
+	std::remove(options.history_path.c_str());
+}
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <cassert>
+#include <unistd.h>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// sink over a file descriptor, e.g. the write end of a pipe standing in for the UART
+struct FdByteSink : public QaseByteSink {
+	int fd;
+	explicit FdByteSink(int fd) : fd(fd) {}
+
+	void write(const uint8_t* data, std::size_t size) override {
+		ssize_t written = ::write(fd, data, size);
+		assert(written == static_cast<ssize_t>(size));
+	}
+};
+
+// sink into a fixed buffer, so it doesn't allocate either
+struct ArrayByteSink : public QaseByteSink {
+	uint8_t data[4096];
+	std::size_t size = 0;
+
+	void write(const uint8_t* bytes, std::size_t n) override {
+		assert(size + n <= sizeof(data));
+		std::memcpy(data + size, bytes, n);
+		size += n;
+	}
+};
+
+std::vector<TestResult> make_serial_results() {
+	std::vector<TestResult> results;
+	for (int i = 0; i < 5; ++i) {
+		TestResult r;
+		r.name = "test_" + std::to_string(i);
+		r.passed = i % 2 == 0;
+		if (i == 1) {
+			r.meta.case_id = 300;
+			r.meta.title = "Sensor reads temperature";
+			r.meta.fields["priority"] = "high";
+			r.meta.fields["layer"] = "unit";
+			r.logs = std::string(600, 'x') + "tail";
+		}
+		results.push_back(r);
+	}
+	return results;
+}
+
+// results streamed by the device over a pipe are decoded on the host and submitted in batches
+void test_serial_collector_submits_results_in_batches() {
+	int fds[2];
+	assert(pipe(fds) == 0);
+
+	FdByteSink sink(fds[1]);
+	qase_serial_emit_results(sink, make_serial_results());
+	close(fds[1]);
+
+	FakeQaseApi api;
+	FakeHttpClient http;
+	QaseConfig cfg = make_test_config();
+	cfg.batch_size = 2;
+
+	qase_serial_collect(fds[0], api, http, cfg);
+	close(fds[0]);
+
+	assert((api.calls == std::vector<std::string>{"start", "submit", "submit", "submit", "complete"}));
+
+	// the last batch holds the fifth result only
+	auto last = nlohmann::json::parse(api.submit_payload);
+	assert(last["results"].size() == 1);
+	assert(last["results"][0]["case"]["title"] == "test_4");
+	assert(last["results"][0]["status"] == "passed");
+}
+
+// every part of a result survives the round trip
+void test_serial_decoder_restores_results() {
+	ArrayByteSink sink;
+	qase_serial_emit_results(sink, make_serial_results());
+
+	QaseSerialDecoder decoder;
+	decoder.feed(sink.data, sink.size);
+
+	std::vector<TestResult> decoded;
+	decoder.take_results(decoded);
+
+	assert(decoder.run_ended());
+	assert(decoder.corrupt_frames() == 0);
+	assert(decoder.lost_results() == 0);
+	assert(decoded.size() == 5);
+	assert(decoded[0].name == "test_0" && decoded[0].passed);
+	assert(decoded[1].name == "test_1" && !decoded[1].passed);
+	assert(decoded[1].meta.case_id == 300);
+	assert(decoded[1].meta.title == "Sensor reads temperature");
+	assert(decoded[1].meta.fields.at("priority") == "high");
+	assert(decoded[1].meta.fields.at("layer") == "unit");
+	assert(decoded[1].logs == std::string(600, 'x') + "tail");
+	assert(decoded[2].logs.empty());
+}
+
+// the device-side encoder never allocates, and a passing test whose name is already
+// known to the host costs a handful of bytes
+void test_serial_encoder_is_allocation_free_and_compact() {
+	ArrayByteSink sink;
+	QaseSerialEncoder encoder(sink);
+
+	TestResult result;
+	result.name = "test_wifi_connects_successfully";
+	result.passed = true;
+	result.meta.fields["priority"] = "high";
+
+	TestResult repeated;
+	repeated.name = "test_wifi_connects_successfully";
+	repeated.passed = true;
+
+	const std::size_t before = test_allocations();
+	encoder.begin_run();
+	encoder.write_result(result);
+	assert(test_allocations() == before);
+
+	const std::size_t size_before = sink.size;
+	encoder.write_result(repeated);
+	encoder.end_run();
+	assert(test_allocations() == before);
+
+	// 0x03, flags, name id, crc + COBS overhead and delimiter
+	assert(sink.size - size_before <= 8 + 6);
+}
+
+// results with more distinct strings than the intern table holds: slots the result
+// being written already uses are never reused for its other strings
+void test_serial_encoder_keeps_strings_of_a_result_interned() {
+	std::vector<TestResult> results;
+	for (int i = 0; i < 50; ++i) {
+		TestResult& r = results.emplace_back();
+		r.name = "test_" + std::to_string(i % 7);
+		r.passed = i % 3 != 0;
+		r.meta.title = "title " + std::to_string(i % 5);
+		for (int f = 0; f < 3 + i % 28; ++f) {
+			r.meta.fields["key_" + std::to_string((f * 7 + i) % 40)] = "value_" + std::to_string((f + i) % 23);
+		}
+	}
+
+	struct VectorByteSink : public QaseByteSink {
+		std::vector<uint8_t> data;
+		void write(const uint8_t* bytes, std::size_t n) override { data.insert(data.end(), bytes, bytes + n); }
+	} sink;
+	qase_serial_emit_results(sink, results);
+
+	QaseSerialDecoder decoder;
+	decoder.feed(sink.data.data(), sink.data.size());
+	std::vector<TestResult> decoded;
+	decoder.take_results(decoded);
+
+	assert(decoder.corrupt_frames() == 0);
+	assert(decoded.size() == results.size());
+	for (std::size_t i = 0; i < results.size(); ++i) {
+		assert(decoded[i].name == results[i].name);
+		assert(decoded[i].passed == results[i].passed);
+		assert(decoded[i].meta.title == results[i].meta.title);
+		assert(decoded[i].meta.fields == results[i].meta.fields);
+	}
+}
+
+// damaged bytes on the line cost only the frame they hit
+void test_serial_decoder_resyncs_after_garbage() {
+	ArrayByteSink sink;
+	qase_serial_emit_results(sink, make_serial_results());
+
+	std::vector<uint8_t> stream = {0x13, 0x37, 0x42, 0x00};
+	stream.insert(stream.end(), sink.data, sink.data + sink.size);
+
+	// flip a byte inside the frame of the last result (the one before the run_end frame)
+	std::size_t delimiters = 0;
+	for (std::size_t i = stream.size() - 1; i > 0; --i) {
+		if (stream[i] == 0x00 && ++delimiters == 2) {
+			stream[i - 2] ^= 0x5A;
+			break;
+		}
+	}
+
+	QaseSerialDecoder decoder;
+	decoder.feed(stream.data(), stream.size());
+
+	std::vector<TestResult> decoded;
+	decoder.take_results(decoded);
+
+	assert(decoder.corrupt_frames() == 2);
+	assert(decoded.size() == 4);
+	assert(decoder.lost_results() == 1);
+}
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <cassert>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// exit status of a shard: bit 0 if it started the run, bit 1 if it completed it,
+// the run it submitted into above them
+static int shard_status(const FakeQaseApi& api) {
+	int status = 0;
+	for (const auto& call : api.calls) {
+		if (call == "start") {
+			status |= 1;
+		} else if (call == "complete") {
+			status |= 2;
+		}
+	}
+	return status | static_cast<int>(api.submit_run_id - 100) << 2;
+}
+
+// configures a shard, then records and submits its results once `go` is readable
+static pid_t start_shard(const QaseConfig& cfg, int index, int ready, int go) {
+	std::cout.flush();
+	pid_t pid = fork();
+	assert(pid >= 0);
+
+	if (pid == 0) {
+		qase_reporter_reset();
+		qase_reporter_configure(cfg);
+		char byte = 0;
+		if (write(ready, &byte, 1) != 1 || read(go, &byte, 1) != 1) {
+			_exit(100);
+		}
+
+		qase_reporter_add_result("test_shard_" + std::to_string(index), true);
+		struct ShardApi : FakeQaseApi {
+			uint64_t id;
+			uint64_t qase_start_run(HttpClient& http, const QaseConfig& cfg, const std::vector<int>& case_ids) override {
+				FakeQaseApi::qase_start_run(http, cfg, case_ids);
+				return id;
+			}
+		} api;
+		api.id = 100 + index;
+		FakeHttpClient http;
+		qase_submit_report(api, http, cfg);
+		_exit(shard_status(api));
+	}
+	return pid;
+}
+
+static int wait_shard(pid_t pid) {
+	int status = 0;
+	waitpid(pid, &status, 0);
+	assert(WIFEXITED(status));
+	return WEXITSTATUS(status);
+}
+
+// three shards with one key: the first to submit starts the run, the others submit
+// into it, and only the last to finish completes it
+void test_shards_share_one_run() {
+	QaseConfig cfg = make_test_config();
+	cfg.shared_run_key = "test-shards-" + std::to_string(getpid());
+
+	int ready[2];
+	assert(pipe(ready) == 0);
+	std::vector<pid_t> shards;
+	std::vector<int> go;
+	for (int i = 0; i < 3; ++i) {
+		int fds[2];
+		assert(pipe(fds) == 0);
+		shards.push_back(start_shard(cfg, i, ready[1], fds[0]));
+		go.push_back(fds[1]);
+	}
+
+	// every shard joined before any of them submits
+	char byte = 0;
+	for (int i = 0; i < 3; ++i) {
+		assert(read(ready[0], &byte, 1) == 1);
+	}
+
+	// shard 1 submits first, then 0, then 2
+	std::vector<int> status(3);
+	for (int i : {1, 0, 2}) {
+		assert(write(go[i], &byte, 1) == 1);
+		status[i] = wait_shard(shards[i]);
+	}
+
+	assert(status[1] == (1 | 1 << 2));
+	assert(status[0] == (1 << 2));
+	assert(status[2] == (2 | 1 << 2));
+
+	for (int fd : {ready[0], ready[1], go[0], go[1], go[2]}) {
+		close(fd);
+	}
+}
+
+// a shard that died without submitting doesn't hold the run open
+void test_shared_run_ignores_dead_shards() {
+	QaseConfig cfg = make_test_config();
+	cfg.shared_run_key = "test-dead-shard-" + std::to_string(getpid());
+
+	int ready[2];
+	int go[2];
+	assert(pipe(ready) == 0);
+	assert(pipe(go) == 0);
+	pid_t dead = start_shard(cfg, 0, ready[1], go[0]);
+	char byte = 0;
+	assert(read(ready[0], &byte, 1) == 1);
+	kill(dead, SIGKILL);
+	waitpid(dead, nullptr, 0);
+
+	qase_reporter_reset();
+	qase_reporter_configure(cfg);
+	qase_reporter_add_result("test_survivor", true);
+	FakeQaseApi api;
+	FakeHttpClient http;
+	qase_submit_report(api, http, cfg);
+
+	assert((api.calls == std::vector<std::string>{"start", "submit", "complete"}));
+	assert(api.complete_run_id == 42);
+
+	for (int fd : {ready[0], ready[1], go[0], go[1]}) {
+		close(fd);
+	}
+	qase_reporter_configure(QaseConfig{});
+	qase_reporter_reset();
+}
@@ -0,0 +1,145 @@
+#include <iostream>
+#include <cassert>
+#include <stdexcept>
+#include "qase_reporter.h"
+
+using namespace qase;
+
+// nested scopes are recorded flat in start order, with parents pointing up
+void test_steps_are_recorded_with_nesting() {
+	qase_reporter_reset();
+	qase_reporter_begin_test();
+	{
+		QASE_STEP("Power on the board");
+		{
+			QASE_STEP("Wait for boot banner");
+		}
+		{
+			QASE_STEP("Check firmware version");
+		}
+	}
+	{
+		QASE_STEP("Flash the image");
+	}
+	qase_reporter_add_result("test_boot_sequence", true);
+
+	const auto& steps = qase_reporter_get_results()[0].steps;
+	assert(steps.size() == 4);
+	assert(steps[0].name == "Power on the board" && steps[0].parent == -1);
+	assert(steps[1].name == "Wait for boot banner" && steps[1].parent == 0);
+	assert(steps[2].name == "Check firmware version" && steps[2].parent == 0);
+	assert(steps[3].name == "Flash the image" && steps[3].parent == -1);
+	for (const auto& step : steps) {
+		assert(step.passed);
+		assert(step.start_time_ms > 0);
+		assert(step.duration_us >= 0);
+	}
+	assert(steps[0].duration_us >= steps[1].duration_us);
+
+	// the buffer is handed over, the next test starts without steps
+	qase_reporter_begin_test();
+	qase_reporter_add_result("test_without_steps", true);
+	assert(qase_reporter_get_results()[1].steps.empty());
+}
+
+// Unity failures longjmp out of the scopes, so destructors never run:
+// whatever is still open when the result is recorded is the phase that failed
+void test_steps_left_open_are_failed() {
+	qase_reporter_reset();
+	qase_reporter_begin_test();
+
+	qase_step_end(qase_step_begin("Connect"), true);
+	qase_step_begin("Send request");
+	qase_step_begin("Parse response");
+
+	qase_reporter_add_result("test_interrupted", false);
+
+	const auto& steps = qase_reporter_get_results()[0].steps;
+	assert(steps.size() == 3);
+	assert(steps[0].passed);
+	assert(!steps[1].passed);
+	assert(!steps[2].passed && steps[2].parent == 1);
+
+	// ending a step of an already recorded test is harmless
+	qase_step_end(2, true);
+	qase_reporter_add_result("test_next", true);
+	assert(qase_reporter_get_results()[1].steps.empty());
+}
+
+// a scope left by an exception or marked with fail() fails the step
+void test_step_scope_fails_on_exception() {
+	qase_reporter_reset();
+	qase_reporter_begin_test();
+
+	try {
+		QASE_STEP("Throwing phase");
+		throw std::runtime_error("sensor timeout");
+	} catch (const std::runtime_error&) {
+	}
+
+	{
+		QaseStepScope step("Checked phase");
+		step.fail();
+	}
+
+	qase_reporter_add_result("test_exceptions", false);
+
+	const auto& steps = qase_reporter_get_results()[0].steps;
+	assert(steps.size() == 2);
+	assert(!steps[0].passed);
+	assert(!steps[1].passed);
+}
+
+// the step buffer is allocated once: later tests record their steps without allocating
+void test_steps_reuse_buffer_between_tests() {
+	qase_reporter_reset();
+	qase_reporter_reserve(2);
+
+	qase_reporter_begin_test();
+	{
+		QASE_STEP("Warm up the buffer");
+	}
+	qase_reporter_add_result("test_a", true);
+
+	qase_reporter_begin_test();
+	const std::size_t before = test_allocations();
+	for (int i = 0; i < 10; ++i) {
+		QASE_STEP("Phase with a name that does not fit into small string storage");
+	}
+	assert(test_allocations() == before);
+
+	qase_reporter_add_result("test_b", true);
+	assert(qase_reporter_get_results()[1].steps.size() == 10);
+}
+
+// steps go to the api payload nested, with the duration in the comment
+void test_steps_are_serialized_nested() {
+	TestResult result;
+	result.name = "test_with_steps";
+	result.passed = false;
+	result.steps.push_back({"Outer", false, -1, 1700000000000, 2500});
+	result.steps.push_back({"Inner passed", true, 0, 1700000000000, 1000});
+	result.steps.push_back({"Inner failed", false, 0, 1700000000001, 1000});
+	result.steps.push_back({"Second", true, -1, 1700000000003, 4000});
+
+	auto payload = nlohmann::json::parse(qase_serialize_results({result}));
+	const auto& steps = payload["results"][0]["steps"];
+
+	assert(steps.size() == 2);
+	assert(steps[0]["action"] == "Outer");
+	assert(steps[0]["status"] == "failed");
+	assert(steps[0]["position"] == 1);
+	assert(steps[0]["steps"].size() == 2);
+	assert(steps[0]["steps"][1]["action"] == "Inner failed");
+	assert(steps[0]["steps"][1]["position"] == 2);
+	assert(steps[1]["action"] == "Second");
+	assert(steps[1]["comment"] == "Took 4 ms");
+	assert(!steps[1].contains("steps"));
+
+	// results without steps carry no steps key
+	TestResult plain;
+	plain.name = "test_plain";
+	plain.passed = true;
+	auto plain_payload = nlohmann::json::parse(qase_serialize_results({plain}));
+	assert(!plain_payload["results"][0].contains("steps"));
+}
@@ -1,5 +1,12 @@
 #include <iostream>
 #include <cassert>
+#include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
 #include "qase_reporter.h"
 
 using namespace qase;
@@ -141,6 +148,11 @@ void test_start_run_calls_correct_url()
 	api.qase_start_run(fake, cfg);
 
 	assert(fake.called_url == "https://api.qase.io/v1/run/ET1");
+
+	// a host with a scheme is used as is, e.g. for a local mock server
+	cfg.host = "http://127.0.0.1:8080";
+	api.qase_start_run(fake, cfg);
+	assert(fake.called_url == "http://127.0.0.1:8080/v1/run/ET1");
 }
 
 // helper: searches for token in the fake http client
@@ -234,11 +246,15 @@ struct FakeQaseApi : public IQaseApi {
 
 	uint64_t submit_run_id = 0;
 	std::string submit_payload;
+	std::vector<std::string> submit_payloads;
 
 	uint64_t complete_run_id = 0;
 
-	uint64_t qase_start_run(HttpClient&, const QaseConfig& cfg) override {
+	std::vector<int> start_case_ids;
+
+	uint64_t qase_start_run(HttpClient&, const QaseConfig& cfg, const std::vector<int>& case_ids) override {
 		calls.push_back("start");
+		start_case_ids = case_ids;
 		start_project_code = cfg.project;
 		start_token = cfg.token;
 		return 42;
@@ -248,6 +264,7 @@ struct FakeQaseApi : public IQaseApi {
 		calls.push_back("submit");
 		submit_run_id = run_id;
 		submit_payload = payload;
+		submit_payloads.push_back(payload);
 		return true;
 	}
 
@@ -256,6 +273,27 @@ struct FakeQaseApi : public IQaseApi {
 		complete_run_id = run_id;
 		return true;
 	}
+
+	std::vector<std::string> uploaded_paths;
+
+	std::string qase_upload_attachment(HttpClient&, const QaseConfig&, const std::string& path) override {
+		calls.push_back("upload");
+		uploaded_paths.push_back(path);
+		return "hash-" + std::to_string(uploaded_paths.size());
+	}
+
+	std::vector<std::vector<std::string>> created_cases;
+	int next_case_id = 1000;
+
+	std::vector<int> qase_create_cases(HttpClient&, const QaseConfig&, const std::vector<std::string>& titles) override {
+		calls.push_back("create_cases");
+		created_cases.push_back(titles);
+		std::vector<int> ids;
+		for (std::size_t i = 0; i < titles.size(); ++i) {
+			ids.push_back(next_case_id++);
+		}
+		return ids;
+	}
 };
 
 // qase_submit_report must follow this flow:
@@ -375,3 +413,719 @@ void test_orchestrator_skips_complete_run_if_config_false() {
 	// verify that only "start" and "submit" were called
 	assert((api.calls == std::vector<std::string>{"start", "submit"}));
 }
+
+// results are bulk submitted in payloads of at most batch_size results
+void test_orchestrator_submits_in_batches() {
+	FakeQaseApi api;
+	FakeHttpClient http;
+
+	qase_reporter_reset();
+	for (int i = 0; i < 5; ++i) {
+		qase_reporter_add_result("batched_" + std::to_string(i), true);
+	}
+
+	QaseConfig cfg = make_test_config();
+	cfg.batch_size = 2;
+
+	qase_submit_report(api, http, cfg);
+
+	assert((api.calls == std::vector<std::string>{"start", "submit", "submit", "submit", "complete"}));
+
+	auto last = nlohmann::json::parse(api.submit_payload);
+	assert(last["results"].size() == 1);
+	assert(last["results"][0]["case"]["title"] == "batched_4");
+}
+
+// records the same cycle of a continuous run: sensor_2 status comes from the argument
+static void record_delta_cycle(bool sensor_2_passed, bool with_new_test = false) {
+	qase_reporter_reset();
+	for (int i = 0; i < 4; ++i) {
+		QaseResultMeta meta;
+		meta.fields["layer"] = "hil";
+		qase_reporter_add_result("sensor_" + std::to_string(i), i == 2 ? sensor_2_passed : true, std::move(meta));
+	}
+	if (with_new_test) {
+		qase_reporter_add_result("sensor_new", true);
+	}
+}
+
+static std::size_t submitted_results(const FakeQaseApi& api) {
+	return api.submit_payload.empty() ? 0 : nlohmann::json::parse(api.submit_payload)["results"].size();
+}
+
+// into a long-lived run only results that changed since the last submission are sent
+void test_orchestrator_submits_only_changed_results() {
+	const std::string state_path = "qase_delta_state.bin";
+	std::remove(state_path.c_str());
+
+	QaseConfig cfg = make_test_config();
+	cfg.run_id = 77;
+	cfg.run_complete = false;
+	cfg.delta_state_path = state_path;
+	FakeHttpClient http;
+
+	// no state yet: everything is sent
+	{
+		FakeQaseApi api;
+		record_delta_cycle(true);
+		qase_submit_report(api, http, cfg);
+		assert(submitted_results(api) == 4);
+	}
+
+	// nothing changed: nothing is sent
+	{
+		FakeQaseApi api;
+		record_delta_cycle(true);
+		qase_submit_report(api, http, cfg);
+		assert(api.calls.empty());
+	}
+
+	// one status flipped and one test is new
+	{
+		FakeQaseApi api;
+		record_delta_cycle(false, true);
+		qase_submit_report(api, http, cfg);
+		auto payload = nlohmann::json::parse(api.submit_payload);
+		assert(payload["results"].size() == 2);
+		assert(payload["results"][0]["case"]["title"] == "sensor_2");
+		assert(payload["results"][0]["status"] == "failed");
+		assert(payload["results"][1]["case"]["title"] == "sensor_new");
+	}
+
+	// a state kept for another run doesn't apply
+	{
+		FakeQaseApi api;
+		QaseConfig other_run = cfg;
+		other_run.run_id = 78;
+		record_delta_cycle(false, true);
+		qase_submit_report(api, http, other_run);
+		assert(submitted_results(api) == 5);
+	}
+
+	// neither does a damaged one
+	{
+		std::ofstream(state_path, std::ios::binary | std::ios::trunc) << "QDLT garbage";
+		FakeQaseApi api;
+		record_delta_cycle(false, true);
+		qase_submit_report(api, http, cfg);
+		assert(submitted_results(api) == 5);
+	}
+
+	std::remove(state_path.c_str());
+}
+
+// every resync_every delta submissions, the next one sends everything again
+void test_orchestrator_resyncs_delta_periodically() {
+	const std::string state_path = "qase_delta_resync_state.bin";
+	std::remove(state_path.c_str());
+
+	QaseConfig cfg = make_test_config();
+	cfg.run_id = 77;
+	cfg.run_complete = false;
+	cfg.delta_state_path = state_path;
+	cfg.delta_resync_every = 2;
+	FakeHttpClient http;
+
+	std::vector<std::size_t> sent;
+	for (int cycle = 0; cycle < 6; ++cycle) {
+		FakeQaseApi api;
+		record_delta_cycle(true);
+		qase_submit_report(api, http, cfg);
+		sent.push_back(submitted_results(api));
+	}
+
+	assert((sent == std::vector<std::size_t>{4, 0, 0, 4, 0, 0}));
+
+	std::remove(state_path.c_str());
+}
+
+// thread-safe fake for the worker pool: fails the batches whose first result is listed
+struct ConcurrentFakeQaseApi : public IQaseApi {
+	std::mutex mutex;
+	std::vector<std::string> calls;
+	std::vector<std::string> submitted_titles;
+	std::vector<std::string> failing_titles;
+	std::atomic<int> in_flight{0};
+	int max_in_flight = 0;
+
+	uint64_t qase_start_run(HttpClient&, const QaseConfig&, const std::vector<int>&) override {
+		std::lock_guard<std::mutex> lock(mutex);
+		calls.push_back("start");
+		return 42;
+	}
+
+	bool qase_submit_results(HttpClient&, const QaseConfig&, uint64_t, const std::string& payload) override {
+		const int now_in_flight = ++in_flight;
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+		auto results = nlohmann::json::parse(payload)["results"];
+		const std::string first = results[0]["case"]["title"];
+
+		std::lock_guard<std::mutex> lock(mutex);
+		--in_flight;
+		max_in_flight = std::max(max_in_flight, now_in_flight);
+		calls.push_back("submit");
+		if (std::find(failing_titles.begin(), failing_titles.end(), first) != failing_titles.end()) {
+			throw std::runtime_error("Qase API error: batch rejected");
+		}
+		for (const auto& result : results) {
+			submitted_titles.push_back(result["case"]["title"]);
+		}
+		return true;
+	}
+
+	bool qase_complete_run(HttpClient&, const QaseConfig&, uint64_t) override {
+		std::lock_guard<std::mutex> lock(mutex);
+		calls.push_back("complete");
+		return true;
+	}
+
+	std::string qase_upload_attachment(HttpClient&, const QaseConfig&, const std::string&) override {
+		return "hash";
+	}
+
+	std::vector<int> qase_create_cases(HttpClient&, const QaseConfig&, const std::vector<std::string>&) override {
+		return {};
+	}
+};
+
+// batches go out from several workers, and the run is completed after all of them
+void test_orchestrator_submits_batches_from_worker_pool() {
+	ConcurrentFakeQaseApi api;
+	std::atomic<int> clients{0};
+	HttpClientFactory make_client = [&clients] {
+		++clients;
+		return std::unique_ptr<HttpClient>(new FakeHttpClient());
+	};
+
+	qase_reporter_reset();
+	for (int i = 0; i < 10; ++i) {
+		qase_reporter_add_result("pooled_" + std::to_string(i), true);
+	}
+
+	QaseConfig cfg = make_test_config();
+	cfg.batch_size = 2;
+	cfg.upload_workers = 4;
+
+	qase_submit_report(api, make_client, cfg);
+
+	// one client for the run itself, one per worker
+	assert(clients == 5);
+	assert(api.max_in_flight > 1);
+	assert(api.calls.front() == "start");
+	assert(api.calls.back() == "complete");
+	assert(std::count(api.calls.begin(), api.calls.end(), "submit") == 5);
+
+	std::sort(api.submitted_titles.begin(), api.submitted_titles.end());
+	assert(api.submitted_titles.size() == 10);
+	assert(api.submitted_titles.front() == "pooled_0");
+	assert(api.submitted_titles.back() == "pooled_9");
+}
+
+// a factory that hands out no client is an error up front; in the pool, the other
+// workers take over the batches of one that got none
+void test_orchestrator_rejects_null_clients() {
+	ConcurrentFakeQaseApi api;
+	qase_reporter_reset();
+	for (int i = 0; i < 10; ++i) {
+		qase_reporter_add_result("pooled_" + std::to_string(i), true);
+	}
+
+	QaseConfig cfg = make_test_config();
+	cfg.batch_size = 2;
+	cfg.upload_workers = 3;
+
+	bool threw = false;
+	try {
+		qase_submit_report(api, HttpClientFactory([] { return std::unique_ptr<HttpClient>(); }), cfg);
+	} catch (const std::runtime_error& e) {
+		threw = std::string(e.what()).find("returned no client") != std::string::npos;
+	}
+	assert(threw);
+	assert(api.calls.empty());
+
+	std::atomic<int> clients{0};
+	HttpClientFactory every_other = [&clients] {
+		return ++clients % 2 == 0 ? std::unique_ptr<HttpClient>() : std::unique_ptr<HttpClient>(new FakeHttpClient());
+	};
+	qase_submit_report(api, every_other, cfg);
+	assert(api.submitted_titles.size() == 10);
+	assert(api.calls.back() == "complete");
+}
+
+// failed batches don't stop the others, are reported together, and keep the run open
+void test_orchestrator_aggregates_batch_failures() {
+	ConcurrentFakeQaseApi api;
+	api.failing_titles = {"pooled_2", "pooled_6"};
+	HttpClientFactory make_client = [] { return std::unique_ptr<HttpClient>(new FakeHttpClient()); };
+
+	qase_reporter_reset();
+	for (int i = 0; i < 10; ++i) {
+		qase_reporter_add_result("pooled_" + std::to_string(i), true);
+	}
+
+	QaseConfig cfg = make_test_config();
+	cfg.batch_size = 2;
+	cfg.upload_workers = 3;
+
+	std::string message;
+	try {
+		qase_submit_report(api, make_client, cfg);
+	} catch (const std::runtime_error& e) {
+		message = e.what();
+	}
+
+	assert(message.find("Failed to submit 2 of 5 result batches") != std::string::npos);
+	assert(message.find("batch 2 (results 3-4): Qase API error: batch rejected") != std::string::npos);
+	assert(message.find("batch 4 (results 7-8)") != std::string::npos);
+	assert(message.find("batch 2") < message.find("batch 4"));
+
+	assert(api.submitted_titles.size() == 6);
+	assert(std::find(api.calls.begin(), api.calls.end(), "complete") == api.calls.end());
+}
+
+// runs are created with the given cases only, plus the plan when configured
+void test_start_run_sends_selected_cases_and_plan() {
+	QaseApi api;
+	FakeHttpClient fake;
+	fake.canned_response = R"({ "status": true, "result": { "id": 5 } })";
+
+	QaseConfig cfg = make_test_config();
+	api.qase_start_run(fake, cfg, {3, 17, 40});
+
+	auto payload = nlohmann::json::parse(fake.called_payload);
+	assert(payload["include_all_cases"] == false);
+	assert((payload["cases"] == nlohmann::json{3, 17, 40}));
+	assert(!payload.contains("plan_id"));
+
+	cfg.plan_id = 9;
+	api.qase_start_run(fake, cfg);
+	payload = nlohmann::json::parse(fake.called_payload);
+	assert(payload["plan_id"] == 9);
+	assert(!payload.contains("cases"));
+
+	// the old behaviour stays available
+	cfg.include_all_cases = true;
+	api.qase_start_run(fake, cfg, {3});
+	payload = nlohmann::json::parse(fake.called_payload);
+	assert(payload["include_all_cases"] == true);
+	assert(!payload.contains("cases"));
+}
+
+// the orchestrator starts the run with the case ids present in the results
+void test_orchestrator_starts_run_with_result_cases() {
+	FakeQaseApi api;
+	FakeHttpClient http;
+
+	qase_reporter_reset();
+	for (int case_id : {12, 0, 5, 12}) {
+		QaseResultMeta meta;
+		meta.case_id = case_id;
+		qase_reporter_add_result("case_" + std::to_string(case_id), true, std::move(meta));
+	}
+
+	qase_submit_report(api, http, make_test_config());
+
+	assert((api.start_case_ids == std::vector<int>{5, 12}));
+}
+
+// new tests are created as cases in one call, and their ids come from the cache afterwards
+void test_orchestrator_resolves_case_ids_through_cache() {
+	const std::string cache_path = "qase_case_cache.bin";
+	std::remove(cache_path.c_str());
+
+	QaseConfig cfg = make_test_config();
+	cfg.case_cache_path = cache_path;
+	FakeHttpClient http;
+
+	auto record = [](bool with_new_test) {
+		qase_reporter_reset();
+		qase_reporter_add_result("test_adc_reads", true);
+
+		QaseResultMeta titled;
+		titled.title = "GPIO toggles";
+		qase_reporter_add_result("test_gpio_toggle", true, std::move(titled));
+
+		QaseResultMeta known;
+		known.case_id = 7;
+		qase_reporter_add_result("test_known_case", true, std::move(known));
+
+		qase_reporter_add_result("test_adc_reads", false);
+		if (with_new_test) {
+			qase_reporter_add_result("test_uart_echo", true);
+		}
+	};
+
+	// submitting leaves the recorded results alone, resolving is a step of its own
+	FakeQaseApi unresolved;
+	record(false);
+	qase_submit_report(unresolved, http, cfg);
+	assert(unresolved.created_cases.empty());
+	assert(qase_reporter_get_results()[0].meta.case_id == 0);
+
+	FakeQaseApi first;
+	record(false);
+	qase_reporter_resolve_case_ids(first, http, cfg);
+	assert(qase_reporter_get_results()[0].meta.case_id == 1000);
+	qase_submit_report(first, http, cfg);
+
+	assert(first.calls.front() == "create_cases");
+	assert((first.created_cases == std::vector<std::vector<std::string>>{{"test_adc_reads", "GPIO toggles"}}));
+	assert((first.start_case_ids == std::vector<int>{7, 1000, 1001}));
+
+	auto payload = nlohmann::json::parse(first.submit_payload);
+	assert(payload["results"][0]["case"]["case_id"] == 1000);
+	assert(payload["results"][1]["case"]["case_id"] == 1001);
+	assert(payload["results"][2]["case"]["case_id"] == 7);
+	assert(payload["results"][3]["case"]["case_id"] == 1000);
+
+	// next run: only the new test is created, the rest comes from the cache file
+	FakeQaseApi second;
+	second.next_case_id = 2000;
+	record(true);
+	qase_reporter_resolve_case_ids(second, http, cfg);
+	qase_submit_report(second, http, cfg);
+
+	assert((second.created_cases == std::vector<std::vector<std::string>>{{"test_uart_echo"}}));
+	payload = nlohmann::json::parse(second.submit_payload);
+	assert(payload["results"][0]["case"]["case_id"] == 1000);
+	assert(payload["results"][1]["case"]["case_id"] == 1001);
+	assert(payload["results"][4]["case"]["case_id"] == 2000);
+
+	// nothing new: no creation call at all
+	FakeQaseApi third;
+	record(true);
+	qase_reporter_resolve_case_ids(third, http, cfg);
+	qase_submit_report(third, http, cfg);
+	assert(third.created_cases.empty());
+
+	// the cache belongs to its project
+	FakeQaseApi other_project;
+	QaseConfig other_cfg = cfg;
+	other_cfg.project = "OTHER";
+	record(false);
+	qase_reporter_resolve_case_ids(other_project, http, other_cfg);
+	qase_submit_report(other_project, http, other_cfg);
+	assert(other_project.created_cases.size() == 1 && other_project.created_cases[0].size() == 2);
+
+	std::remove(cache_path.c_str());
+}
+
+void test_create_cases_posts_titles_in_bulk() {
+	QaseApi api;
+	FakeHttpClient fake;
+	fake.canned_response = R"({ "status": true, "result": { "ids": [31, 32] } })";
+
+	auto ids = api.qase_create_cases(fake, make_test_config(), {"Boots", "Sleeps"});
+
+	assert((ids == std::vector<int>{31, 32}));
+	assert(fake.called_url == "https://api.qase.io/v1/case/ET1/bulk");
+	auto payload = nlohmann::json::parse(fake.called_payload);
+	assert(payload["cases"][1]["title"] == "Sleeps");
+}
+
+// an api answering with fewer ids than cases asked for fails the resolution
+void test_case_resolution_rejects_wrong_id_count() {
+	const std::string cache_path = "qase_case_cache_short.bin";
+	std::remove(cache_path.c_str());
+
+	QaseConfig cfg = make_test_config();
+	cfg.case_cache_path = cache_path;
+	FakeHttpClient http;
+
+	struct ShortAnswerApi : FakeQaseApi {
+		std::vector<int> qase_create_cases(HttpClient&, const QaseConfig&, const std::vector<std::string>&) override {
+			return {1000};
+		}
+	} api;
+
+	qase_reporter_reset();
+	qase_reporter_add_result("test_adc_reads", true);
+	qase_reporter_add_result("test_gpio_toggle", true);
+
+	bool threw = false;
+	try {
+		qase_reporter_resolve_case_ids(api, http, cfg);
+	} catch (const std::runtime_error& e) {
+		threw = std::string(e.what()).find("Case creation failed") != std::string::npos;
+	}
+	assert(threw);
+	assert(qase_reporter_get_results()[1].meta.case_id == 0);
+
+	qase_reporter_reset();
+	std::remove(cache_path.c_str());
+}
+
+// titles of every submitted result, in submission order
+static std::vector<std::string> submitted_titles(const FakeQaseApi& api) {
+	std::vector<std::string> titles;
+	for (const auto& payload : api.submit_payloads) {
+		const auto body = nlohmann::json::parse(payload);
+		for (const auto& result : body["results"]) {
+			titles.push_back(result["case"]["title"]);
+		}
+	}
+	return titles;
+}
+
+// past the memory budget results go to a segment on disk, and are sent back in order
+void test_recorder_spills_to_disk_over_budget() {
+	const std::string spill_path = "test_recorder_spill.bin";
+
+	QaseConfig cfg = make_test_config();
+	cfg.recorder_memory_budget = 16 * 1024;
+	cfg.recorder_spill_path = spill_path;
+	cfg.batch_size = 1000;
+	qase_reporter_configure(cfg);
+	qase_reporter_reset();
+
+	std::vector<std::string> expected;
+	std::size_t max_in_memory = 0;
+	for (int i = 0; i < 300; ++i) {
+		QaseResultMeta meta;
+		meta.case_id = i == 3 ? 33 : 0;
+		meta.fields["index"] = std::to_string(i);
+		const std::string name = "test_soak_" + std::to_string(i);
+		{
+			QASE_STEP("Read the sensor");
+		}
+		qase_reporter_add_result(name, i % 7 != 0, std::move(meta));
+		expected.push_back(name);
+		max_in_memory = std::max(max_in_memory, qase_reporter_get_results().size());
+	}
+	assert(max_in_memory < 300);
+	assert(access(spill_path.c_str(), F_OK) == 0);
+
+	FakeQaseApi api;
+	FakeHttpClient http;
+	qase_submit_report(api, http, cfg);
+
+	// the run knows the cases of spilled results too
+	assert((api.start_case_ids == std::vector<int>{33}));
+	assert(submitted_titles(api) == expected);
+	assert(api.calls.back() == "complete");
+
+	auto first = nlohmann::json::parse(api.submit_payloads.front())["results"];
+	assert(first[0]["status"] == "failed");
+	assert(first[1]["status"] == "passed");
+	assert(first[3]["case"]["case_id"] == 33);
+	assert(first[3]["case"]["index"] == "3");
+	assert(first[1]["steps"][0]["action"] == "Read the sensor");
+
+	// the segment is gone once everything was sent
+	assert(access(spill_path.c_str(), F_OK) != 0);
+
+	qase_reporter_configure(QaseConfig());
+	qase_reporter_reset();
+}
+
+// qase_reporter_get_results holds the in-memory tail only; visiting the results and
+// streaming them over serial reads the spilled ones back first
+void test_recorder_spill_is_visited_and_streamed() {
+	QaseConfig cfg = make_test_config();
+	cfg.recorder_memory_budget = 2000;
+	cfg.recorder_spill_path = "test_recorder_visit_spill.bin";
+	qase_reporter_configure(cfg);
+	qase_reporter_reset();
+
+	std::vector<std::string> expected;
+	for (int i = 0; i < 50; ++i) {
+		expected.push_back("test_soak_" + std::to_string(i));
+		qase_reporter_add_result(expected.back(), i != 7);
+	}
+	assert(qase_reporter_get_results().size() < 50);
+
+	std::vector<std::string> visited;
+	qase_reporter_for_each_result([&visited](const TestResult& result) {
+		visited.push_back(result.name);
+	});
+	assert(visited == expected);
+
+	struct VectorSink : public QaseByteSink {
+		std::vector<uint8_t> bytes;
+		void write(const uint8_t* data, std::size_t size) override {
+			bytes.insert(bytes.end(), data, data + size);
+		}
+	} sink;
+	qase_serial_emit_recorded(sink);
+
+	QaseSerialDecoder decoder;
+	decoder.feed(sink.bytes.data(), sink.bytes.size());
+	std::vector<TestResult> decoded;
+	decoder.take_results(decoded);
+	assert(decoder.run_ended() && decoder.lost_results() == 0);
+	assert(decoded.size() == expected.size());
+	for (std::size_t i = 0; i < decoded.size(); ++i) {
+		assert(decoded[i].name == expected[i]);
+		assert(decoded[i].passed == (i != 7));
+	}
+
+	qase_reporter_configure(QaseConfig());
+	qase_reporter_reset();
+}
+
+#ifdef QASE_REPORTER_FULL_MODE_ENABLED
+// in report mode the local report holds the spilled results too, ahead of the rest
+void test_recorder_spills_into_local_report() {
+	const std::string spill_path = "test_recorder_report_spill.bin";
+	const std::string report_path = "test_recorder_spill_report";
+
+	for (const std::string format : {"json", "cbor", "msgpack"}) {
+		QaseConfig cfg = make_test_config();
+		cfg.mode = "report";
+		cfg.connection_format = format;
+		cfg.report_connection_path = report_path + "." + format;
+		cfg.recorder_memory_budget = 2000;
+		cfg.recorder_spill_path = spill_path;
+		qase_reporter_configure(cfg);
+		qase_reporter_reset();
+
+		std::vector<std::string> expected;
+		for (int i = 0; i < 50; ++i) {
+			expected.push_back("test_soak_" + std::to_string(i));
+			qase_reporter_add_result(expected.back(), true);
+		}
+		assert(qase_reporter_get_results().size() < 50);
+		assert(access(spill_path.c_str(), F_OK) == 0);
+
+		FakeHttpClient http;
+		qase_reporter_finish(http, cfg);
+
+		qase_convert_report(cfg.report_connection_path, report_path + ".converted.json");
+		nlohmann::json report;
+		std::ifstream(report_path + ".converted.json") >> report;
+		std::vector<std::string> titles;
+		for (const auto& entry : report["results"]) {
+			titles.push_back(entry["title"]);
+		}
+		assert(titles == expected);
+		assert(access(spill_path.c_str(), F_OK) != 0);
+
+		std::remove(cfg.report_connection_path.c_str());
+		std::remove((report_path + ".converted.json").c_str());
+	}
+
+	qase_reporter_configure(QaseConfig());
+	qase_reporter_reset();
+}
+#endif
+
+// in upload mode results over the budget are submitted while the tests run
+void test_recorder_flushes_upstream_over_budget() {
+	QaseConfig cfg = make_test_config();
+	cfg.recorder_memory_budget = 16 * 1024;
+	cfg.recorder_spill = "upload";
+	cfg.batch_size = 1000;
+	qase_reporter_configure(cfg);
+	qase_reporter_reset();
+
+	FakeQaseApi api;
+	FakeHttpClient http;
+	qase_reporter_set_uploader(api, http);
+
+	std::vector<std::string> expected;
+	for (int i = 0; i < 300; ++i) {
+		expected.push_back("test_soak_" + std::to_string(i));
+		qase_reporter_add_result(expected.back(), true);
+	}
+	assert(api.calls.size() >= 2 && api.calls[0] == "start" && api.calls[1] == "submit");
+
+	qase_submit_report(api, http, cfg);
+
+	// one run, completed once, every result in order
+	assert(std::count(api.calls.begin(), api.calls.end(), "start") == 1);
+	assert(std::count(api.calls.begin(), api.calls.end(), "complete") == 1);
+	assert(submitted_titles(api) == expected);
+	assert(api.complete_run_id == 42);
+
+	qase_reporter_configure(QaseConfig());
+	qase_reporter_reset();
+}
+
+// a flush that got some of its batches through leaves only the other ones for later
+void test_recorder_upload_resends_only_failed_batches() {
+	const std::string spill_path = "test_recorder_partial_upload.bin";
+
+	QaseConfig cfg = make_test_config();
+	cfg.recorder_memory_budget = 16 * 1024;
+	cfg.recorder_spill = "upload";
+	cfg.recorder_spill_path = spill_path;
+	cfg.batch_size = 10;
+	qase_reporter_configure(cfg);
+	qase_reporter_reset();
+
+	// the second batch of the first flush is refused
+	struct PartlyRefusingApi : FakeQaseApi {
+		int submits = 0;
+
+		bool qase_submit_results(HttpClient& http, const QaseConfig& cfg, uint64_t run_id, const std::string& payload) override {
+			if (++submits == 2) {
+				return false;
+			}
+			return FakeQaseApi::qase_submit_results(http, cfg, run_id, payload);
+		}
+	} api;
+	FakeHttpClient http;
+	qase_reporter_set_uploader(api, http);
+
+	std::vector<std::string> expected;
+	for (int i = 0; i < 300; ++i) {
+		expected.push_back("test_soak_" + std::to_string(i));
+		qase_reporter_add_result(expected.back(), true);
+	}
+	assert(api.submits > 2);
+	assert(access(spill_path.c_str(), F_OK) == 0);
+
+	qase_submit_report(api, http, cfg);
+
+	// every result made it in exactly once
+	std::vector<std::string> titles = submitted_titles(api);
+	std::sort(titles.begin(), titles.end());
+	std::sort(expected.begin(), expected.end());
+	assert(titles == expected);
+	assert(std::count(api.calls.begin(), api.calls.end(), "start") == 1);
+
+	qase_reporter_configure(QaseConfig());
+	qase_reporter_reset();
+}
+
+// results that left memory are checked against the delta state like the ones that stayed
+void test_recorder_spill_follows_delta_state() {
+	const std::string state_path = "qase_delta_spill_state.bin";
+
+	for (const std::string mode : {"disk", "upload"}) {
+		std::remove(state_path.c_str());
+
+		QaseConfig cfg = make_test_config();
+		cfg.run_id = 77;
+		cfg.run_complete = false;
+		cfg.delta_state_path = state_path;
+		cfg.recorder_memory_budget = 16 * 1024;
+		cfg.recorder_spill = mode;
+		cfg.recorder_spill_path = "test_recorder_delta_spill.bin";
+		qase_reporter_configure(cfg);
+		FakeHttpClient http;
+
+		// test_soak_<failing> fails, the others pass
+		auto cycle = [&](int failing) {
+			FakeQaseApi api;
+			qase_reporter_reset();
+			qase_reporter_set_uploader(api, http);
+			for (int i = 0; i < 300; ++i) {
+				qase_reporter_add_result("test_soak_" + std::to_string(i), i != failing);
+			}
+			qase_submit_report(api, http, cfg);
+			return submitted_titles(api);
+		};
+
+		assert(cycle(-1).size() == 300);
+		assert(cycle(-1).empty());
+		// an early result, long out of memory by the submission
+		assert((cycle(3) == std::vector<std::string>{"test_soak_3"}));
+		assert(cycle(3).empty());
+	}
+
+	std::remove(state_path.c_str());
+	qase_reporter_configure(QaseConfig());
+	qase_reporter_reset();
+}
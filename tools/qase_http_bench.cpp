@@ -0,0 +1,104 @@
+// requests/sec of QaseCurlHttpClient against the naive client that opens a new
+// connection for every call, both posting to a loopback stand-in server
+//
+// usage: qase_http_bench [requests] [threads] [server latency ms]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <curl/curl.h>
+
+#include "qase_curl_http_client.h"
+#include "qase_loopback_server.h"
+
+// the pattern the curl client replaces: a fresh easy handle, and connection, per post
+static void naive_post(const std::string& url, const std::string& body) {
+	CURL* curl = curl_easy_init();
+	std::string response;
+	curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
+	curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, +[](char* data, size_t size, size_t n, void* out) {
+		static_cast<std::string*>(out)->append(data, size * n);
+		return size * n;
+	});
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+	CURLcode code = curl_easy_perform(curl);
+	curl_easy_cleanup(curl);
+	if (code != CURLE_OK) {
+		throw std::runtime_error(std::string("HTTP request failed: ") + curl_easy_strerror(code));
+	}
+}
+
+// runs `requests` posts split over `threads` threads, returns requests per second
+static double measure(int requests, int threads, const std::function<void(int)>& post) {
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t) {
+		const int count = requests / threads + (t < requests % threads ? 1 : 0);
+		workers.emplace_back([&post, count, t] {
+			for (int i = 0; i < count; ++i) {
+				post(t);
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return requests / seconds;
+}
+
+int main(int argc, char** argv) {
+	const int requests = argc > 1 ? std::atoi(argv[1]) : 5000;
+	const int threads = argc > 2 ? std::max(1, std::atoi(argv[2])) : 4;
+	const int latency_ms = argc > 3 ? std::atoi(argv[3]) : 0;
+
+	try {
+		qase::QaseLoopbackServer server([latency_ms](const qase::LoopbackRequest&) {
+			qase::LoopbackResponse response;
+			response.body = R"({"status":true})";
+			response.delay = std::chrono::milliseconds(latency_ms);
+			return response;
+		});
+
+		const std::string url = server.url("/v1/result/DEMO/1/bulk");
+		const std::string body = R"({"results":[{"case":{"title":"test_wifi_connects"},"status":"passed"}]})";
+
+		curl_global_init(CURL_GLOBAL_DEFAULT);
+
+		const double naive = measure(requests, threads, [&](int) { naive_post(url, body); });
+		const std::size_t naive_connections = server.connections();
+
+		double pooled = 0;
+		std::size_t pooled_connections = 0;
+		{
+			qase::QaseCurlOptions options;
+			options.max_host_connections = threads;
+			auto transport = std::make_shared<qase::QaseCurlTransport>(options);
+			std::vector<qase::QaseCurlHttpClient> clients(threads, qase::QaseCurlHttpClient(transport));
+
+			pooled = measure(requests, threads, [&](int t) { clients[t].post(url, body, {}); });
+			pooled_connections = transport->connections_opened();
+		}
+
+		std::printf("%d requests, %d threads, %d ms server latency\n", requests, threads, latency_ms);
+		std::printf("  connection per call: %10.0f req/s, %zu connections\n", naive, naive_connections);
+		std::printf("  QaseCurlHttpClient:  %10.0f req/s, %zu connections\n", pooled, pooled_connections);
+		std::printf("  speedup: %.2fx\n", pooled / naive);
+
+		curl_global_cleanup();
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "qase_http_bench: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,115 @@
+// end-to-end load harness: records a synthetic suite and pushes it through
+// qase_reporter_finish and QaseCurlHttpClient into the in-process mock Qase API
+//
+// usage: qase_load_harness [results] [batch size] [workers] [latency ms] [error rate] [throttle rate]
+//
+// reports wall time, throughput and peak RSS; with workers > 1 the batches are sent
+// through qase_submit_report with one client per worker on a shared transport
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "qase_curl_http_client.h"
+#include "qase_mock_server.h"
+#include "qase_reporter.h"
+
+static long peak_rss_kb() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_maxrss;
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// a mix close to real suites: one in ten fails with some output, some carry meta
+static void record_suite(std::size_t count) {
+	qase::qase_reporter_reset();
+	qase::qase_reporter_reserve(count);
+
+	for (std::size_t i = 0; i < count; ++i) {
+		const std::string name = "suite_" + std::to_string(i / 100) + "_test_" + std::to_string(i % 100);
+		const bool passed = i % 10 != 0;
+
+		if (i % 4 == 0) {
+			qase::QaseResultMeta meta;
+			meta.title = "Synthetic case " + std::to_string(i);
+			meta.fields["layer"] = "unit";
+			meta.fields["priority"] = i % 8 == 0 ? "high" : "low";
+			qase::qase_reporter_add_result(name, passed, std::move(meta));
+		} else {
+			qase::qase_reporter_add_result(name, passed);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::size_t results = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+	const int batch_size = argc > 2 ? std::atoi(argv[2]) : 200;
+	const int workers = argc > 3 ? std::max(1, std::atoi(argv[3])) : 1;
+
+	qase::QaseMockServerOptions options;
+	options.latency = std::chrono::milliseconds(argc > 4 ? std::atoi(argv[4]) : 0);
+	options.error_rate = argc > 5 ? std::atof(argv[5]) : 0;
+	options.throttle_rate = argc > 6 ? std::atof(argv[6]) : 0;
+
+	try {
+		qase::QaseMockServer server(options);
+
+		qase::QaseConfig cfg;
+		cfg.host = server.host();
+		cfg.token = "load-harness";
+		cfg.project = "LOAD";
+		cfg.batch_size = batch_size;
+		cfg.upload_workers = workers;
+
+		const auto record_start = std::chrono::steady_clock::now();
+		record_suite(results);
+		const double record_seconds = seconds_since(record_start);
+		const long recorded_rss = peak_rss_kb();
+
+		const auto submit_start = std::chrono::steady_clock::now();
+		std::string failure;
+		try {
+			if (workers > 1) {
+				auto transport = std::make_shared<qase::QaseCurlTransport>();
+				qase::QaseApi api;
+				qase::qase_submit_report(api, [transport] {
+					return std::make_unique<qase::QaseCurlHttpClient>(transport);
+				}, cfg);
+			} else {
+				qase::QaseCurlHttpClient http;
+				qase::qase_reporter_finish(http, cfg);
+			}
+		} catch (const std::exception& e) {
+			failure = e.what();
+		}
+		const double submit_seconds = seconds_since(submit_start);
+
+		std::printf("%zu results, batch %d, %d worker(s), %lld ms latency, %.3f errors, %.3f throttled\n",
+			results, batch_size, workers, static_cast<long long>(options.latency.count()),
+			options.error_rate, options.throttle_rate);
+		std::printf("  record:  %8.3f s  %12.0f results/s\n", record_seconds, results / record_seconds);
+		std::printf("  submit:  %8.3f s  %12.0f results/s\n", submit_seconds, results / submit_seconds);
+		std::printf("  server:  %zu results in %zu bulk requests, %zu injected errors, %zu throttled, %zu connections\n",
+			server.results_received(), server.bulk_requests(), server.errors_injected(),
+			server.requests_throttled(), server.connections());
+		std::printf("  peak RSS: %ld KiB after recording, %ld KiB overall\n", recorded_rss, peak_rss_kb());
+		if (!failure.empty()) {
+			std::printf("  submission failed: %s\n", failure.c_str());
+			return 1;
+		}
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "qase_load_harness: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+// minimal HTTP/1.1 server on 127.0.0.1, a stand-in for the Qase API in tests and benchmarks
+// every connection gets its own thread and is kept alive until the client closes it;
+// bodies need a Content-Length
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace qase {
+
+	struct LoopbackRequest {
+		std::string method;
+		std::string path;
+		// raw "Name: value" lines
+		std::vector<std::string> headers;
+		std::string body;
+
+		// value of a header, case-insensitive name; empty if missing
+		std::string header(const std::string& name) const {
+			for (const auto& line : headers) {
+				if (line.size() > name.size() && line[name.size()] == ':' &&
+						strncasecmp(line.c_str(), name.c_str(), name.size()) == 0) {
+					std::size_t start = line.find_first_not_of(' ', name.size() + 1);
+					return start == std::string::npos ? std::string() : line.substr(start);
+				}
+			}
+			return {};
+		}
+	};
+
+	struct LoopbackResponse {
+		int status = 200;
+		std::vector<std::string> headers;
+		std::string body;
+
+		// held back this long before the response is sent
+		std::chrono::milliseconds delay{0};
+	};
+
+	class QaseLoopbackServer {
+	public:
+		using Handler = std::function<LoopbackResponse(const LoopbackRequest&)>;
+
+		// handlers run on connection threads, concurrently
+		explicit QaseLoopbackServer(Handler handler) : handler_(std::move(handler)) {
+			listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+			int one = 1;
+			setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+			sockaddr_in addr = {};
+			addr.sin_family = AF_INET;
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			addr.sin_port = 0;
+			if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+					listen(listen_fd_, 512) != 0) {
+				close(listen_fd_);
+				throw std::runtime_error("Could not listen on the loopback interface");
+			}
+
+			socklen_t len = sizeof(addr);
+			getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len);
+			port_ = ntohs(addr.sin_port);
+
+			acceptor_ = std::thread([this] { accept_loop(); });
+		}
+
+		~QaseLoopbackServer() {
+			stopping_ = true;
+			shutdown(listen_fd_, SHUT_RDWR);
+			acceptor_.join();
+			close(listen_fd_);
+
+			// the acceptor is gone, so the list only changes in the fields guarded by mutex_
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				for (auto& connection : connections_) {
+					if (connection.fd >= 0) {
+						shutdown(connection.fd, SHUT_RDWR);
+					}
+				}
+			}
+			for (auto& connection : connections_) {
+				connection.thread.join();
+			}
+		}
+
+		QaseLoopbackServer(const QaseLoopbackServer&) = delete;
+		QaseLoopbackServer& operator=(const QaseLoopbackServer&) = delete;
+
+		uint16_t port() const { return port_; }
+
+		// "127.0.0.1:<port>", to be used as the API host
+		std::string host() const { return "127.0.0.1:" + std::to_string(port_); }
+		std::string url(const std::string& path) const { return "http://" + host() + path; }
+
+		std::size_t connections() const { return connections_accepted_.load(); }
+		std::size_t requests() const { return requests_served_.load(); }
+
+	private:
+		// fd and finished are guarded by mutex_; the connection thread closes its fd when
+		// the client is done, the acceptor joins finished threads
+		struct Connection {
+			int fd;
+			std::thread thread;
+			bool finished = false;
+		};
+
+		// joins and drops the connections whose thread is done, called with mutex_ held
+		void reap_finished() {
+			for (auto it = connections_.begin(); it != connections_.end();) {
+				if (it->finished) {
+					it->thread.join();
+					it = connections_.erase(it);
+				} else {
+					++it;
+				}
+			}
+		}
+
+		void accept_loop() {
+			while (!stopping_) {
+				int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+				if (fd < 0) {
+					if (errno == EINTR || errno == ECONNABORTED) {
+						continue;
+					}
+					break;
+				}
+				int one = 1;
+				setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+				++connections_accepted_;
+
+				std::lock_guard<std::mutex> lock(mutex_);
+				reap_finished();
+				connections_.push_back({fd, std::thread()});
+				Connection* connection = &connections_.back();
+				connection->thread = std::thread([this, connection] {
+					serve(connection->fd);
+
+					std::lock_guard<std::mutex> lock(mutex_);
+					close(connection->fd);
+					connection->fd = -1;
+					connection->finished = true;
+				});
+			}
+		}
+
+		static bool send_all(int fd, const std::string& data) {
+			std::size_t sent = 0;
+			while (sent < data.size()) {
+				ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+				if (n < 0 && errno == EINTR) {
+					continue;
+				}
+				if (n <= 0) {
+					return false;
+				}
+				sent += static_cast<std::size_t>(n);
+			}
+			return true;
+		}
+
+		static const char* reason(int status) {
+			switch (status) {
+				case 200: return "OK";
+				case 400: return "Bad Request";
+				case 404: return "Not Found";
+				case 429: return "Too Many Requests";
+				case 500: return "Internal Server Error";
+				case 503: return "Service Unavailable";
+				default: return "Status";
+			}
+		}
+
+		// serves requests of one keep-alive connection until the client closes it
+		void serve(int fd) {
+			std::string buffer;
+			char chunk[16 * 1024];
+
+			while (!stopping_) {
+				std::size_t header_end;
+				while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+					ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+					if (n <= 0) {
+						return;
+					}
+					buffer.append(chunk, static_cast<std::size_t>(n));
+				}
+
+				LoopbackRequest request;
+				std::size_t line_end = buffer.find("\r\n");
+				const std::string request_line = buffer.substr(0, line_end);
+				std::size_t space = request_line.find(' ');
+				request.method = request_line.substr(0, space);
+				request.path = request_line.substr(space + 1, request_line.rfind(' ') - space - 1);
+
+				std::size_t pos = line_end + 2;
+				while (pos < header_end) {
+					std::size_t next = buffer.find("\r\n", pos);
+					request.headers.push_back(buffer.substr(pos, next - pos));
+					pos = next + 2;
+				}
+
+				const std::string length = request.header("Content-Length");
+				const std::size_t body_size = length.empty() ? 0 : std::stoul(length);
+				buffer.erase(0, header_end + 4);
+				while (buffer.size() < body_size) {
+					ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+					if (n <= 0) {
+						return;
+					}
+					buffer.append(chunk, static_cast<std::size_t>(n));
+				}
+				request.body = buffer.substr(0, body_size);
+				buffer.erase(0, body_size);
+
+				LoopbackResponse response = handler_(request);
+				++requests_served_;
+
+				// slept in slices, so a delayed response doesn't hold up the shutdown
+				const auto until = std::chrono::steady_clock::now() + response.delay;
+				while (!stopping_ && std::chrono::steady_clock::now() < until) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(5));
+				}
+
+				std::string out = "HTTP/1.1 " + std::to_string(response.status) + " " + reason(response.status) + "\r\n";
+				out += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+				for (const auto& header : response.headers) {
+					out += header + "\r\n";
+				}
+				out += "\r\n";
+				out += response.body;
+				if (!send_all(fd, out)) {
+					return;
+				}
+			}
+		}
+
+		Handler handler_;
+		int listen_fd_ = -1;
+		uint16_t port_ = 0;
+		std::thread acceptor_;
+		std::atomic<bool> stopping_{false};
+
+		std::mutex mutex_;
+		std::list<Connection> connections_;
+
+		std::atomic<std::size_t> connections_accepted_{0};
+		std::atomic<std::size_t> requests_served_{0};
+	};
+
+}
@@ -0,0 +1,160 @@
+#pragma once
+
+// in-process stand-in for the Qase API on 127.0.0.1: run/start, result/bulk and run/complete,
+// with injected latency, server errors and throttling; point cfg.host at host() to use it
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "qase_loopback_server.h"
+
+namespace qase {
+
+	struct QaseMockServerOptions {
+		// added to every response
+		std::chrono::milliseconds latency{0};
+
+		// shares of requests answered with 500, or with 429 and Retry-After
+		double error_rate = 0;
+		double throttle_rate = 0;
+		int retry_after_seconds = 0;
+
+		// faults are drawn from a seeded generator, so a sequential run is reproducible
+		uint32_t seed = 1;
+	};
+
+	class QaseMockServer {
+	public:
+		explicit QaseMockServer(QaseMockServerOptions options = {})
+			: options_(options), random_(options.seed),
+			  server_([this](const LoopbackRequest& request) { return handle(request); }) {}
+
+		// "http://127.0.0.1:<port>", a host with a scheme is used as is by QaseApi
+		std::string host() const { return "http://" + server_.host(); }
+
+		std::size_t runs_started() const { return runs_started_.load(); }
+		std::size_t runs_completed() const { return runs_completed_.load(); }
+		std::size_t bulk_requests() const { return bulk_requests_.load(); }
+		std::size_t results_received() const { return results_received_.load(); }
+		std::size_t errors_injected() const { return errors_injected_.load(); }
+		std::size_t requests_throttled() const { return requests_throttled_.load(); }
+		std::size_t connections() const { return server_.connections(); }
+
+	private:
+		enum class Fault { none, error, throttle };
+
+		Fault draw_fault() {
+			std::lock_guard<std::mutex> lock(mutex_);
+			const double roll = std::uniform_real_distribution<double>(0, 1)(random_);
+			if (roll < options_.error_rate) {
+				return Fault::error;
+			}
+			if (roll < options_.error_rate + options_.throttle_rate) {
+				return Fault::throttle;
+			}
+			return Fault::none;
+		}
+
+		static LoopbackResponse json_response(int status, const nlohmann::json& body) {
+			LoopbackResponse response;
+			response.status = status;
+			response.headers = {"Content-Type: application/json"};
+			response.body = body.dump();
+			return response;
+		}
+
+		static LoopbackResponse error_response(int status, const std::string& message) {
+			return json_response(status, {{"status", false}, {"errorMessage", message}});
+		}
+
+		// splits "/v1/result/DEMO/7/bulk" into {"result", "DEMO", "7", "bulk"}
+		static std::vector<std::string> path_segments(const std::string& path) {
+			std::vector<std::string> segments;
+			std::size_t start = path.rfind("/v1/", 0) == 0 ? 4 : 1;
+			while (start <= path.size()) {
+				std::size_t end = path.find('/', start);
+				if (end == std::string::npos) {
+					end = path.size();
+				}
+				segments.push_back(path.substr(start, end - start));
+				start = end + 1;
+			}
+			return segments;
+		}
+
+		LoopbackResponse handle(const LoopbackRequest& request) {
+			LoopbackResponse response = route(request);
+			response.delay = options_.latency;
+			return response;
+		}
+
+		LoopbackResponse route(const LoopbackRequest& request) {
+			if (request.method != "POST" || request.header("Token").empty()) {
+				return error_response(400, "Token is required");
+			}
+
+			switch (draw_fault()) {
+				case Fault::error:
+					++errors_injected_;
+					return error_response(500, "Internal server error");
+				case Fault::throttle: {
+					++requests_throttled_;
+					LoopbackResponse response = error_response(429, "Too many requests");
+					response.headers.push_back("Retry-After: " + std::to_string(options_.retry_after_seconds));
+					return response;
+				}
+				case Fault::none:
+					break;
+			}
+
+			const std::vector<std::string> path = path_segments(request.path);
+
+			// run/<project>
+			if (path.size() == 2 && path[0] == "run") {
+				const uint64_t id = ++runs_started_;
+				return json_response(200, {{"status", true}, {"result", {{"id", id}}}});
+			}
+
+			// result/<project>/<run>/bulk
+			if (path.size() == 4 && path[0] == "result" && path[3] == "bulk") {
+				nlohmann::json payload = nlohmann::json::parse(request.body, nullptr, false);
+				if (payload.is_discarded() || !payload.contains("results") || !payload["results"].is_array()) {
+					return error_response(400, "Invalid results payload");
+				}
+				++bulk_requests_;
+				results_received_ += payload["results"].size();
+				return json_response(200, {{"status", true}});
+			}
+
+			// run/<project>/<run>/complete
+			if (path.size() == 4 && path[0] == "run" && path[3] == "complete") {
+				++runs_completed_;
+				return json_response(200, {{"status", true}});
+			}
+
+			return error_response(404, "Not found");
+		}
+
+		QaseMockServerOptions options_;
+		std::mutex mutex_;
+		std::mt19937 random_;
+
+		std::atomic<std::size_t> runs_started_{0};
+		std::atomic<std::size_t> runs_completed_{0};
+		std::atomic<std::size_t> bulk_requests_{0};
+		std::atomic<std::size_t> results_received_{0};
+		std::atomic<std::size_t> errors_injected_{0};
+		std::atomic<std::size_t> requests_throttled_{0};
+
+		// last member: its threads call handle() until it's destroyed
+		QaseLoopbackServer server_;
+	};
+
+}
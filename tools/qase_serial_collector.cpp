@@ -0,0 +1,79 @@
+// host-side collector for the serial result protocol
+//
+// usage: qase_serial_collector <device|file|-> [config.json] [baud]
+//
+// reads the frames a device emits with QASE_UNITY_END_SERIAL from a serial port,
+// a pty, a capture file or stdin ("-"), and submits the results to Qase in batches
+// config is resolved from the optional file and QASE_* environment variables
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "qase_curl_http_client.h"
+#include "qase_reporter.h"
+
+static speed_t baud_constant(long baud) {
+	switch (baud) {
+		case 9600: return B9600;
+		case 57600: return B57600;
+		case 230400: return B230400;
+		case 460800: return B460800;
+		case 921600: return B921600;
+		default: return B115200;
+	}
+}
+
+// puts a serial port or pty into raw mode, so no byte of the stream is translated
+static void make_raw(int fd, long baud) {
+	struct termios tio;
+	if (tcgetattr(fd, &tio) != 0) {
+		return; // not a terminal: pipe or regular file
+	}
+	cfmakeraw(&tio);
+	cfsetispeed(&tio, baud_constant(baud));
+	cfsetospeed(&tio, baud_constant(baud));
+	tcsetattr(fd, TCSANOW, &tio);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::fprintf(stderr, "usage: %s <device|file|-> [config.json] [baud]\n", argv[0]);
+		return 2;
+	}
+
+	const std::string source = argv[1];
+	const long baud = argc > 3 ? std::atol(argv[3]) : 115200;
+
+	try {
+		qase::ConfigResolutionInput input;
+		input.env_prefix = "QASE_";
+		if (argc > 2) {
+			input.file = argv[2];
+		}
+		qase::QaseConfig cfg = qase::resolve_config(input);
+
+		int fd = source == "-" ? STDIN_FILENO : open(source.c_str(), O_RDONLY | O_NOCTTY);
+		if (fd < 0) {
+			std::perror(source.c_str());
+			return 1;
+		}
+		make_raw(fd, baud);
+
+		qase::QaseCurlHttpClient http;
+		qase::QaseApi api;
+		qase::qase_serial_collect(fd, api, http, cfg);
+
+		if (fd != STDIN_FILENO) {
+			close(fd);
+		}
+	} catch (const std::exception& e) {
+		std::fprintf(stderr, "qase_serial_collector: %s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}